@@ -0,0 +1,445 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Ixm42xxxDriver_HL.h"
+#include "InvError.h"
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxExtFunc.h"
+#include "iim42652_sim.h"
+#include "sim_platform.h"
+
+/*
+ * inv_ixm42xxx_get_data_from_fifo() 端到端耗时，拆成三段：
+ *   bus      - serif read_reg/write_reg 内部耗时（回放传输层，只有 memcpy 级别的开销）
+ *   callback - sensor_event_cb 内部耗时
+ *   decode   - 其余部分：FIFO 解析、事件组装、驱动逻辑
+ * 另外按总线速率估算线上传输时间（wire），不计入实测值。
+ *
+ * 驱动先在仿真器上完成初始化和传感器启动，然后把 serif 切换到回放传输层，
+ * 每次读取都返回同一份 FIFO 镜像，保证每次测量的输入完全一致。
+ */
+
+#define BENCH_WARMUP            32
+#define BENCH_DEFAULT_ITER      1000
+#define BENCH_MAX_READ          (IXM42XXX_FIFO_BURST_HEADER_SIZE + IXM42XXX_FIFO_MIRRORING_SIZE)
+
+/* 线上时间模型：每个事务的固定字节数、每字节位数、时钟频率 */
+struct bench_bus {
+    const char *name;
+    IXM42XXX_SERIAL_IF_TYPE_t type;
+    uint32_t clock_hz;
+    uint8_t bits_per_byte;      // I2C/I3C 每字节带 ACK/T 位
+    uint8_t read_overhead;      // 读事务额外字节：SPI 地址 / I2C 地址+寄存器+重复起始地址
+    uint8_t write_overhead;
+};
+
+static const struct bench_bus bench_buses[] = {
+    { "spi", IXM42XXX_UI_SPI4, 24000000, 8, 1, 1 },
+    { "i2c", IXM42XXX_UI_I2C,   1000000, 9, 3, 2 },
+    { "i3c", IXM42XXX_UI_I3C,  12500000, 9, 3, 2 },
+};
+
+/* 回放传输层：bank 0 寄存器快照 + FIFO 镜像，每次 drain 前倒带 */
+struct bench_replay {
+    uint8_t regs[IIM42652_SIM_BANK_SIZE];
+    uint8_t fifo[IXM42XXX_FIFO_MIRRORING_SIZE];
+    uint32_t fifo_len;
+    uint32_t fifo_pos;
+    uint16_t count;
+    const struct bench_bus *bus;
+    uint32_t transactions;
+    uint64_t bus_ns;
+    uint64_t wire_ns;
+};
+
+struct bench_stage {
+    uint32_t *samples;
+    uint32_t p50, p99, max;
+};
+
+enum { STAGE_TOTAL, STAGE_BUS, STAGE_DECODE, STAGE_CALLBACK, STAGE_COUNT };
+static const char *const stage_names[STAGE_COUNT] = { "total", "bus", "decode", "callback" };
+
+struct bench_result {
+    const char *bus;
+    uint8_t packet_size;
+    const char *drain;
+    uint16_t packets;
+    uint32_t iterations;
+    struct bench_stage stage[STAGE_COUNT];
+    uint32_t wire_ns;
+    uint32_t transactions;
+};
+
+static struct inv_ixm42xxx sensor_driver;
+static struct iim42652_sim sim;
+static struct inv_ixm42xxx_serif sim_serif;
+static struct bench_replay replay;
+static uint64_t callback_ns;
+static volatile int32_t callback_sink;
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_wire(struct bench_replay *r, uint32_t len, uint8_t overhead)
+{
+    r->wire_ns += (uint64_t)(len + overhead) * r->bus->bits_per_byte * 1000000000ULL / r->bus->clock_hz;
+    r->transactions++;
+}
+
+static int bench_replay_read(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len)
+{
+    struct bench_replay *r = (struct bench_replay *)serif->context;
+    uint64_t t0 = bench_now_ns();
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        switch (reg) {
+        case MPUREG_FIFO_COUNTH:
+            buf[i] = (uint8_t)r->count;     // 驱动配置为小端记录数
+            break;
+        case MPUREG_FIFO_COUNTL:
+            buf[i] = (uint8_t)(r->count >> 8);
+            break;
+        case MPUREG_FIFO_DATA:
+            buf[i] = (r->fifo_pos < r->fifo_len) ? r->fifo[r->fifo_pos++] : IIM42652_SIM_FIFO_EMPTY_BYTE;
+            break;
+        default:
+            buf[i] = r->regs[reg & (IIM42652_SIM_BANK_SIZE - 1)];
+            break;
+        }
+        if (reg != MPUREG_FIFO_DATA)
+            reg++;
+    }
+    bench_wire(r, len, r->bus->read_overhead);
+    r->bus_ns += bench_now_ns() - t0;
+    return INV_ERROR_SUCCESS;
+}
+
+static int bench_replay_write(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len)
+{
+    struct bench_replay *r = (struct bench_replay *)serif->context;
+    uint64_t t0 = bench_now_ns();
+
+    (void)reg;
+    (void)buf;
+    bench_wire(r, len, r->bus->write_overhead);
+    r->bus_ns += bench_now_ns() - t0;
+    return INV_ERROR_SUCCESS;
+}
+
+static void bench_put16(uint8_t *dst, int16_t v, uint8_t big_endian)
+{
+    if (big_endian) {
+        dst[0] = (uint8_t)((uint16_t)v >> 8);
+        dst[1] = (uint8_t)v;
+    } else {
+        dst[0] = (uint8_t)v;
+        dst[1] = (uint8_t)((uint16_t)v >> 8);
+    }
+}
+
+/* 构造 count 个 accel+gyro+timestamp 包，布局与 FIFO_CONFIG1 配置一致 */
+static void bench_build_fifo(struct bench_replay *r, uint16_t count, uint8_t packet_size, uint8_t big_endian)
+{
+    uint16_t n;
+    int k;
+
+    for (n = 0; n < count; n++) {
+        uint8_t *p = &r->fifo[n * packet_size];
+        uint8_t idx = FIFO_HEADER_SIZE;
+
+        p[0] = FIFO_HEADER_ACC | FIFO_HEADER_GYRO | FIFO_HEADER_TMST;
+        if (packet_size == FIFO_20BYTES_PACKET_SIZE)
+            p[0] |= FIFO_HEADER_HEADER_20;
+        for (k = 0; k < 3; k++, idx += 2)
+            bench_put16(&p[idx], (int16_t)(n * 3 + k - 2048), big_endian);
+        for (k = 0; k < 3; k++, idx += 2)
+            bench_put16(&p[idx], (int16_t)(k - n * 5), big_endian);
+        if (packet_size == FIFO_20BYTES_PACKET_SIZE) {
+            bench_put16(&p[idx], 662, big_endian);
+            idx += 2;
+        } else {
+            p[idx++] = 10;
+        }
+        bench_put16(&p[idx], (int16_t)(n * 125), big_endian);
+        idx += 2;
+        if (packet_size == FIFO_20BYTES_PACKET_SIZE) {
+            for (k = 0; k < 3; k++)
+                p[idx++] = (uint8_t)(((n + k) & 0xF) << 4 | ((n - k) & 0xF));
+        }
+    }
+    r->count = count;
+    r->fifo_len = (uint32_t)count * packet_size;
+}
+
+static void handle_fifo_data(inv_ixm42xxx_sensor_event_t *event)
+{
+    uint64_t t0 = bench_now_ns();
+
+    callback_sink += event->accel[0] + event->gyro[2] + event->timestamp_fsync;
+    callback_ns += bench_now_ns() - t0;
+}
+
+static void bench_attach(struct inv_ixm42xxx_serif *serif)
+{
+    sensor_driver.transport.serif.context = serif->context;
+    sensor_driver.transport.serif.read_reg = serif->read_reg;
+    sensor_driver.transport.serif.write_reg = serif->write_reg;
+}
+
+/* 在仿真器上初始化驱动并启动传感器，越过启动丢弃窗口 */
+static int bench_setup(const struct bench_bus *bus, uint8_t high_res, uint32_t max_read)
+{
+    struct iim42652_sim_config cfg;
+    int rc;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.get_time_ns = sim_platform_get_time_ns;
+    iim42652_sim_init(&sim, &cfg);
+    iim42652_sim_bind_serif(&sim, &sim_serif, bus->type);
+    sim_serif.max_read = max_read;
+    sim_serif.max_write = max_read;
+
+    rc = inv_ixm42xxx_init(&sensor_driver, &sim_serif, handle_fifo_data);
+    rc |= inv_ixm42xxx_set_accel_frequency(&sensor_driver, IXM42XXX_ACCEL_CONFIG0_ODR_1_KHZ);
+    rc |= inv_ixm42xxx_set_gyro_frequency(&sensor_driver, IXM42XXX_GYRO_CONFIG0_ODR_1_KHZ);
+    if (high_res)
+        rc |= inv_ixm42xxx_enable_high_resolution_fifo(&sensor_driver);
+    rc |= inv_ixm42xxx_enable_accel_low_noise_mode(&sensor_driver);
+    rc |= inv_ixm42xxx_enable_gyro_low_noise_mode(&sensor_driver);
+    if (rc != INV_ERROR_SUCCESS)
+        return rc;
+
+    inv_ixm42xxx_sleep_us(100000);
+    rc = inv_ixm42xxx_get_data_from_fifo(&sensor_driver);
+    if (rc < 0)
+        return rc;
+
+    iim42652_sim_update(&sim);
+    memcpy(replay.regs, sim.regs[0], sizeof(replay.regs));
+    replay.regs[MPUREG_INT_STATUS] = BIT_INT_STATUS_FIFO_THS | BIT_INT_STATUS_DRDY;
+    replay.bus = bus;
+    return INV_ERROR_SUCCESS;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench_percentiles(struct bench_stage *st, uint32_t n)
+{
+    qsort(st->samples, n, sizeof(uint32_t), cmp_u32);
+    st->p50 = st->samples[n / 2];
+    st->p99 = st->samples[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1];
+    st->max = st->samples[n - 1];
+}
+
+static int bench_point(struct bench_result *res, uint16_t packets, uint32_t iterations)
+{
+    uint32_t i;
+    int rc;
+
+    bench_attach(&sim_serif);
+    rc = inv_ixm42xxx_configure_fifo_wm(&sensor_driver, packets);
+    if (rc != INV_ERROR_SUCCESS)
+        return rc;
+
+    bench_build_fifo(&replay, packets, res->packet_size, sensor_driver.endianess_data == IXM42XXX_INTF_CONFIG0_DATA_BIG_ENDIAN);
+    {
+        struct inv_ixm42xxx_serif replay_serif = sim_serif;
+
+        replay_serif.context = &replay;
+        replay_serif.read_reg = bench_replay_read;
+        replay_serif.write_reg = bench_replay_write;
+        bench_attach(&replay_serif);
+    }
+
+    for (i = 0; i < BENCH_WARMUP + iterations; i++) {
+        uint64_t t0, total;
+
+        replay.fifo_pos = 0;
+        replay.bus_ns = 0;
+        replay.wire_ns = 0;
+        replay.transactions = 0;
+        callback_ns = 0;
+
+        t0 = bench_now_ns();
+        rc = inv_ixm42xxx_get_data_from_fifo(&sensor_driver);
+        total = bench_now_ns() - t0;
+        if (rc != packets)
+            return (rc < 0) ? rc : INV_ERROR;
+
+        if (i >= BENCH_WARMUP) {
+            uint32_t k = i - BENCH_WARMUP;
+
+            res->stage[STAGE_TOTAL].samples[k] = (uint32_t)total;
+            res->stage[STAGE_BUS].samples[k] = (uint32_t)replay.bus_ns;
+            res->stage[STAGE_CALLBACK].samples[k] = (uint32_t)callback_ns;
+            res->stage[STAGE_DECODE].samples[k] = (uint32_t)(total - replay.bus_ns - callback_ns);
+        }
+    }
+
+    for (i = 0; i < STAGE_COUNT; i++)
+        bench_percentiles(&res->stage[i], iterations);
+    res->packets = packets;
+    res->iterations = iterations;
+    res->wire_ns = (uint32_t)replay.wire_ns;
+    res->transactions = replay.transactions;
+    return INV_ERROR_SUCCESS;
+}
+
+static void print_header(FILE *out, int json)
+{
+    int s;
+
+    if (json) {
+        fprintf(out, "[\n");
+        return;
+    }
+    fprintf(out, "bus,packet_bytes,drain,packets,iterations");
+    for (s = 0; s < STAGE_COUNT; s++)
+        fprintf(out, ",%s_p50_ns,%s_p99_ns,%s_max_ns", stage_names[s], stage_names[s], stage_names[s]);
+    fprintf(out, ",wire_ns,transactions\n");
+}
+
+static void print_result(FILE *out, int json, const struct bench_result *res, int first)
+{
+    int s;
+
+    if (json) {
+        fprintf(out, "%s  {\"bus\": \"%s\", \"packet_bytes\": %u, \"drain\": \"%s\", \"packets\": %u, \"iterations\": %u",
+                first ? "" : ",\n", res->bus, res->packet_size, res->drain, res->packets, res->iterations);
+        fprintf(out, ", \"stages\": {");
+        for (s = 0; s < STAGE_COUNT; s++)
+            fprintf(out, "%s\"%s\": {\"p50_ns\": %u, \"p99_ns\": %u, \"max_ns\": %u}", s ? ", " : "",
+                    stage_names[s], res->stage[s].p50, res->stage[s].p99, res->stage[s].max);
+        fprintf(out, "}, \"wire_ns\": %u, \"transactions\": %u}", res->wire_ns, res->transactions);
+        return;
+    }
+    fprintf(out, "%s,%u,%s,%u,%u", res->bus, res->packet_size, res->drain, res->packets, res->iterations);
+    for (s = 0; s < STAGE_COUNT; s++)
+        fprintf(out, ",%u,%u,%u", res->stage[s].p50, res->stage[s].p99, res->stage[s].max);
+    fprintf(out, ",%u,%u\n", res->wire_ns, res->transactions);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-n iterations] [-s step] [-b spi|i2c|i3c] [-m max_read] [-w packet|drain] [-f csv|json] [-o file]\n"
+            "  -w: I2C/I3C interrupt release semi-write after every packet (default) or once per drain\n"
+            "  sweeps 1..%u packets (16 bytes) and 1..%u packets (20 bytes), step 1 by default\n",
+            prog, IXM42XXX_FIFO_MIRRORING_SIZE / FIFO_16BYTES_PACKET_SIZE,
+            IXM42XXX_FIFO_MIRRORING_SIZE / FIFO_20BYTES_PACKET_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = BENCH_DEFAULT_ITER, step = 1, max_read = BENCH_MAX_READ;
+    const char *bus_filter = NULL;
+    INV_IXM42XXX_SEMI_WRITE_MODE_t semi_write = INV_IXM42XXX_SEMI_WRITE_PER_PACKET;
+    FILE *out = stdout;
+    int json = 0, first = 1, opt, s;
+    unsigned b, h, d;
+    struct bench_result res;
+
+    while ((opt = getopt(argc, argv, "n:s:b:m:w:f:o:h")) != -1) {
+        switch (opt) {
+        case 'n': iterations = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': step = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'b': bus_filter = optarg; break;
+        case 'm': max_read = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'w':
+            semi_write = (strcmp(optarg, "drain") == 0) ? INV_IXM42XXX_SEMI_WRITE_PER_DRAIN : INV_IXM42XXX_SEMI_WRITE_PER_PACKET;
+            break;
+        case 'f': json = (strcmp(optarg, "json") == 0); break;
+        case 'o':
+            out = fopen(optarg, "w");
+            if (!out) {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0 || step == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    memset(&res, 0, sizeof(res));
+    for (s = 0; s < STAGE_COUNT; s++) {
+        res.stage[s].samples = malloc(iterations * sizeof(uint32_t));
+        if (!res.stage[s].samples)
+            return 1;
+    }
+
+    print_header(out, json);
+    for (b = 0; b < sizeof(bench_buses) / sizeof(bench_buses[0]); b++) {
+        const struct bench_bus *bus = &bench_buses[b];
+
+        if (bus_filter && strcmp(bus_filter, bus->name) != 0)
+            continue;
+        for (h = 0; h < 2; h++) {
+            uint8_t packet_size = h ? FIFO_20BYTES_PACKET_SIZE : FIFO_16BYTES_PACKET_SIZE;
+            uint16_t packet_max = (uint16_t)(IXM42XXX_FIFO_MIRRORING_SIZE / packet_size);
+
+            for (d = 0; d < 2; d++) {
+                uint16_t n;
+
+                // I3C 总是逐包读取，burst 模式对其无效
+                if (d == INV_IXM42XXX_FIFO_DRAIN_BURST && bus->type == IXM42XXX_UI_I3C)
+                    continue;
+                if (bench_setup(bus, (uint8_t)h, max_read) != INV_ERROR_SUCCESS) {
+                    fprintf(stderr, "%s: driver setup failed\n", bus->name);
+                    return 1;
+                }
+                inv_ixm42xxx_set_fifo_drain_mode(&sensor_driver, (INV_IXM42XXX_FIFO_DRAIN_MODE_t)d);
+                inv_ixm42xxx_set_semi_write_mode(&sensor_driver, semi_write);
+                res.bus = bus->name;
+                res.packet_size = packet_size;
+                res.drain = d ? "burst" : "sequential";
+
+                // 1, 1+step, ... 最后一个点总是 packet_max
+                for (n = 1; ; n = (n + step > packet_max) ? packet_max : (uint16_t)(n + step)) {
+                    int rc = bench_point(&res, n, iterations);
+
+                    if (rc != INV_ERROR_SUCCESS) {
+                        fprintf(stderr, "%s/%u/%s/%u packets: drain failed (%d)\n",
+                                bus->name, packet_size, res.drain, n, rc);
+                        return 1;
+                    }
+                    print_result(out, json, &res, first);
+                    first = 0;
+                    if (n == packet_max)
+                        break;
+                }
+            }
+        }
+    }
+    if (json)
+        fprintf(out, "\n]\n");
+
+    if (out != stdout)
+        fclose(out);
+    for (s = 0; s < STAGE_COUNT; s++)
+        free(res.stage[s].samples);
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * __________________________________________________________________
+ *
+ * Copyright (C) [2022] by InvenSense, Inc.
+ * 
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY  AND FITNESS. IN NO EVENT SHALL
+ * THE AUTHOR BE LIABLE  FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ * __________________________________________________________________
+ */
+
+#include "Ixm42xxxConfig.h"
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxExtFunc.h"
+#include "Ixm42xxxTransport.h"
+#include "InvError.h"
+
+/* Index of each register in inv_ixm42xxx_config_t::sensor_cfg */
+#define CFG_GYRO_CONFIG0       (MPUREG_GYRO_CONFIG0 - MPUREG_GYRO_CONFIG0)
+#define CFG_ACCEL_CONFIG0      (MPUREG_ACCEL_CONFIG0 - MPUREG_GYRO_CONFIG0)
+#define CFG_GYRO_ACCEL_CONFIG0 (MPUREG_GYRO_ACCEL_CONFIG0 - MPUREG_GYRO_CONFIG0)
+
+static int apply_accel_mode(struct inv_ixm42xxx * s, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t mode);
+static int apply_gyro_mode(struct inv_ixm42xxx * s, IXM42XXX_PWR_MGMT_0_GYRO_MODE_t mode);
+static int write_sensor_cfg(struct inv_ixm42xxx * s, inv_ixm42xxx_config_t * cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t accel_mode_cur);
+static int gyro_restart_too_early(struct inv_ixm42xxx * s);
+
+int inv_ixm42xxx_config_begin(struct inv_ixm42xxx * s, inv_ixm42xxx_config_t * cfg)
+{
+	int status = 0;
+	uint8_t data[1 + IXM42XXX_CONFIG_SENSOR_REG_COUNT];
+	int i;
+
+	/* PWR_MGMT_0 is followed by GYRO_CONFIG0 .. ACCEL_CONFIG1 */
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_PWR_MGMT_0, sizeof(data), data);
+	if(status)
+		return status;
+
+	cfg->pwr_mgmt0 = cfg->pwr_mgmt0_cur = data[0];
+	for(i = 0; i < IXM42XXX_CONFIG_SENSOR_REG_COUNT; i++)
+		cfg->sensor_cfg[i] = cfg->sensor_cfg_cur[i] = data[1 + i];
+
+	return status;
+}
+
+void inv_ixm42xxx_config_set_accel_fsr(inv_ixm42xxx_config_t * cfg, IXM42XXX_ACCEL_CONFIG0_FS_SEL_t accel_fsr_g)
+{
+	cfg->sensor_cfg[CFG_ACCEL_CONFIG0] &= (uint8_t)~BIT_ACCEL_CONFIG0_FS_SEL_MASK;
+	cfg->sensor_cfg[CFG_ACCEL_CONFIG0] |= (uint8_t)accel_fsr_g;
+}
+
+void inv_ixm42xxx_config_set_gyro_fsr(inv_ixm42xxx_config_t * cfg, IXM42XXX_GYRO_CONFIG0_FS_SEL_t gyro_fsr_dps)
+{
+	cfg->sensor_cfg[CFG_GYRO_CONFIG0] &= (uint8_t)~BIT_GYRO_CONFIG0_FS_SEL_MASK;
+	cfg->sensor_cfg[CFG_GYRO_CONFIG0] |= (uint8_t)gyro_fsr_dps;
+}
+
+void inv_ixm42xxx_config_set_accel_frequency(inv_ixm42xxx_config_t * cfg, const IXM42XXX_ACCEL_CONFIG0_ODR_t frequency)
+{
+	cfg->sensor_cfg[CFG_ACCEL_CONFIG0] &= (uint8_t)~BIT_ACCEL_CONFIG0_ODR_MASK;
+	cfg->sensor_cfg[CFG_ACCEL_CONFIG0] |= (uint8_t)frequency;
+}
+
+void inv_ixm42xxx_config_set_gyro_frequency(inv_ixm42xxx_config_t * cfg, const IXM42XXX_GYRO_CONFIG0_ODR_t frequency)
+{
+	cfg->sensor_cfg[CFG_GYRO_CONFIG0] &= (uint8_t)~BIT_GYRO_CONFIG0_ODR_MASK;
+	cfg->sensor_cfg[CFG_GYRO_CONFIG0] |= (uint8_t)frequency;
+}
+
+void inv_ixm42xxx_config_set_accel_mode(inv_ixm42xxx_config_t * cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t mode)
+{
+	cfg->pwr_mgmt0 &= (uint8_t)~BIT_PWR_MGMT_0_ACCEL_MODE_MASK;
+	cfg->pwr_mgmt0 |= (uint8_t)mode;
+}
+
+void inv_ixm42xxx_config_set_gyro_mode(inv_ixm42xxx_config_t * cfg, IXM42XXX_PWR_MGMT_0_GYRO_MODE_t mode)
+{
+	cfg->pwr_mgmt0 &= (uint8_t)~BIT_PWR_MGMT_0_GYRO_MODE_MASK;
+	cfg->pwr_mgmt0 |= (uint8_t)mode;
+}
+
+int inv_ixm42xxx_config_commit(struct inv_ixm42xxx * s, inv_ixm42xxx_config_t * cfg)
+{
+	int status = 0;
+	IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t accel_mode_cur, accel_mode;
+	IXM42XXX_PWR_MGMT_0_GYRO_MODE_t  gyro_mode_cur, gyro_mode;
+	uint8_t was_on, will_be_on;
+	uint8_t data;
+
+	accel_mode_cur = (IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t)(cfg->pwr_mgmt0_cur & BIT_PWR_MGMT_0_ACCEL_MODE_MASK);
+	gyro_mode_cur  = (IXM42XXX_PWR_MGMT_0_GYRO_MODE_t)(cfg->pwr_mgmt0_cur & BIT_PWR_MGMT_0_GYRO_MODE_MASK);
+	accel_mode = (IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t)(cfg->pwr_mgmt0 & BIT_PWR_MGMT_0_ACCEL_MODE_MASK);
+	gyro_mode  = (IXM42XXX_PWR_MGMT_0_GYRO_MODE_t)(cfg->pwr_mgmt0 & BIT_PWR_MGMT_0_GYRO_MODE_MASK);
+
+	/* Gyro proof mass needs > 150ms to settle after power-off, refuse before touching anything */
+	if((gyro_mode == IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN) && (gyro_mode_cur == IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF)
+	   && gyro_restart_too_early(s))
+		return INV_ERROR_HW;
+
+	/* Accel low power runs from the WU oscillator: switching requires the waits 
+	 * of the per-sensor functions, apply registers first then let them sequence the modes
+	 */
+	if((cfg->pwr_mgmt0 != cfg->pwr_mgmt0_cur) &&
+	   ((accel_mode == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LP) || (accel_mode_cur == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LP))) {
+		status |= write_sensor_cfg(s, cfg, accel_mode_cur);
+		if(accel_mode == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LP) {
+			/* Gyro first so that accel low power is entered with the final gyro state */
+			if(gyro_mode != gyro_mode_cur)
+				status |= apply_gyro_mode(s, gyro_mode);
+			if(accel_mode != accel_mode_cur)
+				status |= apply_accel_mode(s, accel_mode);
+		} else {
+			if(accel_mode != accel_mode_cur)
+				status |= apply_accel_mode(s, accel_mode);
+			if(gyro_mode != gyro_mode_cur)
+				status |= apply_gyro_mode(s, gyro_mode);
+		}
+		status |= inv_ixm42xxx_config_begin(s, cfg);
+		return status;
+	}
+
+	was_on = (accel_mode_cur != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF) || (gyro_mode_cur != IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF);
+	will_be_on = (accel_mode != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF) || (gyro_mode != IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF);
+
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	/* FIFO contains Gyro and Accel data if enabled on the OIS path
+	 * Dynamically configure the FIFO to publish data only for sensors explicitely enabled on the UI path 
+	 */
+	if(!was_on && will_be_on) {
+		if(s->fifo_is_used) {
+			status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_CONFIG1, 1, &data);
+			data |= (uint8_t)IXM42XXX_FIFO_CONFIG1_ACCEL_EN;
+			data |= (uint8_t)IXM42XXX_FIFO_CONFIG1_GYRO_EN;
+			if(s->fifo_highres_enabled)
+				data |= (uint8_t)IXM42XXX_FIFO_CONFIG1_HIRES_EN;
+			status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG1, 1, &data);
+		}
+		/* Read data endianess in order to process correctly data */
+		status |= inv_ixm42xxx_read_reg(s, MPUREG_INTF_CONFIG0, 1, &data);
+		s->endianess_data = data & BIT_DATA_ENDIAN_MASK;
+	}
+#endif
+
+	/* Restore filter BW settings of sensors entering low noise mode, written with the rest of the image */
+	if((accel_mode == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN) && (accel_mode_cur != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN)) {
+		cfg->sensor_cfg[CFG_GYRO_ACCEL_CONFIG0] &= (uint8_t)~BIT_GYRO_ACCEL_CONFIG0_ACCEL_FILT_MASK;
+		cfg->sensor_cfg[CFG_GYRO_ACCEL_CONFIG0] |= s->avg_bw_setting.acc_ln_bw;
+	}
+	if((gyro_mode == IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN) && (gyro_mode_cur != IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN)) {
+		cfg->sensor_cfg[CFG_GYRO_ACCEL_CONFIG0] &= (uint8_t)~BIT_GYRO_ACCEL_CONFIG0_GYRO_FILT_MASK;
+		cfg->sensor_cfg[CFG_GYRO_ACCEL_CONFIG0] |= s->avg_bw_setting.gyr_ln_bw;
+	}
+	status |= write_sensor_cfg(s, cfg, accel_mode_cur);
+
+	/* Power mode goes last so sensors start with their final configuration */
+	if(cfg->pwr_mgmt0 != cfg->pwr_mgmt0_cur) {
+		status |= inv_ixm42xxx_write_reg(s, MPUREG_PWR_MGMT_0, 1, &cfg->pwr_mgmt0);
+		inv_ixm42xxx_sleep_us(200);
+		if(status == 0)
+			cfg->pwr_mgmt0_cur = cfg->pwr_mgmt0;
+	}
+
+	if((gyro_mode_cur != IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF) && (gyro_mode == IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF)) {
+		/* keep track of gyro power-off time to check if gyro will be power-on after more than 150ms*/
+		s->gyro_power_off_tmst = inv_ixm42xxx_get_time_us();
+	}
+
+	if((accel_mode_cur != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF) && (accel_mode == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF)) {
+		/* Restore POR clock source for the accelerometer */
+		status |= inv_ixm42xxx_force_clock_source(s, IXM42XXX_INTF_CONFIG1_ACCEL_LP_CLK_WUOSC);
+	}
+
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	/* First data are noisy after enabling sensor 
+	 * Keeps track of the number of first samples to discard
+	 */
+	if(s->fifo_is_used) {
+		if((accel_mode_cur == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF) && (accel_mode != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF))
+			s->accel_discard_count = inv_ixm42xxx_get_startup_discard_count(cfg->sensor_cfg[CFG_ACCEL_CONFIG0] & BIT_ACCEL_CONFIG0_ODR_MASK,
+			                                                                IXM42XXX_ACC_STARTUP_TIME_US);
+		if((gyro_mode_cur == IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF) && (gyro_mode == IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN))
+			s->gyro_discard_count = inv_ixm42xxx_get_startup_discard_count(cfg->sensor_cfg[CFG_GYRO_CONFIG0] & BIT_GYRO_CONFIG0_ODR_MASK,
+			                                                               IXM42XXX_GYR_STARTUP_TIME_US);
+	}
+
+	if(was_on && !will_be_on && s->fifo_is_used) {
+		/* First FSYNC event after enable is irrelevant */
+		s->fsync_to_be_ignored = 1;
+
+		status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_CONFIG1, 1, &data);
+		data &= (uint8_t)~(BIT_FIFO_CONFIG1_ACCEL_MASK | BIT_FIFO_CONFIG1_GYRO_MASK | BIT_FIFO_CONFIG1_HIRES_MASK);
+		status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG1, 1, &data);
+
+		/* Reset FIFO explicitely so the new configuration is taken into account */
+		status |= inv_ixm42xxx_reset_fifo(s);
+	}
+#endif
+
+	return status;
+}
+
+static int apply_accel_mode(struct inv_ixm42xxx * s, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t mode)
+{
+	switch(mode) {
+	case IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN: return inv_ixm42xxx_enable_accel_low_noise_mode(s);
+	case IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LP: return inv_ixm42xxx_enable_accel_low_power_mode(s);
+	case IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF: return inv_ixm42xxx_disable_accel(s);
+	default: return INV_ERROR_BAD_ARG;
+	}
+}
+
+static int apply_gyro_mode(struct inv_ixm42xxx * s, IXM42XXX_PWR_MGMT_0_GYRO_MODE_t mode)
+{
+	int status = 0;
+	uint8_t pwr_mngt_0_reg;
+
+	switch(mode) {
+	case IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN: return inv_ixm42xxx_enable_gyro_low_noise_mode(s);
+	case IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF: return inv_ixm42xxx_disable_gyro(s);
+	case IXM42XXX_PWR_MGMT_0_GYRO_MODE_STANDBY:
+		/* No dedicated function, drive keeps running so no sequencing is required */
+		status |= inv_ixm42xxx_read_reg(s, MPUREG_PWR_MGMT_0, 1, &pwr_mngt_0_reg);
+		pwr_mngt_0_reg &= (uint8_t)~BIT_PWR_MGMT_0_GYRO_MODE_MASK;
+		pwr_mngt_0_reg |= (uint8_t)IXM42XXX_PWR_MGMT_0_GYRO_MODE_STANDBY;
+		status |= inv_ixm42xxx_write_reg(s, MPUREG_PWR_MGMT_0, 1, &pwr_mngt_0_reg);
+		inv_ixm42xxx_sleep_us(200);
+		return status;
+	default: return INV_ERROR_BAD_ARG;
+	}
+}
+
+/* Write the span of GYRO_CONFIG0 .. ACCEL_CONFIG1 that changed as a single burst */
+static int write_sensor_cfg(struct inv_ixm42xxx * s, inv_ixm42xxx_config_t * cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t accel_mode_cur)
+{
+	int status = 0;
+	int first = -1, last = -1;
+	int i;
+
+	for(i = 0; i < IXM42XXX_CONFIG_SENSOR_REG_COUNT; i++) {
+		if(cfg->sensor_cfg[i] != cfg->sensor_cfg_cur[i]) {
+			if(first < 0)
+				first = i;
+			last = i;
+		}
+	}
+	if(first < 0)
+		return 0;
+
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	/* Same accounting as inv_ixm42xxx_set_accel_frequency(): an ODR change made while
+	 * the WU oscillator is not running could be missed by accel low power mode
+	 */
+	if((cfg->sensor_cfg[CFG_ACCEL_CONFIG0] ^ cfg->sensor_cfg_cur[CFG_ACCEL_CONFIG0]) & BIT_ACCEL_CONFIG0_ODR_MASK) {
+		if(IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LP != accel_mode_cur)
+			s->wu_off_acc_odr_changes++;
+		else
+			s->wu_off_acc_odr_changes = 0;
+		/* Start-up samples left were counted at the previous ODR */
+		if(s->accel_discard_count)
+			s->accel_discard_count = inv_ixm42xxx_rescale_startup_discard_count(s->accel_discard_count,
+			                                                                    cfg->sensor_cfg_cur[CFG_ACCEL_CONFIG0] & BIT_ACCEL_CONFIG0_ODR_MASK,
+			                                                                    cfg->sensor_cfg[CFG_ACCEL_CONFIG0] & BIT_ACCEL_CONFIG0_ODR_MASK);
+	}
+	if(s->gyro_discard_count && ((cfg->sensor_cfg[CFG_GYRO_CONFIG0] ^ cfg->sensor_cfg_cur[CFG_GYRO_CONFIG0]) & BIT_GYRO_CONFIG0_ODR_MASK))
+		s->gyro_discard_count = inv_ixm42xxx_rescale_startup_discard_count(s->gyro_discard_count,
+		                                                                   cfg->sensor_cfg_cur[CFG_GYRO_CONFIG0] & BIT_GYRO_CONFIG0_ODR_MASK,
+		                                                                   cfg->sensor_cfg[CFG_GYRO_CONFIG0] & BIT_GYRO_CONFIG0_ODR_MASK);
+#else
+	(void)accel_mode_cur;
+#endif
+
+	status |= inv_ixm42xxx_write_reg(s, (uint8_t)(MPUREG_GYRO_CONFIG0 + first), (uint32_t)(last - first + 1), &cfg->sensor_cfg[first]);
+	if(status == 0) {
+		for(i = first; i <= last; i++)
+			cfg->sensor_cfg_cur[i] = cfg->sensor_cfg[i];
+	}
+
+	return status;
+}
+
+static int gyro_restart_too_early(struct inv_ixm42xxx * s)
+{
+	uint64_t current_time;
+
+	if (s->gyro_power_off_tmst == UINT32_MAX)
+		return 0;
+
+	current_time = inv_ixm42xxx_get_time_us();
+	/* Handle rollover */
+	if (current_time <= s->gyro_power_off_tmst)
+		current_time += UINT32_MAX;
+
+	return ((current_time - s->gyro_power_off_tmst) <= (150 * 1000));
+}
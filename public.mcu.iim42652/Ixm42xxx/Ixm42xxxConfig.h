@@ -0,0 +1,104 @@
+/*
+ * __________________________________________________________________
+ *
+ * Copyright (C) [2022] by InvenSense, Inc.
+ * 
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY  AND FITNESS. IN NO EVENT SHALL
+ * THE AUTHOR BE LIABLE  FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ * __________________________________________________________________
+ */
+
+/** @defgroup DriverIxm42xxxConfig Ixm42xxx staged configuration
+ *  @brief Stage FSR, ODR and power mode changes and apply them in one pass
+ *  @ingroup  DriverIxm42xxx
+ *  @{
+ */
+
+/** @file Ixm42xxxConfig.h
+ * Stage FSR, ODR and power mode changes and apply them in one pass
+ */
+
+#ifndef _INV_IXM42XXX_CONFIG_H_
+#define _INV_IXM42XXX_CONFIG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "Ixm42xxxDriver_HL.h"
+
+#include <stdint.h>
+
+/** @brief Number of contiguous sensor configuration registers, GYRO_CONFIG0 to ACCEL_CONFIG1 */
+#define IXM42XXX_CONFIG_SENSOR_REG_COUNT 5
+
+/** @brief Staged register image
+ *  @details
+ *  Setters only edit the image, no bus access is done before inv_ixm42xxx_config_commit().
+ *  sensor_cfg[] follows the register map: GYRO_CONFIG0, ACCEL_CONFIG0, GYRO_CONFIG1, 
+ *  GYRO_ACCEL_CONFIG0, ACCEL_CONFIG1.
+ */
+typedef struct {
+	uint8_t pwr_mgmt0;                                         /**< staged PWR_MGMT_0 */
+	uint8_t sensor_cfg[IXM42XXX_CONFIG_SENSOR_REG_COUNT];      /**< staged GYRO_CONFIG0 .. ACCEL_CONFIG1 */
+	uint8_t pwr_mgmt0_cur;                                     /**< PWR_MGMT_0 when the transaction began */
+	uint8_t sensor_cfg_cur[IXM42XXX_CONFIG_SENSOR_REG_COUNT];  /**< GYRO_CONFIG0 .. ACCEL_CONFIG1 when the transaction began */
+} inv_ixm42xxx_config_t;
+
+/** @brief Start a configuration transaction from the current device state
+ *  @param[out] cfg  staged image, loaded from PWR_MGMT_0 to ACCEL_CONFIG1 in a single read
+ *  @return 0 on success, negative value on error.
+ */
+int inv_ixm42xxx_config_begin(struct inv_ixm42xxx * s, inv_ixm42xxx_config_t * cfg);
+
+/** @brief Stage accelerometer full scale range */
+void inv_ixm42xxx_config_set_accel_fsr(inv_ixm42xxx_config_t * cfg, IXM42XXX_ACCEL_CONFIG0_FS_SEL_t accel_fsr_g);
+
+/** @brief Stage gyroscope full scale range */
+void inv_ixm42xxx_config_set_gyro_fsr(inv_ixm42xxx_config_t * cfg, IXM42XXX_GYRO_CONFIG0_FS_SEL_t gyro_fsr_dps);
+
+/** @brief Stage accelerometer ODR */
+void inv_ixm42xxx_config_set_accel_frequency(inv_ixm42xxx_config_t * cfg, const IXM42XXX_ACCEL_CONFIG0_ODR_t frequency);
+
+/** @brief Stage gyroscope ODR */
+void inv_ixm42xxx_config_set_gyro_frequency(inv_ixm42xxx_config_t * cfg, const IXM42XXX_GYRO_CONFIG0_ODR_t frequency);
+
+/** @brief Stage accelerometer power mode: off, low power or low noise */
+void inv_ixm42xxx_config_set_accel_mode(inv_ixm42xxx_config_t * cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t mode);
+
+/** @brief Stage gyroscope power mode: off, standby or low noise */
+void inv_ixm42xxx_config_set_gyro_mode(inv_ixm42xxx_config_t * cfg, IXM42XXX_PWR_MGMT_0_GYRO_MODE_t mode);
+
+/** @brief Apply the staged image
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  Only registers that differ from the image loaded by inv_ixm42xxx_config_begin() are written.
+ *  Changed registers between GYRO_CONFIG0 and ACCEL_CONFIG1 go out as one burst write,
+ *  filter settings of sensors switched to low noise included, then PWR_MGMT_0 is written last.
+ *  Side effects of inv_ixm42xxx_enable_accel_low_noise_mode(), inv_ixm42xxx_enable_gyro_low_noise_mode(), 
+ *  inv_ixm42xxx_disable_accel() and inv_ixm42xxx_disable_gyro() are preserved (FIFO content selection, 
+ *  first sample discard, gyro restart delay).
+ *  Transitions involving accel low power mode need oscillator switching and waits, 
+ *  they are delegated to the per-sensor functions after the burst write.
+ *  INV_ERROR_HW is returned before any write when the gyro is turned on less than 150ms 
+ *  after it was turned off.
+ *  The transaction stays valid after commit: it can be edited and committed again.
+ */
+int inv_ixm42xxx_config_commit(struct inv_ixm42xxx * s, inv_ixm42xxx_config_t * cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _INV_IXM42XXX_CONFIG_H_ */
+
+/** @} */
@@ -22,11 +22,26 @@
 #include "Ixm42xxxDriver_HL.h"
 #include "Ixm42xxxTransport.h"
 #include "Ixm42xxxVersion.h"
+#include "Ixm42xxxFifoDecode.h"
 
 static int inv_ixm42xxx_configure_serial_interface(struct inv_ixm42xxx * s);
 static int inv_ixm42xxx_init_hardware_from_ui(struct inv_ixm42xxx * s);
 static int inv_ixm42xxx_is_wu_osc_active(struct inv_ixm42xxx * s);
 static void inv_ixm42xxx_format_data(const uint8_t endian, const uint8_t *in, uint16_t *out);
+static int inv_ixm42xxx_read_fifo(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t ** buffer, const uint8_t ** fifo, uint16_t * packet_count);
+static int inv_ixm42xxx_read_fifo_released(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t ** buffer, const uint8_t ** fifo, uint16_t * packet_count);
+static int inv_ixm42xxx_read_fifo_into(struct inv_ixm42xxx * s, uint8_t * buf, uint32_t buf_size, const uint8_t ** fifo, uint16_t * packet_count);
+static int inv_ixm42xxx_read_fifo_burst(struct inv_ixm42xxx * s, uint8_t * buf, uint32_t buf_size, const uint8_t ** fifo, uint16_t * packet_count);
+static int inv_ixm42xxx_read_fifo_bytes(struct inv_ixm42xxx * s, uint8_t * buf, uint32_t buf_size, const uint8_t ** fifo, uint16_t * packet_count);
+static uint16_t inv_ixm42xxx_parse_fifo_bytes(struct inv_ixm42xxx * s, uint8_t * fifo, uint32_t counted, uint32_t total);
+static int inv_ixm42xxx_update_fifo_lost(struct inv_ixm42xxx * s);
+static int inv_ixm42xxx_notify_fifo_events(struct inv_ixm42xxx * s, const uint8_t * fifo, uint16_t packet_count);
+static uint8_t inv_ixm42xxx_get_uniform_packet_size(const uint8_t * fifo, uint16_t packet_count);
+static void inv_ixm42xxx_decode_uniform_fifo_batch(struct inv_ixm42xxx * s, const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, inv_ixm42xxx_fifo_batch_t * batch);
+static uint32_t inv_ixm42xxx_get_fifo_wm_reg(struct inv_ixm42xxx * s, uint16_t wm);
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+static int inv_ixm42xxx_is_sensor_settled(uint16_t * discard_count);
+#endif
 
 int inv_ixm42xxx_set_reg_bank(struct inv_ixm42xxx * s, uint8_t bank)
 {
@@ -40,6 +55,7 @@ int inv_ixm42xxx_init(struct inv_ixm42xxx * s, struct inv_ixm42xxx_serif * serif
 	memset(s, 0, sizeof(*s));
 	
 	s->transport.serif = *serif;
+	s->fifo_count_rec = IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_RECORD;
 	
 	/* Wait some time for ICM to be properly supplied */
 	inv_ixm42xxx_sleep_us(3000);
@@ -56,13 +72,13 @@ int inv_ixm42xxx_init(struct inv_ixm42xxx * s, struct inv_ixm42xxx_serif * serif
 	status |= inv_ixm42xxx_init_hardware_from_ui(s);
 		
 	/* First data are noisy after enabling sensor
-	 * This variable keeps track of gyro start time. Set to UINT32_MAX at init 
+	 * This variable keeps track of gyro samples left to discard. Set to 0 at init 
 	 */
-	s->gyro_start_time_us = UINT32_MAX;
+	s->gyro_discard_count = 0;
 	/* First data are noisy after enabling sensor
-	 * This variable keeps track of accel start time. Set to UINT32_MAX at init 
+	 * This variable keeps track of accel samples left to discard. Set to 0 at init 
 	 */
-	s->accel_start_time_us = UINT32_MAX;
+	s->accel_discard_count = 0;
 
 	/* Gyro power-off to power-on transition can cause ring down issue
 	 * This variable keeps track of timestamp when gyro is power off. Set to UINT32_MAX at init
@@ -249,10 +265,11 @@ int inv_ixm42xxx_enable_accel_low_power_mode(struct inv_ixm42xxx * s)
 
 	if (accel_mode == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF) {
 		/* First data are noisy after enabling sensor 
-		 * Keeps track of the start time to discard first sample
+		 * Keeps track of the number of first samples to discard
 		 */
 		if(s->fifo_is_used) {
-			s->accel_start_time_us = inv_ixm42xxx_get_time_us();
+			status |= inv_ixm42xxx_read_reg(s, MPUREG_ACCEL_CONFIG0, 1, &accel_cfg_0_reg);
+			s->accel_discard_count = inv_ixm42xxx_get_startup_discard_count(accel_cfg_0_reg & BIT_ACCEL_CONFIG0_ODR_MASK, IXM42XXX_ACC_STARTUP_TIME_US);
 		}
 	}
 #endif
@@ -327,10 +344,11 @@ int inv_ixm42xxx_enable_accel_low_noise_mode(struct inv_ixm42xxx * s)
 #if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
 	if (accel_mode == IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF) {
 		/* First data are noisy after enabling sensor 
-		 * Keeps track of the start time to discard first sample
+		 * Keeps track of the number of first samples to discard
 		 */
 		if(s->fifo_is_used) {
-			s->accel_start_time_us = inv_ixm42xxx_get_time_us();
+			status |= inv_ixm42xxx_read_reg(s, MPUREG_ACCEL_CONFIG0, 1, &accel_cfg_0_reg);
+			s->accel_discard_count = inv_ixm42xxx_get_startup_discard_count(accel_cfg_0_reg & BIT_ACCEL_CONFIG0_ODR_MASK, IXM42XXX_ACC_STARTUP_TIME_US);
 		}
 	}
 #endif
@@ -467,10 +485,12 @@ int inv_ixm42xxx_enable_gyro_low_noise_mode(struct inv_ixm42xxx * s)
 #if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
 	if (gyro_mode == IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF) {
 		/* First data are noisy after enabling sensor 
-		 * Keeps track of the start time to discard first sample
+		 * Keeps track of the number of first samples to discard
 		 */
 		if(s->fifo_is_used) {
-			s->gyro_start_time_us = inv_ixm42xxx_get_time_us();
+			uint8_t gyro_cfg_0_reg;
+			status |= inv_ixm42xxx_read_reg(s, MPUREG_GYRO_CONFIG0, 1, &gyro_cfg_0_reg);
+			s->gyro_discard_count = inv_ixm42xxx_get_startup_discard_count(gyro_cfg_0_reg & BIT_GYRO_CONFIG0_ODR_MASK, IXM42XXX_GYR_STARTUP_TIME_US);
 		}
 	}
 #endif
@@ -570,6 +590,28 @@ int inv_ixm42xxx_disable_fsync(struct inv_ixm42xxx * s)
 	return status;
 }
 
+int inv_ixm42xxx_configure_fsync_tag(struct inv_ixm42xxx * s, IXM42XXX_FSYNC_CONFIG_UI_SEL_t ui_sel)
+{
+	int status = 0;
+	uint8_t value;
+
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_FSYNC_CONFIG, 1, &value);
+	value &= (uint8_t)~BIT_FSYNC_CONFIG_UI_SEL_MASK;
+	value |= (uint8_t)ui_sel;
+	status |= inv_ixm42xxx_write_reg(s, MPUREG_FSYNC_CONFIG, 1, &value);
+
+	if (ui_sel == IXM42XXX_FSYNC_CONFIG_UI_SEL_NO)
+		return status | inv_ixm42xxx_disable_fsync(s);
+
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	/* First FSYNC event after enable is irrelevant */
+	s->fsync_to_be_ignored = 1;
+#endif
+	status |= inv_ixm42xxx_enable_fsync(s);
+
+	return status;
+}
+
 int inv_ixm42xxx_configure_timestamp_resolution(struct inv_ixm42xxx * s, IXM42XXX_TMST_CONFIG_RESOL_t resol)
 {
 	int status = 0;
@@ -728,6 +770,8 @@ int inv_ixm42xxx_set_config_int1(struct inv_ixm42xxx * s, inv_ixm42xxx_interrupt
 	int status = 0;
 	uint8_t data[3] = {0};
 
+	/* Both banks are written once the new values are known */
+	status |= inv_ixm42xxx_begin_bank_batch(s);
 	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_SOURCE0, 2, data); /* burst read int_source0/int_source1 */
 	status |= inv_ixm42xxx_set_reg_bank(s, 4);
 	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_SOURCE6_B4, 1, &data[2]); /* switch to bank4 for int_source6 */
@@ -766,9 +810,10 @@ int inv_ixm42xxx_set_config_int1(struct inv_ixm42xxx * s, inv_ixm42xxx_interrupt
 	data[2] |= ((interrupt_to_configure->INV_IXM42XXX_LOWG_DET != 0)      << BIT_INT_LOWG_DET_INT_EN_POS);
 	data[2] |= ((interrupt_to_configure->INV_IXM42XXX_TAP_DET != 0)       << BIT_INT_TAP_DET_INT_EN_POS);
 	
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE6_B4, 1, &data[2]); /* start with int_source6 since we are still in bank4 */
+	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE6_B4, 1, &data[2]);
 	status |= inv_ixm42xxx_set_reg_bank(s, 0);
 	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE0, 2, data); /* burst write int_source0/int_source1 */
+	status |= inv_ixm42xxx_end_bank_batch(s);
 
 	return status;
 }
@@ -778,6 +823,8 @@ int inv_ixm42xxx_set_config_int2(struct inv_ixm42xxx * s, inv_ixm42xxx_interrupt
 	int status = 0;
 	uint8_t data[3] = {0};
 
+	/* Both banks are written once the new values are known */
+	status |= inv_ixm42xxx_begin_bank_batch(s);
 	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_SOURCE3, 2, data); /* burst read int_source3/int_source4 */
 	status |= inv_ixm42xxx_set_reg_bank(s, 4);
 	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_SOURCE7_B4, 1, &data[2]); /* switch to bank4 for int_source7 */
@@ -816,9 +863,10 @@ int inv_ixm42xxx_set_config_int2(struct inv_ixm42xxx * s, inv_ixm42xxx_interrupt
 	data[2] |= ((interrupt_to_configure->INV_IXM42XXX_LOWG_DET != 0)      << BIT_INT_LOWG_DET_INT_EN_POS);
 	data[2] |= ((interrupt_to_configure->INV_IXM42XXX_TAP_DET != 0)       << BIT_INT_TAP_DET_INT_EN_POS);
 
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE7_B4, 1, &data[2]); /* start with int_source7 since we are still in bank4 */
+	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE7_B4, 1, &data[2]);
 	status |= inv_ixm42xxx_set_reg_bank(s, 0);
 	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE3, 2, data); /* burst write int_source3/int_source4 */
+	status |= inv_ixm42xxx_end_bank_batch(s);
 
 	return status;
 }
@@ -870,15 +918,70 @@ int inv_ixm42xxx_get_data_from_registers(struct inv_ixm42xxx * s)
 	return status;
 }
 
-int inv_ixm42xxx_get_data_from_fifo(struct inv_ixm42xxx * s)
+/* Drain in a free registered buffer if any, otherwise in the embedded mirror. 
+ * *buffer is the registered buffer used, NULL for the embedded mirror.
+ */
+static int inv_ixm42xxx_read_fifo(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t ** buffer, const uint8_t ** fifo, uint16_t * packet_count)
+{
+	inv_ixm42xxx_fifo_buffer_t * buf = s->fifo_free_buffers;
+	int status;
+
+	*buffer = NULL;
+	*fifo = NULL;
+	*packet_count = 0;
+
+	if(buf == NULL) {
+#if (!INV_IXM42XXX_EXTERNAL_FIFO_BUFFER)
+		return inv_ixm42xxx_read_fifo_into(s, s->fifo_data, sizeof(s->fifo_data), fifo, packet_count);
+#else
+		return INV_ERROR_MEM;
+#endif
+	}
+
+	s->fifo_free_buffers = buf->next;
+	buf->next = NULL;
+	status = inv_ixm42xxx_read_fifo_into(s, buf->data, buf->size, fifo, packet_count);
+	buf->fifo = *fifo;
+	buf->packet_count = *packet_count;
+	*buffer = buf;
+
+	return status;
+}
+
+/* Semi-write releasing the interrupt once for the whole drain, see inv_ixm42xxx_set_semi_write_mode() */
+static int inv_ixm42xxx_read_fifo_released(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t ** buffer, const uint8_t ** fifo, uint16_t * packet_count)
+{
+	int status;
+	uint8_t data = 0;
+
+	status = inv_ixm42xxx_read_fifo(s, buffer, fifo, packet_count);
+
+	if((status == 0) && (*packet_count > 0) && (s->semi_write_mode == INV_IXM42XXX_SEMI_WRITE_PER_DRAIN) &&
+	  ((s->transport.serif.serif_type == IXM42XXX_UI_I2C) || (s->transport.serif.serif_type == IXM42XXX_UI_I3C))) {
+		/* Packets are already popped, a failed release only delays the next interrupt */
+		inv_ixm42xxx_write_reg(s, MPUREG_WHO_AM_I, 1, &data);
+	}
+
+	return status;
+}
+
+static int inv_ixm42xxx_read_fifo_into(struct inv_ixm42xxx * s, uint8_t * buf, uint32_t buf_size, const uint8_t ** fifo, uint16_t * packet_count)
 {
 	int status = 0; 
 	uint8_t int_status;
-	uint8_t data_reg = 0;
 	uint8_t data[2];
-	uint16_t packet_count_i, packet_count = 0;
+	uint16_t packet_count_i;
 	uint16_t packet_size = FIFO_HEADER_SIZE + FIFO_ACCEL_DATA_SIZE + FIFO_GYRO_DATA_SIZE + FIFO_TEMP_DATA_SIZE + FIFO_TS_FSYNC_SIZE;
-	fifo_header_t * header;
+
+	*fifo = buf;
+	*packet_count = 0;
+
+	if(s->fifo_count_rec == IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE)
+		return inv_ixm42xxx_read_fifo_bytes(s, buf, buf_size, fifo, packet_count);
+
+	/* I3C keeps reading packet by packet, see below */
+	if((s->fifo_drain_mode == INV_IXM42XXX_FIFO_DRAIN_BURST) && (s->transport.serif.serif_type != IXM42XXX_UI_I3C))
+		return inv_ixm42xxx_read_fifo_burst(s, buf, buf_size, fifo, packet_count);
 
 	/* Ensure data ready status bit is set */
 	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_STATUS, 1, &int_status);
@@ -886,20 +989,23 @@ int inv_ixm42xxx_get_data_from_fifo(struct inv_ixm42xxx * s)
 		return status;
 
 	if((int_status & BIT_INT_STATUS_FIFO_THS) || (int_status & BIT_INT_STATUS_FIFO_FULL)) {
+
+		if(int_status & BIT_INT_STATUS_FIFO_FULL)
+			status |= inv_ixm42xxx_update_fifo_lost(s);
 		
 		/* FIFO record mode configured at driver init, so we read packet number, not byte count */
 		status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_COUNTH, 2, data);
 		if(status != INV_ERROR_SUCCESS)
 			return status;
-		inv_ixm42xxx_format_data(IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN, data, &packet_count);
+		inv_ixm42xxx_format_data(IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN, data, packet_count);
 
-		if (packet_count > 0) {
+		if (*packet_count > 0) {
 			/* Read FIFO only when data is expected in FIFO */
-			/* fifo_idx type variable must be large enough to parse the FIFO_MIRRORING_SIZE */
-			uint16_t fifo_idx = 0;
-
 			if(s->fifo_highres_enabled)
 				packet_size = FIFO_20BYTES_PACKET_SIZE;
+			/* Packets that do not fit in buffer are left in FIFO for the next drain */
+			if(*packet_count > buf_size / packet_size)
+				*packet_count = (uint16_t)(buf_size / packet_size);
 
 			if(s->transport.serif.serif_type == IXM42XXX_UI_I3C) {
 				/* in case of I3C, need to read packet by packet since INT is embedded on protocol so this can 
@@ -909,8 +1015,8 @@ int inv_ixm42xxx_get_data_from_fifo(struct inv_ixm42xxx * s)
 				- read packet by packet
 				2nd solution prefered here because less heavy from driver point of view but it is less optimal
 				for the timing because we have to initiate N transactions in any case */
-				for(packet_count_i = 0 ; packet_count_i < packet_count ; packet_count_i++) {
-					status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_DATA, packet_size, &s->fifo_data[packet_count_i*packet_size]);
+				for(packet_count_i = 0 ; packet_count_i < *packet_count ; packet_count_i++) {
+					status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_DATA, packet_size, &buf[packet_count_i*packet_size]);
 					if(status) {
 						/* sensor data is in FIFO according to FIFO_COUNT but failed to read FIFO,
 							  reset FIFO and try next chance */
@@ -919,165 +1025,753 @@ int inv_ixm42xxx_get_data_from_fifo(struct inv_ixm42xxx * s)
 					}
 				}
 			} else {
-				status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_DATA, packet_size * packet_count, s->fifo_data);
-				if(status) {
-					/* sensor data is in FIFO according to FIFO_COUNT but failed to read FIFO,
-						  reset FIFO and try next chance */
-					inv_ixm42xxx_reset_fifo(s);
-					return status;
+				/* Transactions are limited to max_read bytes, split them on packet boundaries */
+				uint16_t packet_chunk = (uint16_t)(s->transport.serif.max_read / packet_size);
+				if(packet_chunk == 0)
+					packet_chunk = 1;
+				for(packet_count_i = 0 ; packet_count_i < *packet_count ; packet_count_i += packet_chunk) {
+					uint16_t chunk = *packet_count - packet_count_i;
+					if(chunk > packet_chunk)
+						chunk = packet_chunk;
+					status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_DATA, packet_size * chunk, &buf[packet_count_i*packet_size]);
+					if(status) {
+						/* sensor data is in FIFO according to FIFO_COUNT but failed to read FIFO,
+							  reset FIFO and try next chance */
+						inv_ixm42xxx_reset_fifo(s);
+						return status;
+					}
 				}
 			}
-			
-			for(packet_count_i = 0; packet_count_i < packet_count; packet_count_i++) {
-				inv_ixm42xxx_sensor_event_t event;
-				event.sensor_mask = 0;
-				
-				header = (fifo_header_t *) &s->fifo_data[fifo_idx];
-				fifo_idx += FIFO_HEADER_SIZE;
-				
-				/* Decode packet */
-				if (header->bits.msg_bit) {
-					/* MSG BIT set in FIFO header, Resetting FIFO */
-					inv_ixm42xxx_reset_fifo(s);
-					return INV_ERROR;
-				}
+		}
+		/*else: packet_count was 0*/
+	}
+	/*else: FIFO threshold was not reached and FIFO was not full*/
 
-				if(header->bits.accel_bit) {
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[0+fifo_idx], (uint16_t *)&event.accel[0]);
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[2+fifo_idx], (uint16_t *)&event.accel[1]);
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[4+fifo_idx], (uint16_t *)&event.accel[2]);
-					fifo_idx += FIFO_ACCEL_DATA_SIZE;
-				}
+	return status;
+}
 
-				if (header->bits.gyro_bit) {
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[0+fifo_idx], (uint16_t *)&event.gyro[0]);
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[2+fifo_idx], (uint16_t *)&event.gyro[1]);
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[4+fifo_idx], (uint16_t *)&event.gyro[2]);
-					fifo_idx += FIFO_GYRO_DATA_SIZE;
-				}
+static int inv_ixm42xxx_read_fifo_burst(struct inv_ixm42xxx * s, uint8_t * buf, uint32_t buf_size, const uint8_t ** fifo, uint16_t * packet_count)
+{
+	int status = 0;
+	uint8_t * fifo_payload = &buf[IXM42XXX_FIFO_BURST_HEADER_SIZE];
+	uint16_t count = 0, packet_read, packet_extra = 0;
+	uint16_t packet_size = FIFO_16BYTES_PACKET_SIZE;
+	uint16_t packet_max;
 
-				if ((header->bits.accel_bit) || (header->bits.gyro_bit)) {
-					if(header->bits.twentybits_bit) {
-						inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[0+fifo_idx], (uint16_t *)&event.temperature);
-						fifo_idx += FIFO_TEMP_DATA_SIZE + FIFO_TEMP_HIGH_RES_SIZE;
-
-						/* new temperature data */
-						if (event.temperature != INVALID_VALUE_FIFO)
-							event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_TEMPERATURE);
-					} else {
-						event.temperature = (int8_t)s->fifo_data[0+fifo_idx]; /* cast to int8_t since FIFO is in 16 bits mode (temperature on 8 bits) */
-						fifo_idx += FIFO_TEMP_DATA_SIZE;
-
-						/* new temperature data */
-						if (event.temperature != INVALID_VALUE_FIFO_1B)
-							event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_TEMPERATURE);
-					}
-				}
+	*fifo = fifo_payload;
+	*packet_count = 0;
 
-				if ((header->bits.timestamp_bit) || (header->bits.fsync_bit)) {
-					inv_ixm42xxx_format_data(s->endianess_data, &s->fifo_data[0+fifo_idx], (uint16_t *)&event.timestamp_fsync);
-					fifo_idx += FIFO_TS_FSYNC_SIZE;
-					
-					/* new fsync event */
-					/* First FSYNC event after enable is irrelevant
-					 * FSYNC tag and FSYNC data should be ignored on the first ODR after restart.
-					 */
-					if (header->bits.fsync_bit){
-						#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
-						if(s->fsync_to_be_ignored == 0)
-						#endif
-							event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_FSYNC_EVENT);
-					}
-					#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
-					s->fsync_to_be_ignored = 0;
-					#endif
-				}
-				
-				if (header->bits.accel_bit) {
-					if( (event.accel[0] != INVALID_VALUE_FIFO) &&
-					    (event.accel[1] != INVALID_VALUE_FIFO) &&
-					    (event.accel[2] != INVALID_VALUE_FIFO) ) {
-
-						if (header->bits.twentybits_bit) {
-							event.accel_high_res[0] = (s->fifo_data[0+fifo_idx] >> 4) & 0xF;
-							event.accel_high_res[1] = (s->fifo_data[1+fifo_idx] >> 4) & 0xF;
-							event.accel_high_res[2] = (s->fifo_data[2+fifo_idx] >> 4) & 0xF;
-						}
+	if(s->fifo_highres_enabled)
+		packet_size = FIFO_20BYTES_PACKET_SIZE;
+
+	/* INT_STATUS, FIFO_COUNTH, FIFO_COUNTL and FIFO_DATA are contiguous (0x2D..0x30) so status, 
+	 * count and the first packets can be read in a single transaction. 
+	 * The speculative payload is sized to the watermark: when drain is triggered by FIFO_THS 
+	 * interrupt, FIFO holds at least that many packets so nothing is read past the FIFO content.
+	 */
+	packet_max = (uint16_t)((buf_size - IXM42XXX_FIFO_BURST_HEADER_SIZE) / packet_size);
+	packet_read = s->fifo_wm;
+	if(packet_read > packet_max)
+		packet_read = packet_max;
+	if(((uint32_t)IXM42XXX_FIFO_BURST_HEADER_SIZE + (uint32_t)packet_read * packet_size) > s->transport.serif.max_read) {
+		/* With a bus shorter than the header plus one packet, only status and count are read first */
+		if(s->transport.serif.max_read > IXM42XXX_FIFO_BURST_HEADER_SIZE)
+			packet_read = (uint16_t)((s->transport.serif.max_read - IXM42XXX_FIFO_BURST_HEADER_SIZE) / packet_size);
+		else
+			packet_read = 0;
+	}
+
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_STATUS, IXM42XXX_FIFO_BURST_HEADER_SIZE + packet_read * packet_size, buf);
+	if(status) {
+		/* FIFO may have been partially read, reset FIFO and try next chance */
+		inv_ixm42xxx_reset_fifo(s);
+		return status;
+	}
+	/* INT_STATUS is in buf[0]. Unlike the sequential drain, FIFO content is decoded 
+	 * regardless of FIFO_THS/FIFO_FULL since the payload has already been popped.
+	 */
+	if(buf[0] & BIT_INT_STATUS_FIFO_FULL)
+		inv_ixm42xxx_update_fifo_lost(s); /* payload is already popped, loss report is best effort */
+
+	/* FIFO record mode configured at driver init, so we read packet number, not byte count */
+	inv_ixm42xxx_format_data(IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN, &buf[1], &count);
+	if(count > packet_max)
+		count = packet_max;
+
+	if(count > packet_read) {
+		/* FIFO holds more than expected, read the remaining packets */
+		uint32_t remaining = (uint32_t)(count - packet_read) * packet_size;
+		uint32_t offset = (uint32_t)packet_read * packet_size;
+
+		while(remaining > 0) {
+			uint32_t chunk = (remaining > s->transport.serif.max_read) ? s->transport.serif.max_read : remaining;
+			status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_DATA, chunk, &fifo_payload[offset]);
+			if(status) {
+				inv_ixm42xxx_reset_fifo(s);
+				return status;
+			}
+			offset += chunk;
+			remaining -= chunk;
+		}
+	} else if(count < packet_read) {
+		/* Speculative payload went past FIFO_COUNT. Packets pushed after count was latched are
+		 * valid and kept, up to the first empty FIFO header (MSG bit set).
+		 */
+		while((count + packet_extra) < packet_read) {
+			const fifo_header_t * header = (const fifo_header_t *)&fifo_payload[(count + packet_extra) * packet_size];
+			if(header->bits.msg_bit || !(header->bits.accel_bit || header->bits.gyro_bit)) {
+				/* FIFO was read while empty, a packet pushed during this read may have been 
+				 * partially popped so flush FIFO to restart on a packet boundary
+				 */
+				status |= inv_ixm42xxx_reset_fifo(s);
+				break;
+			}
+			packet_extra++;
+		}
+	}
+
+	*packet_count = count + packet_extra;
 
+	return status;
+}
+
+static int inv_ixm42xxx_read_fifo_bytes(struct inv_ixm42xxx * s, uint8_t * buf, uint32_t buf_size, const uint8_t ** fifo, uint16_t * packet_count)
+{
+	int status = 0;
+	uint8_t * fifo_payload = &buf[IXM42XXX_FIFO_BURST_HEADER_SIZE];
+	uint8_t int_status;
+	uint8_t data[2];
+	uint16_t count;
+	uint16_t packet_size = FIFO_16BYTES_PACKET_SIZE;
+	uint32_t carry_len = s->fifo_carry_len;
+	uint32_t space, read_len, offset, chunk;
+
+	/* Carried bytes are copied in front of the new ones, so payload always starts after the burst header */
+	*fifo = fifo_payload;
+	*packet_count = 0;
+
+	if(s->fifo_highres_enabled)
+		packet_size = FIFO_20BYTES_PACKET_SIZE;
+
+	/* Room left for new bytes, at least one as buffers hold a full packet */
+	space = buf_size - IXM42XXX_FIFO_BURST_HEADER_SIZE - carry_len;
+
+	if((s->fifo_drain_mode == INV_IXM42XXX_FIFO_DRAIN_BURST) && (s->transport.serif.serif_type != IXM42XXX_UI_I3C)) {
+		/* Same single transaction as the record mode burst drain. It is started carry_len bytes 
+		 * into the buffer so that new bytes directly follow the carried ones.
+		 */
+		read_len = (uint32_t)s->fifo_wm * packet_size;
+		if(read_len > space)
+			read_len = space;
+		if(((uint32_t)IXM42XXX_FIFO_BURST_HEADER_SIZE + read_len) > s->transport.serif.max_read) {
+			if(s->transport.serif.max_read > IXM42XXX_FIFO_BURST_HEADER_SIZE)
+				read_len = s->transport.serif.max_read - IXM42XXX_FIFO_BURST_HEADER_SIZE;
+			else
+				read_len = 0;
+		}
+
+		status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_STATUS, IXM42XXX_FIFO_BURST_HEADER_SIZE + read_len, &buf[carry_len]);
+		if(status) {
+			/* Number of bytes popped is unknown, next drain resynchronizes on packet headers */
+			s->fifo_carry_len = 0;
+			s->fifo_synced = 0;
+			return status;
+		}
+		int_status = buf[carry_len];
+		inv_ixm42xxx_format_data(IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN, &buf[carry_len + 1], &count);
+	} else {
+		status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_STATUS, 1, &int_status);
+		if(status)
+			return status;
+		if(!(int_status & (BIT_INT_STATUS_FIFO_THS | BIT_INT_STATUS_FIFO_FULL)))
+			return status;
+
+		status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_COUNTH, 2, data);
+		if(status)
+			return status;
+		inv_ixm42xxx_format_data(IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN, data, &count);
+		read_len = 0;
+	}
+
+	if(int_status & BIT_INT_STATUS_FIFO_FULL)
+		inv_ixm42xxx_update_fifo_lost(s);
+
+	/* Read counted bytes not covered yet, bytes that do not fit are left in FIFO for the next drain */
+	offset = carry_len + read_len;
+	if(count > read_len) {
+		uint32_t remaining = count - read_len;
+
+		if(remaining > (space - read_len))
+			remaining = space - read_len;
+		while(remaining > 0) {
+			chunk = (remaining > s->transport.serif.max_read) ? s->transport.serif.max_read : remaining;
+			status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_DATA, chunk, &fifo_payload[offset]);
+			if(status) {
+				s->fifo_carry_len = 0;
+				s->fifo_synced = 0;
+				return status;
+			}
+			offset += chunk;
+			remaining -= chunk;
+		}
+	}
+
+	memcpy(fifo_payload, s->fifo_carry, carry_len);
+
+	/* Bytes up to FIFO_COUNT are FIFO content, a burst may have read further */
+	if(count < read_len)
+		*packet_count = inv_ixm42xxx_parse_fifo_bytes(s, fifo_payload, carry_len + count, offset);
+	else
+		*packet_count = inv_ixm42xxx_parse_fifo_bytes(s, fifo_payload, offset, offset);
+
+	return status;
+}
+
+/* 16 and 20 bytes packets always hold accel, gyro and a timestamp or FSYNC field: only ODR change and FSYNC bits vary */
+#define FIFO_BYTES_IS_HEADER(h, hires) \
+	(((h) & (FIFO_HEADER_MSG | FIFO_HEADER_ACC | FIFO_HEADER_GYRO | FIFO_HEADER_HEADER_20 | FIFO_HEADER_TMST)) == \
+	 (FIFO_HEADER_ACC | FIFO_HEADER_GYRO | FIFO_HEADER_TMST | ((hires) ? FIFO_HEADER_HEADER_20 : 0)))
+
+/* Every packet from rd to the end of the counted bytes starts with a header */
+static uint8_t inv_ixm42xxx_is_fifo_aligned(const uint8_t * fifo, uint32_t rd, uint32_t counted, uint16_t packet_size, uint8_t hires)
+{
+	for(; rd < counted; rd += packet_size) {
+		if(!FIFO_BYTES_IS_HEADER(fifo[rd], hires))
+			return 0;
+	}
+	return 1;
+}
+
+/* Byte count mode FIFO parser.
+ * Whole packets are compacted at the start of fifo, a packet cut by the end of the counted bytes is saved 
+ * for the next drain and bytes that cannot start a packet are skipped. 
+ * Out of sync, i.e. after a skip or a failed read, a header is only trusted if all following packets 
+ * line up. The timestamp MSB goes through header values for a while and lines up as well: it sits 
+ * tmst_to_header bytes before a real header, so a candidate is dropped when that position lines up too.
+ * A packet cut before it could be checked is carried and checked again by the next drain.
+ * Bytes between counted and total were read past FIFO_COUNT by a burst drain: packets pushed during 
+ * the read are kept up to the first empty header, as in record mode. A packet partially popped by this
+ * read is carried as well.
+ */
+static uint16_t inv_ixm42xxx_parse_fifo_bytes(struct inv_ixm42xxx * s, uint8_t * fifo, uint32_t counted, uint32_t total)
+{
+	uint8_t hires = s->fifo_highres_enabled;
+	uint16_t packet_size = hires ? FIFO_20BYTES_PACKET_SIZE : FIFO_16BYTES_PACKET_SIZE;
+	uint16_t tmst_to_header = FIFO_TS_FSYNC_SIZE + (hires ? FIFO_ACCEL_GYRO_HIGH_RES_SIZE : 0);
+	uint32_t rd = 0, wr = 0;
+	uint8_t synced = s->fifo_synced;
+	uint16_t count = 0;
+
+	s->fifo_carry_len = 0;
+
+	while(rd < counted) {
+		if(FIFO_BYTES_IS_HEADER(fifo[rd], hires) && (synced ||
+		  (inv_ixm42xxx_is_fifo_aligned(fifo, rd, counted, packet_size, hires) && 
+		   !((rd + tmst_to_header < counted) && inv_ixm42xxx_is_fifo_aligned(fifo, rd + tmst_to_header, counted, packet_size, hires))))) {
+			if(rd + packet_size > counted)
+				break;
+			if(wr != rd)
+				memmove(&fifo[wr], &fifo[rd], packet_size);
+			wr += packet_size;
+			rd += packet_size;
+			count++;
+			synced = 1;
+		} else {
+			s->fifo_resync_bytes++;
+			rd++;
+			synced = 0;
+		}
+	}
+
+	while(synced && (rd + packet_size <= total) && FIFO_BYTES_IS_HEADER(fifo[rd], hires)) {
+		if(wr != rd)
+			memmove(&fifo[wr], &fifo[rd], packet_size);
+		wr += packet_size;
+		rd += packet_size;
+		count++;
+	}
+	/* FIFO read position is not known after bytes past FIFO_COUNT were popped */
+	if((rd >= counted) && (rd < total))
+		synced = 0;
+
+	/* End of packet is still in FIFO */
+	if((rd < total) && FIFO_BYTES_IS_HEADER(fifo[rd], hires) && (rd + packet_size > total)) {
+		s->fifo_carry_len = (uint8_t)(total - rd);
+		memcpy(s->fifo_carry, &fifo[rd], s->fifo_carry_len);
+	}
+	s->fifo_synced = synced;
+
+	return count;
+}
+
+static int inv_ixm42xxx_update_fifo_lost(struct inv_ixm42xxx * s)
+{
+	int status = 0;
+	uint8_t data[2];
+	uint16_t lost;
+
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_FIFO_LOST_PKT0, 2, data);
+	if(status)
+		return status;
+
+	lost = (uint16_t)(data[0] | (data[1] << 8));
+	/* Counter restarts from 0 when cleared by the device */
+	if(lost >= s->fifo_lost_pkt)
+		s->fifo_lost_packets += lost - s->fifo_lost_pkt;
+	else
+		s->fifo_lost_packets += lost;
+	s->fifo_lost_pkt = lost;
+
+	return status;
+}
+
+int inv_ixm42xxx_decode_fifo_batch(struct inv_ixm42xxx * s, const uint8_t * fifo, uint16_t packet_count, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	/* fifo_idx type variable must be large enough to parse the FIFO_MIRRORING_SIZE */
+	uint16_t fifo_idx = 0;
+	uint16_t packet_count_i;
+	uint16_t packet_decoded = packet_count;
+	uint8_t packet_size;
+	const fifo_header_t * header;
+
+	batch->count = 0;
+	batch->high_res = 0;
+
+	if(packet_decoded > batch->capacity)
+		packet_decoded = batch->capacity;
+
+	/* Nominal case: accel + gyro + timestamp packets with identical headers are decoded by the 
+	 * fixed-layout (vectorized when available) decoder */
+	packet_size = inv_ixm42xxx_get_uniform_packet_size(fifo, packet_decoded);
+	if(packet_size)
+		inv_ixm42xxx_decode_uniform_fifo_batch(s, fifo, packet_decoded, packet_size, batch);
+
+	/* Otherwise packets are decoded one by one according to their header */
+	for(packet_count_i = batch->count; packet_count_i < packet_decoded; packet_count_i++) {
+		uint16_t sensor_mask = 0;
+		uint16_t timestamp_fsync = 0;
+		int16_t temperature = 0;
+		int16_t accel[3] = {0, 0, 0};
+		int16_t gyro[3] = {0, 0, 0};
+		
+		header = (const fifo_header_t *) &fifo[fifo_idx];
+		fifo_idx += FIFO_HEADER_SIZE;
+		if (packet_count_i == 0)
+			batch->high_res = header->bits.twentybits_bit;
+		
+		/* Decode packet */
+		if (header->bits.msg_bit) {
+			/* MSG BIT set in FIFO header, Resetting FIFO */
+			if(!s->fifo_decode_detached)
+				inv_ixm42xxx_reset_fifo(s);
+			return INV_ERROR;
+		}
+
+		/* All packets of a burst share the same format, a change means FIFO is not parsed on packet boundaries */
+		if ((packet_count_i > 0) && (header->bits.twentybits_bit != batch->high_res)) {
+			if(!s->fifo_decode_detached)
+				inv_ixm42xxx_reset_fifo(s);
+			return INV_ERROR;
+		}
+
+		if(header->bits.accel_bit) {
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[0+fifo_idx], (uint16_t *)&accel[0]);
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[2+fifo_idx], (uint16_t *)&accel[1]);
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[4+fifo_idx], (uint16_t *)&accel[2]);
+			fifo_idx += FIFO_ACCEL_DATA_SIZE;
+		}
+
+		if (header->bits.gyro_bit) {
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[0+fifo_idx], (uint16_t *)&gyro[0]);
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[2+fifo_idx], (uint16_t *)&gyro[1]);
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[4+fifo_idx], (uint16_t *)&gyro[2]);
+			fifo_idx += FIFO_GYRO_DATA_SIZE;
+		}
+
+		if ((header->bits.accel_bit) || (header->bits.gyro_bit)) {
+			if(header->bits.twentybits_bit) {
+				inv_ixm42xxx_format_data(s->endianess_data, &fifo[0+fifo_idx], (uint16_t *)&temperature);
+				fifo_idx += FIFO_TEMP_DATA_SIZE + FIFO_TEMP_HIGH_RES_SIZE;
+
+				/* new temperature data */
+				if (temperature != INVALID_VALUE_FIFO)
+					sensor_mask |= (1 << INV_IXM42XXX_SENSOR_TEMPERATURE);
+			} else {
+				temperature = (int8_t)fifo[0+fifo_idx]; /* cast to int8_t since FIFO is in 16 bits mode (temperature on 8 bits) */
+				fifo_idx += FIFO_TEMP_DATA_SIZE;
+
+				/* new temperature data */
+				if (temperature != INVALID_VALUE_FIFO_1B)
+					sensor_mask |= (1 << INV_IXM42XXX_SENSOR_TEMPERATURE);
+			}
+		}
+
+		if ((header->bits.timestamp_bit) || (header->bits.fsync_bit)) {
+			inv_ixm42xxx_format_data(s->endianess_data, &fifo[0+fifo_idx], &timestamp_fsync);
+			fifo_idx += FIFO_TS_FSYNC_SIZE;
+			
+			/* new fsync event */
+			/* First FSYNC event after enable is irrelevant
+			 * FSYNC tag and FSYNC data should be ignored on the first ODR after restart.
+			 */
+			if (header->bits.fsync_bit){
+				#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+				if(s->fsync_to_be_ignored == 0)
+				#endif
+					sensor_mask |= (1 << INV_IXM42XXX_SENSOR_FSYNC_EVENT);
+			}
+			#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+			s->fsync_to_be_ignored = 0;
+			#endif
+		}
+		
+		if (header->bits.accel_bit) {
+			/* Every sample produced counts towards the start-up time, valid or not */
 #if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
-						if (s->accel_start_time_us == UINT32_MAX) {
-							event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_ACCEL);
-						} else {
-							if (!header->bits.fsync_bit) {
-								/* First data are noisy after enabling sensor
-								 * Compare start time with current time to notify the event
-								 */
-								if((inv_ixm42xxx_get_time_us() - s->accel_start_time_us) >= IXM42XXX_ACC_STARTUP_TIME_US) {
-									s->accel_start_time_us = UINT32_MAX;
-									event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_ACCEL);
-								}
-							}
-						}
+			int accel_settled = inv_ixm42xxx_is_sensor_settled(&s->accel_discard_count);
 #else
-						event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_ACCEL);
+			int accel_settled = 1;
 #endif
-					}
-				}
-				
-				if (header->bits.gyro_bit) {
-					if( (event.gyro[0] != INVALID_VALUE_FIFO) &&
-					    (event.gyro[1] != INVALID_VALUE_FIFO) &&
-					    (event.gyro[2] != INVALID_VALUE_FIFO) ) {
-
-						if (header->bits.twentybits_bit) {
-							event.gyro_high_res[0] = (s->fifo_data[0+fifo_idx]) & 0xF;
-							event.gyro_high_res[1] = (s->fifo_data[1+fifo_idx]) & 0xF;
-							event.gyro_high_res[2] = (s->fifo_data[2+fifo_idx]) & 0xF;
-						}
-
+			if( (accel[0] != INVALID_VALUE_FIFO) &&
+			    (accel[1] != INVALID_VALUE_FIFO) &&
+			    (accel[2] != INVALID_VALUE_FIFO) && accel_settled ) {
+				sensor_mask |= (1 << INV_IXM42XXX_SENSOR_ACCEL);
+			}
+		}
+		
+		if (header->bits.gyro_bit) {
 #if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
-						if (s->gyro_start_time_us == UINT32_MAX) {
-							event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_GYRO);
-						} else {
-							if (!header->bits.fsync_bit) {
-								/* First data are noisy after enabling sensor
-								 * Compare start time with current time to notify the event
-								 */
-								if((inv_ixm42xxx_get_time_us() - s->gyro_start_time_us) >= IXM42XXX_GYR_STARTUP_TIME_US) {
-									s->gyro_start_time_us = UINT32_MAX;
-									event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_GYRO);
-								}
-							}
-						}
+			int gyro_settled = inv_ixm42xxx_is_sensor_settled(&s->gyro_discard_count);
 #else
-						event.sensor_mask |= (1 << INV_IXM42XXX_SENSOR_GYRO);
+			int gyro_settled = 1;
 #endif
-					}
-				}
+			if( (gyro[0] != INVALID_VALUE_FIFO) &&
+			    (gyro[1] != INVALID_VALUE_FIFO) &&
+			    (gyro[2] != INVALID_VALUE_FIFO) && gyro_settled ) {
+				sensor_mask |= (1 << INV_IXM42XXX_SENSOR_GYRO);
+			}
+		}
 
-				if (header->bits.twentybits_bit)
-					fifo_idx += FIFO_ACCEL_GYRO_HIGH_RES_SIZE;
+		if (header->bits.twentybits_bit) {
+			/* Merge 4 LSB: accel in upper nibble, gyro in lower nibble */
+			batch->accel[0][packet_count_i] = (int32_t)accel[0] * 16 + ((fifo[0+fifo_idx] >> 4) & 0xF);
+			batch->accel[1][packet_count_i] = (int32_t)accel[1] * 16 + ((fifo[1+fifo_idx] >> 4) & 0xF);
+			batch->accel[2][packet_count_i] = (int32_t)accel[2] * 16 + ((fifo[2+fifo_idx] >> 4) & 0xF);
+			batch->gyro[0][packet_count_i]  = (int32_t)gyro[0] * 16 + (fifo[0+fifo_idx] & 0xF);
+			batch->gyro[1][packet_count_i]  = (int32_t)gyro[1] * 16 + (fifo[1+fifo_idx] & 0xF);
+			batch->gyro[2][packet_count_i]  = (int32_t)gyro[2] * 16 + (fifo[2+fifo_idx] & 0xF);
+			fifo_idx += FIFO_ACCEL_GYRO_HIGH_RES_SIZE;
+		} else {
+			batch->accel[0][packet_count_i] = accel[0];
+			batch->accel[1][packet_count_i] = accel[1];
+			batch->accel[2][packet_count_i] = accel[2];
+			batch->gyro[0][packet_count_i]  = gyro[0];
+			batch->gyro[1][packet_count_i]  = gyro[1];
+			batch->gyro[2][packet_count_i]  = gyro[2];
+		}
+		batch->temperature[packet_count_i]     = temperature;
+		batch->timestamp_fsync[packet_count_i] = timestamp_fsync;
+		batch->sensor_mask[packet_count_i]     = sensor_mask;
+		batch->count++;
+	}
 
-				/* call sensor event callback */
-				if(s->sensor_event_cb)
-					s->sensor_event_cb(&event);
+	if(packet_decoded < packet_count)
+		return INV_ERROR_SIZE;
 
-				/* Device interrupts delayed when communicating with other slaves connected to same bus 
-				 * Semi-Write to release interrupt in I2C
-				 */
-				if((s->transport.serif.serif_type == IXM42XXX_UI_I2C) || (s->transport.serif.serif_type == IXM42XXX_UI_I3C)) {					
-					status |= inv_ixm42xxx_write_reg(s, MPUREG_WHO_AM_I, 1, &data_reg);
+	return batch->count;
+}
+
+static uint8_t inv_ixm42xxx_get_uniform_packet_size(const uint8_t * fifo, uint16_t packet_count)
+{
+	const fifo_header_t * header = (const fifo_header_t *)fifo;
+	uint8_t packet_size;
+	uint16_t packet_count_i;
+
+	if(packet_count == 0)
+		return 0;
+
+	if(header->bits.msg_bit || header->bits.fsync_bit || !header->bits.timestamp_bit 
+	   || !header->bits.accel_bit || !header->bits.gyro_bit)
+		return 0;
+
+	packet_size = header->bits.twentybits_bit ? FIFO_20BYTES_PACKET_SIZE : FIFO_16BYTES_PACKET_SIZE;
+
+	for(packet_count_i = 1; packet_count_i < packet_count; packet_count_i++) {
+		if(fifo[packet_count_i * packet_size] != header->Byte)
+			return 0;
+	}
+
+	return packet_size;
+}
+
+static void inv_ixm42xxx_decode_uniform_fifo_batch(struct inv_ixm42xxx * s, const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	uint16_t packet_count_i;
+	uint8_t high_res = (packet_size == FIFO_20BYTES_PACKET_SIZE);
+	/* invalid 16-bit value once merged with its 4 LSB */
+	const int32_t invalid_min = high_res ? ((int32_t)INVALID_VALUE_FIFO * 16) : INVALID_VALUE_FIFO;
+	const int32_t invalid_max = high_res ? ((int32_t)INVALID_VALUE_FIFO * 16 + 0xF) : INVALID_VALUE_FIFO;
+	const int16_t invalid_temp = high_res ? INVALID_VALUE_FIFO : INVALID_VALUE_FIFO_1B;
+
+	inv_ixm42xxx_decode_fifo_samples(fifo, packet_count, packet_size, s->endianess_data, batch);
+
+	for(packet_count_i = 0; packet_count_i < packet_count; packet_count_i++) {
+		uint16_t sensor_mask = 0;
+		uint8_t k, accel_valid = 1, gyro_valid = 1;
+
+		for(k = 0; k < 3; k++) {
+			if((batch->accel[k][packet_count_i] >= invalid_min) && (batch->accel[k][packet_count_i] <= invalid_max))
+				accel_valid = 0;
+			if((batch->gyro[k][packet_count_i] >= invalid_min) && (batch->gyro[k][packet_count_i] <= invalid_max))
+				gyro_valid = 0;
+		}
+
+		/* new temperature data */
+		if(batch->temperature[packet_count_i] != invalid_temp)
+			sensor_mask |= (1 << INV_IXM42XXX_SENSOR_TEMPERATURE);
+
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+		/* Every sample produced counts towards the start-up time, valid or not */
+		if(!inv_ixm42xxx_is_sensor_settled(&s->accel_discard_count))
+			accel_valid = 0;
+		if(!inv_ixm42xxx_is_sensor_settled(&s->gyro_discard_count))
+			gyro_valid = 0;
+#endif
+		if(accel_valid)
+			sensor_mask |= (1 << INV_IXM42XXX_SENSOR_ACCEL);
+		if(gyro_valid)
+			sensor_mask |= (1 << INV_IXM42XXX_SENSOR_GYRO);
+
+		batch->sensor_mask[packet_count_i] = sensor_mask;
+	}
+
+	/* Timestamp is in FIFO, first FSYNC event after restart is over */
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	s->fsync_to_be_ignored = 0;
+#endif
+
+	batch->high_res = high_res;
+	batch->count = packet_count;
+}
+
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+/* First data are noisy after enabling sensor
+ * Count down the samples produced during the start-up time before notifying the event,
+ * to be called for every sample the sensor produced whether its data are valid or not
+ */
+static int inv_ixm42xxx_is_sensor_settled(uint16_t * discard_count)
+{
+	if (*discard_count == 0)
+		return 1;
+
+	(*discard_count)--;
+
+	return 0;
+}
+#endif
+
+/* Compatibility path: decode FIFO by chunks and notify sensor_event_cb for each packet */
+static int inv_ixm42xxx_notify_fifo_events(struct inv_ixm42xxx * s, const uint8_t * fifo, uint16_t packet_count)
+{
+	int rc = 0;
+	int status = 0;
+	uint8_t data_reg = 0;
+	uint16_t packet_size = FIFO_16BYTES_PACKET_SIZE;
+	uint16_t packet_done = 0;
+	uint16_t i, k;
+	int32_t accel[3][IXM42XXX_FIFO_EVENT_CHUNK_SIZE];
+	int32_t gyro[3][IXM42XXX_FIFO_EVENT_CHUNK_SIZE];
+	int16_t temperature[IXM42XXX_FIFO_EVENT_CHUNK_SIZE];
+	uint16_t timestamp_fsync[IXM42XXX_FIFO_EVENT_CHUNK_SIZE];
+	uint16_t sensor_mask[IXM42XXX_FIFO_EVENT_CHUNK_SIZE];
+	inv_ixm42xxx_fifo_batch_t batch = {
+		{accel[0], accel[1], accel[2]}, {gyro[0], gyro[1], gyro[2]},
+		temperature, timestamp_fsync, sensor_mask, IXM42XXX_FIFO_EVENT_CHUNK_SIZE, 0, 0
+	};
+
+	if(s->fifo_highres_enabled)
+		packet_size = FIFO_20BYTES_PACKET_SIZE;
+
+	while((packet_done < packet_count) && (rc >= 0)) {
+		uint16_t chunk = packet_count - packet_done;
+		if(chunk > IXM42XXX_FIFO_EVENT_CHUNK_SIZE)
+			chunk = IXM42XXX_FIFO_EVENT_CHUNK_SIZE;
+
+		rc = inv_ixm42xxx_decode_fifo_batch(s, &fifo[packet_done * packet_size], chunk, &batch);
+
+		for(i = 0; i < batch.count; i++) {
+			inv_ixm42xxx_sensor_event_t event;
+
+			event.sensor_mask = sensor_mask[i];
+			event.timestamp_fsync = timestamp_fsync[i];
+			event.temperature = temperature[i];
+			for(k = 0; k < 3; k++) {
+				if(batch.high_res) {
+					event.accel_high_res[k] = (int8_t)(accel[k][i] & 0xF);
+					event.gyro_high_res[k]  = (int8_t)(gyro[k][i] & 0xF);
+					event.accel[k] = (int16_t)((accel[k][i] - event.accel_high_res[k]) / 16);
+					event.gyro[k]  = (int16_t)((gyro[k][i] - event.gyro_high_res[k]) / 16);
+				} else {
+					event.accel_high_res[k] = 0;
+					event.gyro_high_res[k]  = 0;
+					event.accel[k] = (int16_t)accel[k][i];
+					event.gyro[k]  = (int16_t)gyro[k][i];
 				}
-				
-			} /* end of FIFO read for loop */
+			}
+
+			/* call sensor event callback */
+			if(s->sensor_event_cb)
+				s->sensor_event_cb(&event);
+
+			/* Device interrupts delayed when communicating with other slaves connected to same bus 
+			 * Semi-Write to release interrupt in I2C
+			 */
+			if(((s->transport.serif.serif_type == IXM42XXX_UI_I2C) || (s->transport.serif.serif_type == IXM42XXX_UI_I3C)) &&
+			  (s->semi_write_mode == INV_IXM42XXX_SEMI_WRITE_PER_PACKET)) {
+				status |= inv_ixm42xxx_write_reg(s, MPUREG_WHO_AM_I, 1, &data_reg);
+			}
 		}
-		/*else: packet_count was 0*/
+		packet_done += chunk;
+	}
+
+	/* Events are all delivered even if a release failed, report it to the caller anyway */
+	return (rc < 0) ? rc : status;
+}
+
+int inv_ixm42xxx_get_data_from_fifo(struct inv_ixm42xxx * s)
+{
+	int status = 0;
+	inv_ixm42xxx_fifo_buffer_t * buffer;
+	const uint8_t * fifo;
+	uint16_t packet_count = 0;
+
+	status |= inv_ixm42xxx_read_fifo_released(s, &buffer, &fifo, &packet_count);
+
+	if((status == 0) && (packet_count > 0))
+		status |= inv_ixm42xxx_notify_fifo_events(s, fifo, packet_count);
+
+	/* Registered buffer only lent for this drain */
+	if(buffer)
+		inv_ixm42xxx_add_fifo_buffer(s, buffer);
+
+	return status ? status : packet_count;
+}
+
+int inv_ixm42xxx_get_data_from_fifo_batch(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	int status = 0;
+	inv_ixm42xxx_fifo_buffer_t * buffer;
+	const uint8_t * fifo;
+	uint16_t packet_count = 0;
+
+	batch->count = 0;
+
+	status |= inv_ixm42xxx_read_fifo_released(s, &buffer, &fifo, &packet_count);
+
+	if((status == 0) && (packet_count > 0))
+		status = inv_ixm42xxx_decode_fifo_batch(s, fifo, packet_count, batch);
+
+	if(buffer)
+		inv_ixm42xxx_add_fifo_buffer(s, buffer);
+
+	return status;
+}
+
+int inv_ixm42xxx_set_fifo_decode_detached(struct inv_ixm42xxx * s, uint8_t detached)
+{
+	s->fifo_decode_detached = detached ? 1 : 0;
+
+	return 0;
+}
+
+int inv_ixm42xxx_add_fifo_buffer(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t * buffer)
+{
+	if((buffer == NULL) || (buffer->data == NULL) || (buffer->size < IXM42XXX_FIFO_BUFFER_MIN_SIZE))
+		return INV_ERROR_BAD_ARG;
+
+	buffer->fifo = NULL;
+	buffer->packet_count = 0;
+	buffer->next = s->fifo_free_buffers;
+	s->fifo_free_buffers = buffer;
+
+	return 0;
+}
+
+int inv_ixm42xxx_get_fifo_buffer(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t ** buffer)
+{
+	int status = 0;
+	const uint8_t * fifo;
+	uint16_t packet_count = 0;
+
+	*buffer = NULL;
+
+	if(s->fifo_free_buffers == NULL)
+		return INV_ERROR_MEM;
+
+	status |= inv_ixm42xxx_read_fifo_released(s, buffer, &fifo, &packet_count);
+	if(status || (packet_count == 0)) {
+		inv_ixm42xxx_add_fifo_buffer(s, *buffer);
+		*buffer = NULL;
+		return status;
 	}
-	/*else: FIFO threshold was not reached and FIFO was not full*/
 
 	return packet_count;
 }
 
+int inv_ixm42xxx_set_fifo_drain_mode(struct inv_ixm42xxx * s, INV_IXM42XXX_FIFO_DRAIN_MODE_t drain_mode)
+{
+	if((drain_mode != INV_IXM42XXX_FIFO_DRAIN_SEQUENTIAL) && (drain_mode != INV_IXM42XXX_FIFO_DRAIN_BURST))
+		return INV_ERROR_BAD_ARG;
+
+	s->fifo_drain_mode = drain_mode;
+
+	return 0;
+}
+
+int inv_ixm42xxx_set_semi_write_mode(struct inv_ixm42xxx * s, INV_IXM42XXX_SEMI_WRITE_MODE_t semi_write_mode)
+{
+	if((semi_write_mode != INV_IXM42XXX_SEMI_WRITE_PER_PACKET) && (semi_write_mode != INV_IXM42XXX_SEMI_WRITE_PER_DRAIN))
+		return INV_ERROR_BAD_ARG;
+
+	s->semi_write_mode = semi_write_mode;
+
+	return 0;
+}
+
+int inv_ixm42xxx_set_fifo_count_mode(struct inv_ixm42xxx * s, IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_t count_rec)
+{
+	int status = 0;
+	uint8_t data;
+
+	if((count_rec != IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_RECORD) && (count_rec != IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE))
+		return INV_ERROR_BAD_ARG;
+
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_INTF_CONFIG0, 1, &data);
+	data &= (uint8_t)~BIT_FIFO_COUNT_REC_MASK;
+	data |= (uint8_t)count_rec;
+	status |= inv_ixm42xxx_write_reg(s, MPUREG_INTF_CONFIG0, 1, &data);
+
+	s->fifo_count_rec = count_rec;
+
+	/* FIFO content was counted with the previous unit */
+	status |= inv_ixm42xxx_reset_fifo(s);
+
+	/* Watermark is compared with FIFO_COUNT, program it in the new unit */
+	status |= inv_ixm42xxx_configure_fifo_wm(s, s->fifo_wm);
+
+	return status;
+}
+
+int inv_ixm42xxx_get_fifo_loss(struct inv_ixm42xxx * s, uint32_t * lost_packets, uint32_t * resync_bytes)
+{
+	if(lost_packets)
+		*lost_packets = s->fifo_lost_packets;
+	if(resync_bytes)
+		*resync_bytes = s->fifo_resync_bytes;
+
+	return 0;
+}
+
 uint32_t inv_ixm42xxx_convert_odr_bitfield_to_us(uint32_t odr_bitfield)
 {
 	/*
@@ -1120,6 +1814,20 @@ uint32_t inv_ixm42xxx_convert_odr_bitfield_to_us(uint32_t odr_bitfield)
 	}
 }
 
+uint16_t inv_ixm42xxx_get_startup_discard_count(uint32_t odr_bitfield, uint32_t startup_time_us)
+{
+	uint32_t odr_us = inv_ixm42xxx_convert_odr_bitfield_to_us(odr_bitfield);
+
+	return (uint16_t)((startup_time_us + odr_us - 1) / odr_us);
+}
+
+uint16_t inv_ixm42xxx_rescale_startup_discard_count(uint16_t discard_count, uint32_t odr_bitfield_from, uint32_t odr_bitfield_to)
+{
+	uint32_t startup_left_us = (uint32_t)discard_count * inv_ixm42xxx_convert_odr_bitfield_to_us(odr_bitfield_from);
+
+	return inv_ixm42xxx_get_startup_discard_count(odr_bitfield_to, startup_left_us);
+}
+
 int inv_ixm42xxx_set_accel_frequency(struct inv_ixm42xxx * s, const IXM42XXX_ACCEL_CONFIG0_ODR_t frequency)
 {
 	int status = 0;
@@ -1139,6 +1847,12 @@ int inv_ixm42xxx_set_accel_frequency(struct inv_ixm42xxx * s, const IXM42XXX_ACC
 		s->wu_off_acc_odr_changes = 0; /* WUOSC is on and acc is running, ODR change will be taken into account */
 #endif
 	status |= inv_ixm42xxx_read_reg(s, MPUREG_ACCEL_CONFIG0, 1, &accel_cfg_0_reg);
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	/* Start-up samples left were counted at the previous ODR */
+	if(s->accel_discard_count)
+		s->accel_discard_count = inv_ixm42xxx_rescale_startup_discard_count(s->accel_discard_count,
+		                                                                    accel_cfg_0_reg & BIT_ACCEL_CONFIG0_ODR_MASK, frequency);
+#endif
 	accel_cfg_0_reg &= (uint8_t)~BIT_ACCEL_CONFIG0_ODR_MASK;
 	accel_cfg_0_reg |= (uint8_t)frequency;
 	status |= inv_ixm42xxx_write_reg(s, MPUREG_ACCEL_CONFIG0, 1, &accel_cfg_0_reg);
@@ -1151,6 +1865,12 @@ int inv_ixm42xxx_set_gyro_frequency(struct inv_ixm42xxx * s, const IXM42XXX_GYRO
 	int status = 0;
 	uint8_t gyro_cfg_0_reg;
 	status |= inv_ixm42xxx_read_reg( s, MPUREG_GYRO_CONFIG0 , 1, &gyro_cfg_0_reg);
+#if (!INV_IXM42XXX_LIGHTWEIGHT_DRIVER)
+	/* Start-up samples left were counted at the previous ODR */
+	if(s->gyro_discard_count)
+		s->gyro_discard_count = inv_ixm42xxx_rescale_startup_discard_count(s->gyro_discard_count,
+		                                                                   gyro_cfg_0_reg & BIT_GYRO_CONFIG0_ODR_MASK, frequency);
+#endif
 	gyro_cfg_0_reg &= (uint8_t)~BIT_GYRO_CONFIG0_ODR_MASK;
 	gyro_cfg_0_reg |= (uint8_t)frequency;
 	status |= inv_ixm42xxx_write_reg(s, MPUREG_GYRO_CONFIG0, 1, &gyro_cfg_0_reg);
@@ -1292,6 +2012,10 @@ int inv_ixm42xxx_reset_fifo(struct inv_ixm42xxx * s)
 		status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG, 1, &saved_fifo_config);
 		status |= inv_ixm42xxx_read_reg(s, MPUREG_WHO_AM_I, 1, &data);
 	}
+
+	/* Byte count mode drain restarts on a packet boundary */
+	s->fifo_carry_len = 0;
+	s->fifo_synced = 1;
 	
 	return status;
 }
@@ -1414,6 +2138,10 @@ int inv_ixm42xxx_enable_high_resolution_fifo(struct inv_ixm42xxx * s)
 
 	/* set FIFO packets to 20bit format (i.e. high res is enabled) */
 	s->fifo_highres_enabled = 1;
+
+	/* Watermark in bytes follows the packet size */
+	if(s->fifo_count_rec == IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE)
+		return inv_ixm42xxx_configure_fifo_wm(s, s->fifo_wm);
 	
 	return 0;
 }
@@ -1431,6 +2159,10 @@ int inv_ixm42xxx_disable_high_resolution_fifo(struct inv_ixm42xxx * s)
 
 	/* set FIFO packets to 16bit format (i.e. high res is disabled) */
 	s->fifo_highres_enabled = 0;
+
+	/* Watermark in bytes follows the packet size */
+	if(s->fifo_count_rec == IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE)
+		return inv_ixm42xxx_configure_fifo_wm(s, s->fifo_wm);
 	
 	return 0;
 }
@@ -1447,13 +2179,14 @@ int inv_ixm42xxx_configure_fifo(struct inv_ixm42xxx * s, INV_IXM42XXX_FIFO_CONFI
 	
 		case INV_IXM42XXX_FIFO_ENABLED :
 			/* Configure:
-			 * - FIFO record mode i.e FIFO count unit is packet 
+			 * - FIFO record mode i.e FIFO count unit is packet, unless byte mode was selected
 			 * - FIFO snapshot mode i.e drop the data when the FIFO overflows
 			 * - Timestamp is logged in FIFO
 			 * - Little Endian fifo_count
 			*/
 			status |= inv_ixm42xxx_read_reg(s, MPUREG_INTF_CONFIG0, 1, &data);
-			data |= (uint8_t)IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_RECORD;
+			data &= (uint8_t)~BIT_FIFO_COUNT_REC_MASK;
+			data |= (uint8_t)s->fifo_count_rec;
 			data &= (uint8_t)~BIT_FIFO_COUNT_ENDIAN_MASK; // little endian
 			status |= inv_ixm42xxx_write_reg(s, MPUREG_INTF_CONFIG0, 1, &data);
 			data = (uint8_t)IXM42XXX_FIFO_CONFIG_MODE_STOP_ON_FULL;
@@ -1475,7 +2208,8 @@ int inv_ixm42xxx_configure_fifo(struct inv_ixm42xxx * s, INV_IXM42XXX_FIFO_CONFI
 			data |= (uint8_t)IXM42XXX_FIFO_CONFIG1_WM_GT_TH_EN;
 			status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG1, 1, &data);
 			/* Configure FIFO WM so that INT is triggered for each packet */
-			data = 0x1;
+			s->fifo_wm = 1;
+			data = (uint8_t)inv_ixm42xxx_get_fifo_wm_reg(s, s->fifo_wm);
 			status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG2, 1, &data);
 
 			/* Disable Data Ready Interrupt */
@@ -1520,9 +2254,11 @@ int inv_ixm42xxx_configure_fifo_wm(struct inv_ixm42xxx * s, uint16_t wm)
 	inv_ixm42xxx_interrupt_value fifo_ths_int1_bk; 
 	inv_ixm42xxx_interrupt_value fifo_ths_int2_bk; 
 	inv_ixm42xxx_interrupt_value fifo_ths_ibi_bk; 
+	uint32_t wm_reg = inv_ixm42xxx_get_fifo_wm_reg(s, wm);
+	uint8_t data[2];
 
 	/* WM is coded on 12 bits so check that 4 MSb are 0 */
-	if ((wm & 0xF000) != 0)
+	if ((wm_reg & ~0xFFFUL) != 0)
 		return INV_ERROR_BAD_ARG;
 
 	/* FIFO WM interrupt must be disabled before being configured */
@@ -1550,7 +2286,11 @@ int inv_ixm42xxx_configure_fifo_wm(struct inv_ixm42xxx * s, uint16_t wm)
 	}
 	
 	/* Write FIFO WM */
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG2, 2, (uint8_t *)&wm);
+	data[0] = (uint8_t)wm_reg;
+	data[1] = (uint8_t)(wm_reg >> 8);
+	status |= inv_ixm42xxx_write_reg(s, MPUREG_FIFO_CONFIG2, 2, data);
+	if(status == 0)
+		s->fifo_wm = wm;
 
 	/* Restore initial INT config if necessary */
 	if (fifo_ths_int1_bk != config_int1.INV_IXM42XXX_FIFO_THS) {
@@ -1569,6 +2309,17 @@ int inv_ixm42xxx_configure_fifo_wm(struct inv_ixm42xxx * s, uint16_t wm)
 	return status;
 }
 
+/* FIFO_CONFIG2/3 value for a watermark in packets: the device compares it with FIFO_COUNT, 
+ * which counts bytes in byte count mode
+ */
+static uint32_t inv_ixm42xxx_get_fifo_wm_reg(struct inv_ixm42xxx * s, uint16_t wm)
+{
+	if(s->fifo_count_rec != IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE)
+		return wm;
+
+	return (uint32_t)wm * (s->fifo_highres_enabled ? FIFO_20BYTES_PACKET_SIZE : FIFO_16BYTES_PACKET_SIZE);
+}
+
 uint32_t inv_ixm42xxx_get_fifo_timestamp_resolution_us_q24(struct inv_ixm42xxx * s)
 {
 	int status = 0;
@@ -54,6 +54,17 @@ extern "C" {
 	#define INV_IXM42XXX_LIGHTWEIGHT_DRIVER 0
 #endif
 
+/** @brief Remove the FIFO mirror embedded in struct inv_ixm42xxx
+ *  @details
+ *  By default FIFO is drained in a buffer of IXM42XXX_FIFO_MIRRORING_SIZE bytes held by the
+ *  driver object. Applications that register their own buffers with inv_ixm42xxx_add_fifo_buffer()
+ *  can set this define to 1 to save that memory on each device: draining without a free
+ *  registered buffer then fails with INV_ERROR_MEM.
+ */
+#ifndef INV_IXM42XXX_EXTERNAL_FIFO_BUFFER
+	#define INV_IXM42XXX_EXTERNAL_FIFO_BUFFER 0
+#endif
+
 /** @brief Scale factor and max ODR 
  *  Dependant of chip
  */
@@ -106,6 +117,24 @@ extern "C" {
  */
 #define IXM42XXX_FIFO_MIRRORING_SIZE 16 * 129 // packet size * max_count = 2064
 
+/** @brief Bytes read in front of FIFO data by a burst drain: INT_STATUS, FIFO_COUNTH and FIFO_COUNTL
+ */
+#define IXM42XXX_FIFO_BURST_HEADER_SIZE 3
+
+/** @brief Maximum number of packets decoded from a single FIFO drain
+ */
+#define IXM42XXX_FIFO_MAX_PACKETS ((IXM42XXX_FIFO_MIRRORING_SIZE) / FIFO_16BYTES_PACKET_SIZE)
+
+/** @brief Smallest buffer accepted by inv_ixm42xxx_add_fifo_buffer(): burst header and one high resolution packet
+ */
+#define IXM42XXX_FIFO_BUFFER_MIN_SIZE (IXM42XXX_FIFO_BURST_HEADER_SIZE + FIFO_20BYTES_PACKET_SIZE)
+
+/** @brief Number of packets decoded at once on stack before notifying sensor_event_cb
+ */
+#ifndef IXM42XXX_FIFO_EVENT_CHUNK_SIZE
+	#define IXM42XXX_FIFO_EVENT_CHUNK_SIZE 16
+#endif
+
 /** @brief Default value for the WOM threshold
  *  Resolution of the threshold is ~= 4mg
  */
@@ -144,6 +173,20 @@ typedef enum {
 	INV_IXM42XXX_FIFO_ENABLED  = 1,              /**< Fifo is used as data source */
 }INV_IXM42XXX_FIFO_CONFIG_t;
 
+/** @brief Bus transactions used by inv_ixm42xxx_get_data_from_fifo()
+ */
+typedef enum {
+	INV_IXM42XXX_FIFO_DRAIN_SEQUENTIAL = 0,      /**< INT_STATUS, FIFO_COUNT and FIFO_DATA are read in 3 transactions */
+	INV_IXM42XXX_FIFO_DRAIN_BURST      = 1,      /**< INT_STATUS, FIFO_COUNT and a watermark-sized payload are read in one transaction */
+}INV_IXM42XXX_FIFO_DRAIN_MODE_t;
+
+/** @brief When FIFO drains issue the I2C/I3C semi-write releasing the interrupt line
+ */
+typedef enum {
+	INV_IXM42XXX_SEMI_WRITE_PER_PACKET = 0,      /**< after every packet passed to sensor_event_cb */
+	INV_IXM42XXX_SEMI_WRITE_PER_DRAIN  = 1,      /**< once after each FIFO read that returned packets */
+}INV_IXM42XXX_SEMI_WRITE_MODE_t;
+
 /** @brief Sensor event structure definition
  */
 typedef struct {
@@ -156,6 +199,40 @@ typedef struct {
 	int8_t gyro_high_res[3];
 } inv_ixm42xxx_sensor_event_t;
 
+/** @brief Structure-of-arrays destination of a decoded FIFO burst
+ *  @details
+ *  Arrays are owned by the caller and must all hold at least capacity elements.
+ *  Element i of each array belongs to packet i of the burst.
+ *  Accel and gyro are 16-bit samples, or 20-bit samples (16 MSB and 4 LSB merged)
+ *  when high_res is set. All packets of a burst share the same format.
+ */
+typedef struct {
+	int32_t * accel[3];          /**< accel x, y, z */
+	int32_t * gyro[3];           /**< gyro x, y, z */
+	int16_t * temperature;       /**< raw temperature, 8-bit in 16 bytes packets, 16-bit in 20 bytes packets */
+	uint16_t * timestamp_fsync;  /**< FIFO timestamp, or FSYNC delay when INV_IXM42XXX_SENSOR_FSYNC_EVENT is set */
+	uint16_t * sensor_mask;      /**< valid data as bitfield of enum inv_ixm42xxx_sensor, same meaning as inv_ixm42xxx_sensor_event_t::sensor_mask */
+	uint16_t capacity;           /**< number of elements of each array, IXM42XXX_FIFO_MAX_PACKETS to never drop data */
+	uint16_t count;              /**< number of packets decoded */
+	uint8_t high_res;            /**< accel and gyro are 20-bit samples */
+} inv_ixm42xxx_fifo_batch_t;
+
+/** @brief Caller-owned buffer FIFO bursts are read into
+ *  @details
+ *  data is passed as is to the serif read_reg hook, so it can be DMA-able or mmap'd memory
+ *  with the alignment the bus controller needs. Note that in burst drain mode the first packet
+ *  starts IXM42XXX_FIFO_BURST_HEADER_SIZE bytes after data.
+ *  A buffer belongs to the driver while it is in the free list, and to the caller between
+ *  inv_ixm42xxx_get_fifo_buffer() and inv_ixm42xxx_add_fifo_buffer().
+ */
+typedef struct inv_ixm42xxx_fifo_buffer {
+	uint8_t * data;                          /**< buffer memory, set by the caller */
+	uint32_t size;                           /**< bytes at data, set by the caller, bounds the packets read per drain */
+	const uint8_t * fifo;                    /**< first packet header in data, set by the drain */
+	uint16_t packet_count;                   /**< packets at fifo, set by the drain */
+	struct inv_ixm42xxx_fifo_buffer * next;  /**< free list link, used by the driver */
+} inv_ixm42xxx_fifo_buffer_t;
+
 /** @brief Ixm42xxx driver states definition
  */
 struct inv_ixm42xxx {
@@ -171,15 +248,29 @@ struct inv_ixm42xxx {
 	int accel_st_bias[3];
 	int st_result;                                                   /**< Flag to keep track if self-test has been already run by storing acc and gyr results */
 
-	uint8_t fifo_data[IXM42XXX_FIFO_MIRRORING_SIZE];              /**<  FIFO mirroring memory area */
+#if (!INV_IXM42XXX_EXTERNAL_FIFO_BUFFER)
+	uint8_t fifo_data[IXM42XXX_FIFO_BURST_HEADER_SIZE + IXM42XXX_FIFO_MIRRORING_SIZE]; /**<  FIFO mirroring memory area, used when no buffer is registered */
+#endif
+	inv_ixm42xxx_fifo_buffer_t * fifo_free_buffers;               /**< caller buffers available for the next drain */
+	uint8_t fifo_decode_detached;                                 /**< FIFO decoding does not access the bus, see inv_ixm42xxx_set_fifo_decode_detached() */
+	uint16_t fifo_wm;                                             /**< FIFO watermark in packets, sizes the burst drain speculative read */
+	INV_IXM42XXX_FIFO_DRAIN_MODE_t fifo_drain_mode;               /**< Bus transactions used to drain FIFO. Sequential by default */
+	INV_IXM42XXX_SEMI_WRITE_MODE_t semi_write_mode;               /**< I2C/I3C interrupt release. Per packet by default */
+	IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_t fifo_count_rec;        /**< FIFO_COUNT unit requested by inv_ixm42xxx_set_fifo_count_mode(). Packets by default */
+	uint8_t fifo_carry[FIFO_20BYTES_PACKET_SIZE];                 /**< byte count mode: start of a packet whose end was still in FIFO at previous drain */
+	uint8_t fifo_carry_len;                                       /**< number of valid bytes in fifo_carry */
+	uint8_t fifo_synced;                                          /**< byte count mode: FIFO is read from a verified packet boundary */
+	uint16_t fifo_lost_pkt;                                       /**< last FIFO_LOST_PKT value read */
+	uint32_t fifo_lost_packets;                                   /**< packets dropped by the device on FIFO full, see inv_ixm42xxx_get_fifo_loss() */
+	uint32_t fifo_resync_bytes;                                   /**< bytes skipped to find a packet header in byte count mode */
 
 	uint8_t tmst_to_reg_en_cnt;                                   /**< internal counter to keep track of the timestamp to register access availability */
 	
 	uint8_t dmp_is_on;                                            /**< DMP started status */
 	uint8_t dmp_from_sram;                                        /**< DMP executes from SRAM */
 
-	uint64_t gyro_start_time_us;                                  /**< internal state needed to discard first gyro samples */
-	uint64_t accel_start_time_us;                                 /**< internal state needed to discard first accel samples */
+	uint16_t gyro_discard_count;                                  /**< internal state needed to discard first gyro samples */
+	uint16_t accel_discard_count;                                 /**< internal state needed to discard first accel samples */
 	uint8_t endianess_data;                                       /**< internal status of data endianess mode to report correctly data */
 	uint8_t fifo_highres_enabled;                                 /**< FIFO packets are 20 bytes long */
 	INV_IXM42XXX_FIFO_CONFIG_t fifo_is_used;                      /**< Data are get from FIFO or from sensor registers. By default Fifo is used*/
@@ -245,6 +336,9 @@ typedef struct {
 /** @brief Set register bank index
  *  @param bank new bank to be set
  *  @return 0 on success, negative value otherwise
+ *  @details
+ *  REG_BANK_SEL is written by the transport before the next access that reaches the device,
+ *  and only if the device is on another bank. Accesses served by the register shadow cost no switch.
  */
 int inv_ixm42xxx_set_reg_bank(struct inv_ixm42xxx * s, uint8_t bank);
 
@@ -386,6 +480,15 @@ int inv_ixm42xxx_enable_fsync(struct inv_ixm42xxx * s);
  */
 int inv_ixm42xxx_disable_fsync(struct inv_ixm42xxx * s);
 
+/** @brief Select the data flagged by an FSYNC edge and enable or disable FSYNC tagging.
+ *  The next ODR packet after an edge on the FSYNC pin carries INV_IXM42XXX_SENSOR_FSYNC_EVENT,
+ *  its timestamp being replaced by the delay from the edge to that packet, in timestamp units.
+ *  The LSB of the selected data holds the flag, temperature costs the least.
+ *  @param[in] ui_sel Data tagged, IXM42XXX_FSYNC_CONFIG_UI_SEL_NO disables tagging.
+ *  @return 0 on success, negative value on error.
+ */
+int inv_ixm42xxx_configure_fsync_tag(struct inv_ixm42xxx * s, IXM42XXX_FSYNC_CONFIG_UI_SEL_t ui_sel);
+
 /** @brief  Configure timestamp resolution from FIFO.
  *  @param[in] resol The expected resolution of the timestamp. See enum IXM42XXX_TMST_CONFIG_RESOL_t.
  *  @return 0 on success, negative value on error.
@@ -443,12 +546,135 @@ int inv_ixm42xxx_get_data_from_registers(struct inv_ixm42xxx * s);
  */
 int inv_ixm42xxx_get_data_from_fifo(struct inv_ixm42xxx * s);
 
+/** @brief Read all available data from FIFO and decode them in caller arrays.
+ *  @param[in,out] batch caller-owned arrays, batch->count is set to the number of decoded packets
+ *  @return number of valid packets read in FIFO on success, negative value on error.
+ *  @details
+ *  Same as inv_ixm42xxx_get_data_from_fifo() but sensor_event_cb is not called: the whole 
+ *  burst is available in batch when the function returns.
+ */
+int inv_ixm42xxx_get_data_from_fifo_batch(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_batch_t * batch);
+
+/** @brief Give a buffer to the driver for the next FIFO drains
+ *  @param[in] buffer data and size set by the caller, must stay valid until the driver gives it back
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  Register each buffer of the pool after inv_ixm42xxx_init(), and call again to give back a 
+ *  buffer returned by inv_ixm42xxx_get_fifo_buffer(). While a buffer is free, inv_ixm42xxx_get_data_from_fifo()
+ *  and inv_ixm42xxx_get_data_from_fifo_batch() drain into it instead of the embedded FIFO mirror.
+ *  The free list is not locked: call from the context that drains the FIFO.
+ */
+int inv_ixm42xxx_add_fifo_buffer(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t * buffer);
+
+/** @brief Read all available data from FIFO into a registered buffer and hand it to the caller
+ *  @param[out] buffer buffer holding the burst, buffer->fifo and buffer->packet_count describe its content. 
+ *                     NULL when FIFO had nothing to read.
+ *  @return number of packets read on success, negative value on error.
+ *  INV_ERROR_MEM is returned when no registered buffer is free.
+ *  @details
+ *  No decoding is done and FIFO content is not copied. Decode with inv_ixm42xxx_decode_fifo_batch() 
+ *  in drain order, since it tracks sensor startup and FSYNC state, then give the buffer back with
+ *  inv_ixm42xxx_add_fifo_buffer().
+ */
+int inv_ixm42xxx_get_fifo_buffer(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_buffer_t ** buffer);
+
+/** @brief Decode FIFO packets already read from device in caller arrays.
+ *  @param[in] fifo         FIFO content, starting on a packet header
+ *  @param[in] packet_count number of packets in fifo
+ *  @param[in,out] batch    caller-owned arrays, batch->count is set to the number of decoded packets
+ *  @return number of decoded packets on success, negative value on error.
+ *  INV_ERROR_SIZE is returned if batch capacity is lower than packet_count, batch then 
+ *  holds the first batch->capacity packets.
+ *  @details
+ *  Driver state used to discard first samples after sensor enabling and FSYNC tags is updated.
+ */
+int inv_ixm42xxx_decode_fifo_batch(struct inv_ixm42xxx * s, const uint8_t * fifo, uint16_t packet_count, inv_ixm42xxx_fifo_batch_t * batch);
+
+/** @brief Keep inv_ixm42xxx_decode_fifo_batch() off the bus so it can run beside FIFO reads
+ *  @param[in] detached 1 to only report decode errors, 0 (default) to also flush FIFO on a decode error
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  By default a corrupted burst makes the decoder reset FIFO to restart on a packet boundary.
+ *  When bursts are decoded in another thread than the one reading them (see inv_ixm42xxx_get_fifo_buffer()),
+ *  set detached: the decoder then only touches driver state no read path uses, and the reading 
+ *  context must call inv_ixm42xxx_reset_fifo() when a decode fails.
+ */
+int inv_ixm42xxx_set_fifo_decode_detached(struct inv_ixm42xxx * s, uint8_t detached);
+
+/** @brief Select how inv_ixm42xxx_get_data_from_fifo() accesses the bus
+ *  @param[in] drain_mode INV_IXM42XXX_FIFO_DRAIN_SEQUENTIAL (default) or INV_IXM42XXX_FIFO_DRAIN_BURST
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  In burst mode, INT_STATUS, FIFO_COUNT and FIFO watermark packets are read in a single
+ *  transaction starting at INT_STATUS. A follow-up FIFO_DATA read is only issued when FIFO
+ *  holds more packets than the watermark. Burst mode is meant to be used on FIFO watermark
+ *  interrupt: if FIFO holds less than watermark, FIFO is flushed after the drain to restart
+ *  on a packet boundary. On I3C, FIFO is always read packet by packet.
+ */
+int inv_ixm42xxx_set_fifo_drain_mode(struct inv_ixm42xxx * s, INV_IXM42XXX_FIFO_DRAIN_MODE_t drain_mode);
+
+/** @brief Select how often FIFO drains release the interrupt line on I2C and I3C
+ *  @param[in] semi_write_mode INV_IXM42XXX_SEMI_WRITE_PER_PACKET (default) or INV_IXM42XXX_SEMI_WRITE_PER_DRAIN
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  Device interrupts are delayed while the host talks to other devices on the same bus and a 
+ *  dummy write to WHO_AM_I releases them. By default inv_ixm42xxx_get_data_from_fifo() issues it
+ *  after every packet, i.e. up to 129 extra transactions per drain. Per drain, a single one is 
+ *  issued right after the FIFO read, by every function reading FIFO including 
+ *  inv_ixm42xxx_get_fifo_buffer(). It has no effect on SPI.
+ *  To also read I3C FIFO in a few transactions instead of packet by packet, select byte count 
+ *  mode with inv_ixm42xxx_set_fifo_count_mode(): a read cut by an IBI is then resumed by the next drain.
+ */
+int inv_ixm42xxx_set_semi_write_mode(struct inv_ixm42xxx * s, INV_IXM42XXX_SEMI_WRITE_MODE_t semi_write_mode);
+
+/** @brief Select FIFO_COUNT unit and how a drain recovers from a partial FIFO read
+ *  @param[in] count_rec IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_RECORD (default) or IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  In record mode FIFO_COUNT is a number of packets and a failed or inconsistent read flushes FIFO.
+ *  In byte mode FIFO_COUNT is a number of bytes and FIFO is never flushed by a drain: a packet 
+ *  split between two drains is carried over to the next one, and bytes that do not start with a 
+ *  valid header are skipped until packets line up again. Byte mode is also used on I3C, where 
+ *  the FIFO is then read in a single transaction instead of packet by packet since an IBI cutting 
+ *  a read only splits a packet.
+ *  FIFO is flushed when the mode changes. The watermark stays in packets, see inv_ixm42xxx_configure_fifo_wm().
+ */
+int inv_ixm42xxx_set_fifo_count_mode(struct inv_ixm42xxx * s, IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_t count_rec);
+
+/** @brief Report FIFO data lost since driver init
+ *  @param[out] lost_packets packets dropped by the device while FIFO was full (FIFO_LOST_PKT). May be NULL.
+ *  @param[out] resync_bytes bytes skipped by byte count mode drains to find a packet header. May be NULL.
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  FIFO_LOST_PKT is read by FIFO drains which see FIFO_FULL in INT_STATUS, so lost_packets 
+ *  only moves after such a drain.
+ */
+int inv_ixm42xxx_get_fifo_loss(struct inv_ixm42xxx * s, uint32_t * lost_packets, uint32_t * resync_bytes);
+
 /** @brief Converts IXM42XXX_ACCEL_CONFIG0_ODR_t or IXM42XXX_GYRO_CONFIG0_ODR_t enums to period expressed in us
  *  @param[in] odr_bitfield An IXM42XXX_ACCEL_CONFIG0_ODR_t or IXM42XXX_GYRO_CONFIG0_ODR_t enum
  *  @return The corresponding period expressed in us
  */
 uint32_t inv_ixm42xxx_convert_odr_bitfield_to_us(uint32_t odr_bitfield);
 
+/** @brief Number of first samples to discard after enabling a sensor
+ *  Samples are counted rather than timed so FIFO decoding needs no clock read. Every sample
+ *  produced is counted, valid or not. An ODR change during the start-up time rescales the
+ *  count with inv_ixm42xxx_rescale_startup_discard_count().
+ *  @param[in] odr_bitfield     An IXM42XXX_ACCEL_CONFIG0_ODR_t or IXM42XXX_GYRO_CONFIG0_ODR_t enum
+ *  @param[in] startup_time_us  IXM42XXX_ACC_STARTUP_TIME_US or IXM42XXX_GYR_STARTUP_TIME_US
+ *  @return Samples produced during the start-up time, rounded up
+ */
+uint16_t inv_ixm42xxx_get_startup_discard_count(uint32_t odr_bitfield, uint32_t startup_time_us);
+
+/** @brief Convert the start-up samples left to discard to a new ODR
+ *  @param[in] discard_count      Samples left at the previous ODR
+ *  @param[in] odr_bitfield_from  Previous ODR, an IXM42XXX_ACCEL_CONFIG0_ODR_t or IXM42XXX_GYRO_CONFIG0_ODR_t enum
+ *  @param[in] odr_bitfield_to    New ODR, same encoding
+ *  @return Samples produced at the new ODR during the start-up time left, rounded up
+ */
+uint16_t inv_ixm42xxx_rescale_startup_discard_count(uint16_t discard_count, uint32_t odr_bitfield_from, uint32_t odr_bitfield_to);
+
 /** @brief Configure accel Output Data Rate
  *  @param[in] frequency The requested frequency.
  *  @sa IXM42XXX_ACCEL_CONFIG0_ODR_t
@@ -576,7 +802,11 @@ int inv_ixm42xxx_disable_high_resolution_fifo(struct inv_ixm42xxx * s);
 int inv_ixm42xxx_configure_fifo(struct inv_ixm42xxx * s, INV_IXM42XXX_FIFO_CONFIG_t fifo_config);
 
  /** @brief Configure Fifo watermark (also refered to as fifo threshold)
- *  @param[in] wm Watermark value
+ *  @param[in] wm Watermark value, in packets
+ *  @details
+ *  In byte count mode the device compares the watermark with a byte count, so the register is
+ *  programmed with wm times the packet size. It is programmed again when the count mode or the
+ *  packet size (high resolution) changes.
  */
 int inv_ixm42xxx_configure_fifo_wm(struct inv_ixm42xxx * s, uint16_t wm);
 
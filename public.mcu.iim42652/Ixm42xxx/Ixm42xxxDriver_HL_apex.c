@@ -29,6 +29,8 @@ int inv_ixm42xxx_configure_smd_wom(struct inv_ixm42xxx * s, const uint8_t x_th,
 	int status = 0;
 	uint8_t data[3];
 	
+	status |= inv_ixm42xxx_begin_bank_batch(s);
+
 	/* Set memory bank 4 */
 	status |= inv_ixm42xxx_set_reg_bank(s, 4);
 	
@@ -42,6 +44,8 @@ int inv_ixm42xxx_configure_smd_wom(struct inv_ixm42xxx * s, const uint8_t x_th,
 	
 	data[0] = ((uint8_t)wom_int) | ((uint8_t)wom_mode);
 	status |= inv_ixm42xxx_write_reg(s, MPUREG_SMD_CONFIG, 1, &data[0]);
+
+	status |= inv_ixm42xxx_end_bank_batch(s);
 	
 	return status;
 }
@@ -52,6 +56,9 @@ int inv_ixm42xxx_enable_wom(struct inv_ixm42xxx * s)
 	int status = 0;
 	inv_ixm42xxx_interrupt_parameter_t config_int = {(inv_ixm42xxx_interrupt_value)0};
 	
+	/* SMD_CONFIG, INT1 and IBI sources are written together, bank 4 once */
+	status |= inv_ixm42xxx_begin_bank_batch(s);
+
 	/* Enable WOM only if SMD is not enabled
 	 * If SMD is enabled, WOM event will be generated
 	 */
@@ -75,6 +82,8 @@ int inv_ixm42xxx_enable_wom(struct inv_ixm42xxx * s)
 	config_int.INV_IXM42XXX_UI_DRDY = INV_IXM42XXX_DISABLE;
 	status |= inv_ixm42xxx_set_config_ibi(s, &config_int);
 
+	status |= inv_ixm42xxx_end_bank_batch(s);
+
 	s->wom_enable = 1;
 
 	return status;
@@ -86,6 +95,9 @@ int inv_ixm42xxx_disable_wom(struct inv_ixm42xxx * s)
 	int status = 0;
 	inv_ixm42xxx_interrupt_parameter_t config_int = {(inv_ixm42xxx_interrupt_value)0};
 
+	/* SMD_CONFIG, INT1 and IBI sources are written together, bank 4 once */
+	status |= inv_ixm42xxx_begin_bank_batch(s);
+
 	/* Enable fifo threshold int1 */
 	status |= inv_ixm42xxx_get_config_int1(s, &config_int);
 	config_int.INV_IXM42XXX_FIFO_THS = INV_IXM42XXX_ENABLE;
@@ -104,6 +116,8 @@ int inv_ixm42xxx_disable_wom(struct inv_ixm42xxx * s)
 		/* Update mask to inform wom is disabled */
 		s->wom_smd_mask = IXM42XXX_SMD_CONFIG_SMD_MODE_DISABLED;
 	}
+
+	status |= inv_ixm42xxx_end_bank_batch(s);
 	s->wom_enable = 0;
 
 	return status;
@@ -304,6 +318,9 @@ int inv_ixm42xxx_configure_apex_parameters(struct inv_ixm42xxx *s, const inv_ixm
 
 	status |= inv_ixm42xxx_write_reg(s, MPUREG_APEX_CONFIG0, 1, &data);
 
+	/* CONFIG9 and CONFIG10 go out in one write with the batch */
+	status |= inv_ixm42xxx_begin_bank_batch(s);
+
 	/* Set memory bank 4 */
 	status |= inv_ixm42xxx_set_reg_bank(s, 4);
 
@@ -321,6 +338,8 @@ int inv_ixm42xxx_configure_apex_parameters(struct inv_ixm42xxx *s, const inv_ixm
 	/* Set memory bank 0 */
 	status |= inv_ixm42xxx_set_reg_bank(s, 0);
 
+	status |= inv_ixm42xxx_end_bank_batch(s);
+
 	return status;
 }
 
@@ -0,0 +1,175 @@
+/*
+ * __________________________________________________________________
+ *
+ * Copyright (C) [2022] by InvenSense, Inc.
+ * 
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY  AND FITNESS. IN NO EVENT SHALL
+ * THE AUTHOR BE LIABLE  FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ * __________________________________________________________________
+ */
+
+#include "Ixm42xxxFifoDecode.h"
+#include "Ixm42xxxDefs.h"
+
+#if INV_IXM42XXX_FIFO_DECODE_NEON
+#include <arm_neon.h>
+#endif
+
+/* Offsets in a FIFO packet holding accel, gyro, temperature and timestamp */
+#define FIFO_ACCEL_OFFSET       (FIFO_HEADER_SIZE)
+#define FIFO_GYRO_OFFSET        (FIFO_ACCEL_OFFSET + FIFO_ACCEL_DATA_SIZE)
+#define FIFO_TEMP_OFFSET        (FIFO_GYRO_OFFSET + FIFO_GYRO_DATA_SIZE)
+#define FIFO_16B_TS_OFFSET      (FIFO_TEMP_OFFSET + FIFO_TEMP_DATA_SIZE)
+#define FIFO_20B_TS_OFFSET      (FIFO_TEMP_OFFSET + FIFO_TEMP_DATA_SIZE + FIFO_TEMP_HIGH_RES_SIZE)
+#define FIFO_20B_HIGH_RES_OFFSET (FIFO_20B_TS_OFFSET + FIFO_TS_FSYNC_SIZE)
+
+static inline uint16_t read_u16(const uint8_t * in, uint8_t endian)
+{
+	if(endian == IXM42XXX_INTF_CONFIG0_DATA_BIG_ENDIAN)
+		return (uint16_t)((in[0] << 8) | in[1]);
+	else
+		return (uint16_t)((in[1] << 8) | in[0]);
+}
+
+/* Temperature and timestamp are one per packet and never vectorized */
+static inline void decode_temp_ts(const uint8_t * p, uint16_t i, uint8_t packet_size, uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	if(packet_size == FIFO_20BYTES_PACKET_SIZE) {
+		batch->temperature[i] = (int16_t)read_u16(&p[FIFO_TEMP_OFFSET], endian);
+		batch->timestamp_fsync[i] = read_u16(&p[FIFO_20B_TS_OFFSET], endian);
+	} else {
+		batch->temperature[i] = (int8_t)p[FIFO_TEMP_OFFSET];
+		batch->timestamp_fsync[i] = read_u16(&p[FIFO_16B_TS_OFFSET], endian);
+	}
+}
+
+static inline void decode_packet_ref(const uint8_t * p, uint16_t i, uint8_t packet_size, uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	int k;
+
+	for(k = 0; k < 3; k++) {
+		int32_t accel = (int16_t)read_u16(&p[FIFO_ACCEL_OFFSET + 2*k], endian);
+		int32_t gyro  = (int16_t)read_u16(&p[FIFO_GYRO_OFFSET + 2*k], endian);
+
+		if(packet_size == FIFO_20BYTES_PACKET_SIZE) {
+			/* Merge 4 LSB: accel in upper nibble, gyro in lower nibble */
+			accel = accel * 16 + ((p[FIFO_20B_HIGH_RES_OFFSET + k] >> 4) & 0xF);
+			gyro  = gyro * 16 + (p[FIFO_20B_HIGH_RES_OFFSET + k] & 0xF);
+		}
+		batch->accel[k][i] = accel;
+		batch->gyro[k][i]  = gyro;
+	}
+	decode_temp_ts(p, i, packet_size, endian, batch);
+}
+
+void inv_ixm42xxx_decode_fifo_samples_ref(const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, 
+                                          uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	uint16_t i;
+
+	for(i = 0; i < packet_count; i++)
+		decode_packet_ref(&fifo[i * packet_size], i, packet_size, endian, batch);
+}
+
+#if INV_IXM42XXX_FIFO_DECODE_NEON
+
+/* Decode accel and gyro of 4 consecutive packets.
+ * Each packet is loaded from its header so nothing is read past the last packet. Rotating it by 
+ * one byte aligns the 6 axes on 16-bit lanes 0..5, lanes 6 and 7 (temperature, timestamp) are 
+ * dropped. The 4x8 lanes matrix is then transposed so that each axis of the 4 packets lands in 
+ * one half register and can be widened and stored with a single instruction.
+ */
+static inline void decode_4_packets_neon(const uint8_t * p, uint16_t i, uint8_t packet_size, uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	uint8x16_t raw[4];
+	int16x8_t axes[4];
+	int16x8x2_t ac, bd, lo, hi;
+	int32x4_t ax, ay, az, gx, gy, gz;
+	int k;
+
+	for(k = 0; k < 4; k++) {
+		raw[k] = vld1q_u8(&p[k * packet_size]);
+		raw[k] = vextq_u8(raw[k], raw[k], FIFO_ACCEL_OFFSET);
+		if(endian == IXM42XXX_INTF_CONFIG0_DATA_BIG_ENDIAN)
+			raw[k] = vrev16q_u8(raw[k]);
+		axes[k] = vreinterpretq_s16_u8(raw[k]);
+	}
+
+	/* lo.val[0] = ax0 ax1 ax2 ax3 ay0 ay1 ay2 ay3, lo.val[1] = az.. gx..
+	 * hi.val[0] = gy.. gz.. */
+	ac = vzipq_s16(axes[0], axes[2]);
+	bd = vzipq_s16(axes[1], axes[3]);
+	lo = vzipq_s16(ac.val[0], bd.val[0]);
+	hi = vzipq_s16(ac.val[1], bd.val[1]);
+
+	ax = vmovl_s16(vget_low_s16(lo.val[0]));
+	ay = vmovl_s16(vget_high_s16(lo.val[0]));
+	az = vmovl_s16(vget_low_s16(lo.val[1]));
+	gx = vmovl_s16(vget_high_s16(lo.val[1]));
+	gy = vmovl_s16(vget_low_s16(hi.val[0]));
+	gz = vmovl_s16(vget_high_s16(hi.val[0]));
+
+	if(packet_size == FIFO_20BYTES_PACKET_SIZE) {
+		/* Gather the 3 high-res bytes of each packet, one register per axis */
+		uint32_t hr[3][4];
+		uint32x4_t hx, hy, hz, nibble_mask = vdupq_n_u32(0xF);
+
+		for(k = 0; k < 4; k++) {
+			hr[0][k] = p[k * packet_size + FIFO_20B_HIGH_RES_OFFSET + 0];
+			hr[1][k] = p[k * packet_size + FIFO_20B_HIGH_RES_OFFSET + 1];
+			hr[2][k] = p[k * packet_size + FIFO_20B_HIGH_RES_OFFSET + 2];
+		}
+		hx = vld1q_u32(hr[0]);
+		hy = vld1q_u32(hr[1]);
+		hz = vld1q_u32(hr[2]);
+
+		ax = vaddq_s32(vshlq_n_s32(ax, 4), vreinterpretq_s32_u32(vshrq_n_u32(hx, 4)));
+		ay = vaddq_s32(vshlq_n_s32(ay, 4), vreinterpretq_s32_u32(vshrq_n_u32(hy, 4)));
+		az = vaddq_s32(vshlq_n_s32(az, 4), vreinterpretq_s32_u32(vshrq_n_u32(hz, 4)));
+		gx = vaddq_s32(vshlq_n_s32(gx, 4), vreinterpretq_s32_u32(vandq_u32(hx, nibble_mask)));
+		gy = vaddq_s32(vshlq_n_s32(gy, 4), vreinterpretq_s32_u32(vandq_u32(hy, nibble_mask)));
+		gz = vaddq_s32(vshlq_n_s32(gz, 4), vreinterpretq_s32_u32(vandq_u32(hz, nibble_mask)));
+	}
+
+	vst1q_s32(&batch->accel[0][i], ax);
+	vst1q_s32(&batch->accel[1][i], ay);
+	vst1q_s32(&batch->accel[2][i], az);
+	vst1q_s32(&batch->gyro[0][i], gx);
+	vst1q_s32(&batch->gyro[1][i], gy);
+	vst1q_s32(&batch->gyro[2][i], gz);
+
+	for(k = 0; k < 4; k++)
+		decode_temp_ts(&p[k * packet_size], i + k, packet_size, endian, batch);
+}
+
+void inv_ixm42xxx_decode_fifo_samples(const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, 
+                                      uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	uint16_t i = 0;
+
+	for(; (i + 4) <= packet_count; i += 4)
+		decode_4_packets_neon(&fifo[i * packet_size], i, packet_size, endian, batch);
+
+	/* Remaining packets */
+	for(; i < packet_count; i++)
+		decode_packet_ref(&fifo[i * packet_size], i, packet_size, endian, batch);
+}
+
+#else
+
+void inv_ixm42xxx_decode_fifo_samples(const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, 
+                                      uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch)
+{
+	inv_ixm42xxx_decode_fifo_samples_ref(fifo, packet_count, packet_size, endian, batch);
+}
+
+#endif /* INV_IXM42XXX_FIFO_DECODE_NEON */
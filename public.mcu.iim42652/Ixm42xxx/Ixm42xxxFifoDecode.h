@@ -0,0 +1,81 @@
+/*
+ * __________________________________________________________________
+ *
+ * Copyright (C) [2022] by InvenSense, Inc.
+ * 
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY  AND FITNESS. IN NO EVENT SHALL
+ * THE AUTHOR BE LIABLE  FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ * __________________________________________________________________
+ */
+
+/** @defgroup DriverIxm42xxxFifoDecode Ixm42xxx FIFO packet decoder
+ *  @brief Decode fixed-layout FIFO packets into structure-of-arrays buffers
+ *  @ingroup  DriverIxm42xxx
+ *  @{
+ */
+
+/** @file Ixm42xxxFifoDecode.h
+ * Decode fixed-layout FIFO packets into structure-of-arrays buffers
+ */
+
+#ifndef _INV_IXM42XXX_FIFO_DECODE_H_
+#define _INV_IXM42XXX_FIFO_DECODE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "Ixm42xxxDriver_HL.h"
+
+#include <stdint.h>
+
+/** @brief Use NEON to decode FIFO packets
+ *  @details
+ *  Enabled by default when the compiler targets NEON (e.g. -mfpu=neon-vfpv4).
+ *  Set to 0 to always use the scalar reference decoder.
+ */
+#ifndef INV_IXM42XXX_FIFO_DECODE_NEON
+	#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define INV_IXM42XXX_FIFO_DECODE_NEON 1
+	#else
+		#define INV_IXM42XXX_FIFO_DECODE_NEON 0
+	#endif
+#endif
+
+/** @brief Decode accel, gyro, temperature and timestamp of FIFO packets sharing the same layout.
+ *  @param[in] fifo          FIFO content, starting on a packet header
+ *  @param[in] packet_count  number of packets to decode, must not exceed batch->capacity
+ *  @param[in] packet_size   FIFO_16BYTES_PACKET_SIZE or FIFO_20BYTES_PACKET_SIZE
+ *  @param[in] endian        IXM42XXX_INTF_CONFIG0_DATA_BIG_ENDIAN or IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN
+ *  @param[out] batch        accel, gyro, temperature and timestamp_fsync arrays are filled from index 0
+ *  @details
+ *  Every packet must hold accel, gyro, temperature and timestamp. Headers are not checked
+ *  and batch->sensor_mask, batch->count and batch->high_res are not modified.
+ *  20-bit accel and gyro are merged with their 4 LSB.
+ *  Uses NEON when INV_IXM42XXX_FIFO_DECODE_NEON is set, output is bit-identical to 
+ *  inv_ixm42xxx_decode_fifo_samples_ref().
+ */
+void inv_ixm42xxx_decode_fifo_samples(const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, 
+                                      uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch);
+
+/** @brief Scalar reference implementation of inv_ixm42xxx_decode_fifo_samples()
+ */
+void inv_ixm42xxx_decode_fifo_samples_ref(const uint8_t * fifo, uint16_t packet_count, uint8_t packet_size, 
+                                          uint8_t endian, inv_ixm42xxx_fifo_batch_t * batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _INV_IXM42XXX_FIFO_DECODE_H_ */
+
+/** @} */
@@ -0,0 +1,183 @@
+/*
+ * __________________________________________________________________
+ *
+ * Copyright (C) [2022] by InvenSense, Inc.
+ * 
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY  AND FITNESS. IN NO EVENT SHALL
+ * THE AUTHOR BE LIABLE  FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ * __________________________________________________________________
+ */
+
+#include "Ixm42xxxFifoWm.h"
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxTransport.h"
+#include "InvError.h"
+
+/* FIFO_CONFIG2/3 hold a 12-bit watermark */
+#define FIFO_WM_MAX             0x0FFF
+
+/* Headroom covers twice the service peak: one interrupt being handled late while the previous drain runs */
+#define FIFO_WM_HEADROOM_FACTOR 2
+
+/* Only raise the watermark when the target exceeds it by more than 1/2^FIFO_WM_RAISE_SHIFT */
+#define FIFO_WM_RAISE_SHIFT     3
+
+/* Smoothing of the average (1/8) and decay of the peak (1/16) per reported drain */
+#define FIFO_WM_AVG_SHIFT       3
+#define FIFO_WM_PEAK_DECAY_SHIFT 4
+
+static int get_fifo_odr_us(struct inv_ixm42xxx * s, uint32_t * odr_us)
+{
+	int status = 0;
+	uint8_t accel_cfg_0_reg, gyro_cfg_0_reg, pwr_mngt_0_reg;
+	uint32_t fastest_us = 0;
+	uint32_t accel_odr_us, gyro_odr_us;
+
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_ACCEL_CONFIG0, 1, &accel_cfg_0_reg);
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_GYRO_CONFIG0, 1, &gyro_cfg_0_reg);
+	status |= inv_ixm42xxx_read_reg(s, MPUREG_PWR_MGMT_0, 1, &pwr_mngt_0_reg);
+	if(status)
+		return status;
+
+	accel_odr_us = inv_ixm42xxx_convert_odr_bitfield_to_us(accel_cfg_0_reg & BIT_ACCEL_CONFIG0_ODR_MASK);
+	gyro_odr_us  = inv_ixm42xxx_convert_odr_bitfield_to_us(gyro_cfg_0_reg & BIT_GYRO_CONFIG0_ODR_MASK);
+
+	/* FIFO is written at the fastest ODR of running sensors */
+	if((pwr_mngt_0_reg & BIT_PWR_MGMT_0_ACCEL_MODE_MASK) != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF)
+		fastest_us = accel_odr_us;
+
+	if(((pwr_mngt_0_reg & BIT_PWR_MGMT_0_GYRO_MODE_MASK) != IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF) &&
+	   ((pwr_mngt_0_reg & BIT_PWR_MGMT_0_GYRO_MODE_MASK) != IXM42XXX_PWR_MGMT_0_GYRO_MODE_STANDBY))
+		if((fastest_us == 0) || (gyro_odr_us < fastest_us))
+			fastest_us = gyro_odr_us;
+
+	*odr_us = fastest_us;
+
+	return 0;
+}
+
+static uint16_t get_headroom(const inv_ixm42xxx_fifo_wm_ctrl_t * ctrl)
+{
+	return (uint16_t)((FIFO_WM_HEADROOM_FACTOR * ctrl->service_us_peak + ctrl->odr_us - 1) / ctrl->odr_us + 1);
+}
+
+static int program_wm(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl, uint16_t wm)
+{
+	int status;
+
+	status = inv_ixm42xxx_configure_fifo_wm(s, wm);
+	if(status == 0) {
+		ctrl->wm = wm;
+		ctrl->retune_count++;
+	}
+
+	return status;
+}
+
+uint16_t inv_ixm42xxx_fifo_wm_ctrl_target(const inv_ixm42xxx_fifo_wm_ctrl_t * ctrl)
+{
+	uint32_t headroom, wm_fifo, wm_latency, wm;
+
+	/* Sensors off: nothing to size, keep the current value */
+	if(ctrl->odr_us == 0)
+		return ctrl->wm;
+
+	/* Leave room for the packets written between the watermark crossing and the end of the drain */
+	headroom = get_headroom(ctrl);
+	wm_fifo = (ctrl->capacity > headroom) ? (ctrl->capacity - headroom) : 1;
+
+	/* First packet of a burst waits wm periods, then the service time */
+	if(ctrl->max_latency_us > ctrl->service_us_peak)
+		wm_latency = (ctrl->max_latency_us - ctrl->service_us_peak) / ctrl->odr_us;
+	else
+		wm_latency = 1;
+
+	wm = (wm_fifo < wm_latency) ? wm_fifo : wm_latency;
+	if(wm == 0)
+		wm = 1;
+	if(wm > FIFO_WM_MAX)
+		wm = FIFO_WM_MAX;
+
+	return (uint16_t)wm;
+}
+
+int inv_ixm42xxx_fifo_wm_ctrl_init(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl, uint32_t max_latency_us)
+{
+	if(max_latency_us == 0)
+		return INV_ERROR_BAD_ARG;
+
+	ctrl->max_latency_us = max_latency_us;
+	ctrl->odr_us = 0;
+	ctrl->capacity = 0;
+	ctrl->wm = s->fifo_wm;
+	ctrl->service_us_avg = IXM42XXX_FIFO_WM_DEFAULT_SERVICE_US;
+	ctrl->service_us_peak = IXM42XXX_FIFO_WM_DEFAULT_SERVICE_US;
+	ctrl->retune_count = 0;
+	ctrl->near_full_count = 0;
+
+	return inv_ixm42xxx_fifo_wm_ctrl_update_odr(s, ctrl);
+}
+
+int inv_ixm42xxx_fifo_wm_ctrl_update_odr(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl)
+{
+	int status;
+	uint16_t wm;
+
+	status = get_fifo_odr_us(s, &ctrl->odr_us);
+	if(status)
+		return status;
+
+	ctrl->capacity = IXM42XXX_FIFO_WM_FIFO_SIZE / 
+		(s->fifo_highres_enabled ? FIFO_20BYTES_PACKET_SIZE : FIFO_16BYTES_PACKET_SIZE);
+
+	wm = inv_ixm42xxx_fifo_wm_ctrl_target(ctrl);
+	if(wm == ctrl->wm)
+		return 0;
+
+	return program_wm(s, ctrl, wm);
+}
+
+int inv_ixm42xxx_fifo_wm_ctrl_report_drain(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl,
+                                           uint32_t drain_us, uint16_t packet_count)
+{
+	uint32_t service_us;
+	uint16_t wm;
+
+	if(ctrl->odr_us == 0)
+		return 0;
+
+	/* Packets beyond the watermark were written while the interrupt was pending */
+	service_us = drain_us;
+	if(packet_count > ctrl->wm)
+		service_us += (uint32_t)(packet_count - ctrl->wm) * ctrl->odr_us;
+
+	if(service_us >= ctrl->service_us_avg)
+		ctrl->service_us_avg += (service_us - ctrl->service_us_avg) >> FIFO_WM_AVG_SHIFT;
+	else
+		ctrl->service_us_avg -= (ctrl->service_us_avg - service_us) >> FIFO_WM_AVG_SHIFT;
+
+	if(service_us > ctrl->service_us_peak)
+		ctrl->service_us_peak = service_us;
+	else
+		ctrl->service_us_peak -= (ctrl->service_us_peak - service_us) >> FIFO_WM_PEAK_DECAY_SHIFT;
+
+	if((uint32_t)packet_count + get_headroom(ctrl) > ctrl->capacity)
+		ctrl->near_full_count++;
+
+	wm = inv_ixm42xxx_fifo_wm_ctrl_target(ctrl);
+
+	/* Lower at once to protect the FIFO, raise with hysteresis */
+	if((wm < ctrl->wm) || (wm > ctrl->wm + (ctrl->wm >> FIFO_WM_RAISE_SHIFT)))
+		return program_wm(s, ctrl, wm);
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * __________________________________________________________________
+ *
+ * Copyright (C) [2022] by InvenSense, Inc.
+ * 
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY  AND FITNESS. IN NO EVENT SHALL
+ * THE AUTHOR BE LIABLE  FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ * __________________________________________________________________
+ */
+
+/** @defgroup DriverIxm42xxxFifoWm Ixm42xxx FIFO watermark controller
+ *  @brief Size the FIFO watermark from ODR, latency budget and observed drain time
+ *  @ingroup  DriverIxm42xxx
+ *  @{
+ */
+
+/** @file Ixm42xxxFifoWm.h
+ * Size the FIFO watermark from ODR, latency budget and observed drain time
+ */
+
+#ifndef _INV_IXM42XXX_FIFO_WM_H_
+#define _INV_IXM42XXX_FIFO_WM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "Ixm42xxxDriver_HL.h"
+
+#include <stdint.h>
+
+/** @brief Hardware FIFO size in bytes */
+#define IXM42XXX_FIFO_WM_FIFO_SIZE          2048
+
+/** @brief Service time assumed before the first drain is reported, in us.
+ *  Covers interrupt wake-up and the drain itself. */
+#define IXM42XXX_FIFO_WM_DEFAULT_SERVICE_US 2000
+
+/** @brief Watermark controller state
+ *  @details
+ *  Service time is measured from the watermark crossing to the end of the drain: 
+ *  packets read beyond the watermark tell how late the interrupt was handled,
+ *  the drain duration is measured by the caller.
+ */
+typedef struct {
+	uint32_t max_latency_us;   /**< oldest sample must be delivered within this delay */
+	uint32_t odr_us;           /**< period of the fastest enabled sensor, 0 when both are off */
+	uint16_t capacity;         /**< packets the hardware FIFO holds with the current packet size */
+	uint16_t wm;               /**< watermark programmed in FIFO_CONFIG2/3 */
+	uint32_t service_us_avg;   /**< smoothed service time */
+	uint32_t service_us_peak;  /**< decaying peak of the service time, used for sizing */
+	uint32_t retune_count;     /**< watermark writes issued by the controller */
+	uint32_t near_full_count;  /**< drains that found the FIFO within the headroom of full */
+} inv_ixm42xxx_fifo_wm_ctrl_t;
+
+/** @brief Initialize the controller and program the first watermark
+ *  @param[out] ctrl           controller state
+ *  @param[in] max_latency_us  latency budget from sample acquisition to end of drain
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  Call once sensors are enabled, the ODR is read back from the device.
+ */
+int inv_ixm42xxx_fifo_wm_ctrl_init(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl, uint32_t max_latency_us);
+
+/** @brief Re-read ODR and packet size and reprogram the watermark
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  Call after an ODR change, a sensor enable/disable or a high resolution FIFO switch.
+ */
+int inv_ixm42xxx_fifo_wm_ctrl_update_odr(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl);
+
+/** @brief Report one drain and retune the watermark if needed
+ *  @param[in] drain_us      duration of inv_ixm42xxx_get_data_from_fifo()
+ *  @param[in] packet_count  packets returned by the drain
+ *  @return 0 on success, negative value on error.
+ *  @details
+ *  The watermark is lowered as soon as the FIFO headroom or the latency budget requires it,
+ *  and raised only when the target exceeds it by more than 1/8 to avoid rewriting it on every drain.
+ */
+int inv_ixm42xxx_fifo_wm_ctrl_report_drain(struct inv_ixm42xxx * s, inv_ixm42xxx_fifo_wm_ctrl_t * ctrl,
+                                           uint32_t drain_us, uint16_t packet_count);
+
+/** @brief Watermark the controller would program for the current state
+ */
+uint16_t inv_ixm42xxx_fifo_wm_ctrl_target(const inv_ixm42xxx_fifo_wm_ctrl_t * ctrl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _INV_IXM42XXX_FIFO_WM_H_ */
+
+/** @} */
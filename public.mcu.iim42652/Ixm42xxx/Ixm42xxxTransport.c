@@ -23,26 +23,96 @@
 #include "InvError.h"
 
 
+/* Shadowed registers: configuration registers grouped in ranges of consecutive addresses.
+ * slot is the index of the first register of the range in register_cache.shadow[].
+ */
+struct reg_shadow_range {
+	uint8_t bank;
+	uint8_t first;
+	uint8_t last;
+	uint8_t slot;
+};
+
+static const struct reg_shadow_range reg_shadow_table[] = {
+	/* Bank 0 */
+	{ 0, MPUREG_DRIVE_CONFIG,             MPUREG_INT_CONFIG,              0 },
+	{ 0, MPUREG_FIFO_CONFIG,              MPUREG_FIFO_CONFIG,             2 },
+	{ 0, MPUREG_INTF_CONFIG0,             MPUREG_SMD_CONFIG,              3 },
+	{ 0, MPUREG_FIFO_CONFIG1,             MPUREG_INT_SOURCE1,            15 },
+	{ 0, MPUREG_INT_SOURCE3,              MPUREG_INT_SOURCE4,            23 },
+	{ 0, MPUREG_SELF_TEST_CONFIG,         MPUREG_SELF_TEST_CONFIG,       25 },
+	/* Bank 1 */
+	{ 1, MPUREG_SENSOR_CONFIG,            MPUREG_SENSOR_CONFIG,          26 },
+	{ 1, MPUREG_GYRO_CONFIG_STATIC2_B1,   MPUREG_GYRO_CONFIG_STATIC10_B1, 27 },
+	{ 1, MPUREG_INTF_CONFIG4_B1,          MPUREG_INTF_CONFIG6_B1,        36 },
+	/* Bank 2 */
+	{ 2, MPUREG_ACCEL_CONFIG_STATIC2_B2,  MPUREG_ACCEL_CONFIG_STATIC4_B2, 39 },
+	/* Bank 3 */
+	{ 3, MPUREG_PU_PD_CONFIG1_B3,         MPUREG_PU_PD_CONFIG1_B3,       42 },
+	{ 3, MPUREG_PU_PD_CONFIG2_B3,         MPUREG_PU_PD_CONFIG2_B3,       43 },
+	/* Bank 4 */
+	{ 4, MPUREG_FDR_CONFIG_B4,            MPUREG_FDR_CONFIG_B4,          44 },
+	{ 4, MPUREG_APEX_CONFIG1_B4,          MPUREG_INT_SOURCE10_B4,        45 },
+	{ 4, MPUREG_OFFSET_USER_0_B4,         MPUREG_OFFSET_USER_8_B4,       63 },
+};
+
+/* Volatile registers: changed by the device, self-clearing or with side effects on access.
+ * They are never shadowed, even if a range above covers them.
+ */
+static const struct reg_shadow_range reg_volatile_table[] = {
+	{ 0, MPUREG_DEVICE_CONFIG,            MPUREG_DEVICE_CONFIG,          0 }, /* soft reset */
+	{ 0, MPUREG_TEMP_DATA1_UI,            MPUREG_INT_STATUS3,            0 }, /* data, status, FIFO */
+	{ 0, MPUREG_SIGNAL_PATH_RESET,        MPUREG_SIGNAL_PATH_RESET,      0 }, /* flush, strobes */
+	{ 0, MPUREG_APEX_CONFIG0 - 1,         MPUREG_APEX_CONFIG0,           0 }, /* reserved, DMP init/reset bits self-clear */
+	{ 0, MPUREG_FIFO_LOST_PKT0,           MPUREG_FIFO_LOST_PKT1,         0 },
+	{ 0, MPUREG_WHO_AM_I,                 MPUREG_REG_BANK_SEL,           0 }, /* bank selection is cached separately */
+	{ 1, MPUREG_XG_ST_DATA_B1,            MPUREG_TMST_VAL2_B1,           0 },
+	{ 2, MPUREG_XA_ST_DATA_B2,            MPUREG_ZA_ST_DATA_B2,          0 },
+};
+
+#define REG_SHADOW_RANGE_COUNT    (sizeof(reg_shadow_table) / sizeof(reg_shadow_table[0]))
+#define REG_VOLATILE_RANGE_COUNT  (sizeof(reg_volatile_table) / sizeof(reg_volatile_table[0]))
+#define REG_SHADOW_BANK_COUNT     5
+
 /* Function definition */
-static uint8_t * get_register_cache_addr(struct inv_ixm42xxx * s, uint8_t reg);
+static int get_shadow_slot(uint8_t bank, uint32_t reg);
+static int sync_bank(struct inv_ixm42xxx_transport *t);
+static int flush_range(struct inv_ixm42xxx_transport *t, const struct reg_shadow_range *range);
 static uint8_t is_aux_interface(struct inv_ixm42xxx_transport *t);
 
+static inline uint8_t test_bit(const uint8_t * map, int slot)
+{
+	return (map[slot >> 3] >> (slot & 7)) & 1;
+}
+
+static inline void set_bit(uint8_t * map, int slot)
+{
+	map[slot >> 3] |= (uint8_t)(1 << (slot & 7));
+}
+
+static inline void clear_bit(uint8_t * map, int slot)
+{
+	map[slot >> 3] &= (uint8_t)~(1 << (slot & 7));
+}
+
 
 int inv_ixm42xxx_init_transport(struct inv_ixm42xxx * s)
 {
-	// Registers in cache must be in bank 0
 	int status = 0;
 	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
 
-	if(!is_aux_interface(t)){
-		status |= t->serif.read_reg(&(t->serif), MPUREG_INTF_CONFIG1,  &(t->register_cache.intf_cfg_1_reg), 1);
-		status |= t->serif.read_reg(&(t->serif), MPUREG_PWR_MGMT_0,    &(t->register_cache.pwr_mngt_0_reg), 1);
-		status |= t->serif.read_reg(&(t->serif), MPUREG_GYRO_CONFIG0,  &(t->register_cache.gyro_cfg_0_reg), 1);
-		status |= t->serif.read_reg(&(t->serif), MPUREG_ACCEL_CONFIG0, &(t->register_cache.accel_cfg_0_reg), 1);
-		status |= t->serif.read_reg(&(t->serif), MPUREG_TMST_CONFIG,   &(t->register_cache.tmst_cfg_reg), 1);
-	}
+	inv_ixm42xxx_invalidate_reg_cache(s);
+	t->register_cache.mode = IXM42XXX_REG_CACHE_WRITE_THROUGH;
+	t->register_cache.batch_depth = 0;
 	
-	status |= t->serif.read_reg(&(t->serif), MPUREG_REG_BANK_SEL,  &(t->register_cache.bank_sel_reg), 1);
+	// Apply a pending bank selection, then read back the device one
+	status |= sync_bank(t);
+	t->stats.read_count++;
+	status |= t->serif.read_reg(&(t->serif), MPUREG_REG_BANK_SEL,  &(t->register_cache.bank_sel_dev), 1);
+	t->register_cache.bank_sel_reg = t->register_cache.bank_sel_dev;
+
+	// Shadow entries are filled on first access, bank selection is now known
+	t->register_cache.enabled = (status == 0) && !is_aux_interface(t);
 
 	return status;
 }
@@ -52,16 +122,16 @@ int inv_ixm42xxx_read_reg(struct inv_ixm42xxx * s, uint8_t reg, uint32_t len, ui
 	// First field of struct inv_ixm42xxx is assumed to be a struct inv_ixm42xxx_transport object.
 	// So let's cast s to struct inv_ixm42xxx_transport and ignore the rest of struct inv_ixm42xxx.
 	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	struct register_cache *c = &t->register_cache;
 	uint32_t i=0;
+	int slot;
 	
-	// Registers in cache are only in bank 0
-	// Check if bank0 is used because of duplicate register addresses between banks
 	// For AUX interface, register cache must not be used
-	if((t->register_cache.bank_sel_reg == 0) && (is_aux_interface(t) == 0)) {
+	if(c->enabled) {
 		for(i=0; i<len ; i++) {
-			uint8_t * cache_addr  = get_register_cache_addr(s, reg+i);
-			if(cache_addr)
-				buf[i] = *cache_addr;
+			slot = get_shadow_slot(c->bank_sel_reg, reg+i);
+			if((slot >= 0) && test_bit(c->valid, slot))
+				buf[i] = c->shadow[slot];
 			else
 				break; // If one register isn't in cache, exit the loop and proceed a physical access
 		}
@@ -73,8 +143,23 @@ int inv_ixm42xxx_read_reg(struct inv_ixm42xxx * s, uint8_t reg, uint32_t len, ui
 	// Physical access to read registers
 	if((len-i) > t->serif.max_read)
 		return INV_ERROR_SIZE;
+	if(sync_bank(t) != 0)
+		return INV_ERROR_TRANSPORT;
+	t->stats.read_count++;
 	if(t->serif.read_reg(&(t->serif), reg+i, &buf[i], len-i) != 0)
 		return INV_ERROR_TRANSPORT;
+
+	// Fill shadow with what was just read. FIFO_DATA does not auto-increment,
+	// bytes read past it are FIFO content and not register values.
+	if(c->enabled && !((c->bank_sel_reg == 0) && (reg+i <= MPUREG_FIFO_DATA) && (reg+len > MPUREG_FIFO_DATA))) {
+		for(; (i<len) && (reg+i < 0x80); i++) {
+			slot = get_shadow_slot(c->bank_sel_reg, reg+i);
+			if((slot >= 0) && !test_bit(c->dirty, slot)) {
+				c->shadow[slot] = buf[i];
+				set_bit(c->valid, slot);
+			}
+		}
+	}
 	
 	return 0;
 }
@@ -84,52 +169,260 @@ int inv_ixm42xxx_write_reg(struct inv_ixm42xxx * s, uint8_t reg, uint32_t len, c
 	// First field of struct inv_ixm42xxx is assumed to be a struct inv_ixm42xxx_transport object.
 	// So let's cast s to struct inv_ixm42xxx_transport and ignore the rest of struct inv_ixm42xxx.
 	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	struct register_cache *c = &t->register_cache;
 	uint32_t i;
+	uint8_t all_shadowed = 1, unchanged = 1;
+	int slot;
+	int status;
 	
 	if(len > t->serif.max_write)
 		return INV_ERROR_SIZE;
-	
+
+	// Bank selection only reaches the device before the next physical access
+	if((reg == MPUREG_REG_BANK_SEL) && (len == 1)) {
+		c->bank_sel_reg = buf[0];
+		t->stats.bank_sel_requests++;
+		return 0;
+	}
 	
 	for(i=0; i<len; i++) {
-		// Update bank_sel_reg in the cache
-		if((reg+i) == MPUREG_REG_BANK_SEL){
-			t->register_cache.bank_sel_reg = buf[i];
+		slot = get_shadow_slot(c->bank_sel_reg, reg+i);
+		if(slot < 0) {
+			all_shadowed = 0;
+			unchanged = 0;
+		}
+		else if(is_aux_interface(t)) {
+			return INV_ERROR_BAD_ARG; // Cached registers must not be written from AUX interface
+		}
+		else if(!test_bit(c->valid, slot) || (c->shadow[slot] != buf[i])) {
+			unchanged = 0;
+		}
+	}
+
+	if(c->enabled && all_shadowed) {
+		// Value already in the device (or pending), no bus access needed
+		if(unchanged) {
+			t->stats.write_skipped++;
+			return 0;
 		}
-		else {
-			uint8_t * cache_addr  = get_register_cache_addr(s, reg+i);
-			if(cache_addr){
-				if (t->register_cache.bank_sel_reg == 0){
-					if(is_aux_interface(t) == 1)
-						return INV_ERROR_BAD_ARG; // Cached registers must not be written from AUX interface
-					else
-						*cache_addr = buf[i]; // Update register cache if the current bank is 0
-				}
+
+		if(c->mode == IXM42XXX_REG_CACHE_WRITE_BACK) {
+			for(i=0; i<len; i++) {
+				slot = get_shadow_slot(c->bank_sel_reg, reg+i);
+				c->shadow[slot] = buf[i];
+				set_bit(c->valid, slot);
+				set_bit(c->dirty, slot);
 			}
+			return 0;
 		}
 	}
+
+	// Registers outside the shadow are written in program order: pending writes go first
+	if(c->enabled && !all_shadowed && (c->mode == IXM42XXX_REG_CACHE_WRITE_BACK)) {
+		status = inv_ixm42xxx_flush_reg_cache(s);
+		if(status)
+			return status;
+	}
 	
 	// Physical access to write registers
-	if(t->serif.write_reg(&(t->serif), reg, buf, len) != 0)
+	if(sync_bank(t) != 0)
 		return INV_ERROR_TRANSPORT;
+	t->stats.write_count++;
+	status = t->serif.write_reg(&(t->serif), reg, buf, len);
+	
+	for(i=0; i<len; i++) {
+		// Update bank_sel_reg in the cache when a burst write covers it
+		if((reg+i) == MPUREG_REG_BANK_SEL) {
+			c->bank_sel_reg = buf[i];
+			c->bank_sel_dev = (status == 0) ? buf[i] : 0xFF;
+		}
+		else if(c->enabled) {
+			slot = get_shadow_slot(c->bank_sel_reg, reg+i);
+			if(slot < 0)
+				continue;
+			clear_bit(c->dirty, slot);
+			if(status == 0) {
+				c->shadow[slot] = buf[i];
+				set_bit(c->valid, slot);
+			} else {
+				clear_bit(c->valid, slot); // Device content unknown
+			}
+		}
+	}
+
+	if(status != 0)
+		return INV_ERROR_TRANSPORT;
+
+	// Soft reset restores every register: shadow is off until inv_ixm42xxx_init_transport() runs again
+	if((c->bank_sel_reg == 0) && (reg == MPUREG_DEVICE_CONFIG) && (buf[0] & IXM42XXX_DEVICE_CONFIG_RESET_EN)) {
+		inv_ixm42xxx_invalidate_reg_cache(s);
+		c->enabled = 0;
+		c->bank_sel_dev = 0;
+	}
 
 	return 0;
 }
 
-/* Static function */
+int inv_ixm42xxx_set_reg_cache_mode(struct inv_ixm42xxx * s, IXM42XXX_REG_CACHE_MODE_t mode)
+{
+	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	int status = 0;
+
+	if((mode != IXM42XXX_REG_CACHE_WRITE_THROUGH) && (mode != IXM42XXX_REG_CACHE_WRITE_BACK))
+		return INV_ERROR_BAD_ARG;
+
+	if(mode == IXM42XXX_REG_CACHE_WRITE_THROUGH)
+		status = inv_ixm42xxx_flush_reg_cache(s);
+
+	t->register_cache.mode = mode;
+
+	return status;
+}
+
+int inv_ixm42xxx_flush_reg_cache(struct inv_ixm42xxx * s)
+{
+	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	struct register_cache *c = &t->register_cache;
+	uint8_t bank_bk = c->bank_sel_reg;
+	uint8_t bank_first = c->bank_sel_dev;
+	uint32_t r;
+	int status = 0;
 
-/* MPUREG_REG_BANK_SEL shall never be added to the function get_register_cache_addr() */
-static uint8_t * get_register_cache_addr(struct inv_ixm42xxx * s, uint8_t reg)
+	// Bank the device is on goes first, then the other banks in ascending order
+	for(r=0; r<REG_SHADOW_RANGE_COUNT; r++) {
+		if(reg_shadow_table[r].bank == bank_first)
+			status |= flush_range(t, &reg_shadow_table[r]);
+	}
+	for(r=0; r<REG_SHADOW_RANGE_COUNT; r++) {
+		if(reg_shadow_table[r].bank != bank_first)
+			status |= flush_range(t, &reg_shadow_table[r]);
+	}
+
+	c->bank_sel_reg = bank_bk;
+
+	return status;
+}
+
+int inv_ixm42xxx_begin_bank_batch(struct inv_ixm42xxx * s)
+{
+	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	struct register_cache *c = &t->register_cache;
+
+	if(c->batch_depth == 0xFF)
+		return INV_ERROR_SIZE;
+
+	if(c->batch_depth++ == 0) {
+		c->batch_saved_mode = c->mode;
+		c->mode = IXM42XXX_REG_CACHE_WRITE_BACK;
+	}
+
+	return 0;
+}
+
+int inv_ixm42xxx_end_bank_batch(struct inv_ixm42xxx * s)
 {
 	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	struct register_cache *c = &t->register_cache;
+
+	if(c->batch_depth == 0)
+		return INV_ERROR;
+
+	if(--c->batch_depth > 0)
+		return 0;
+
+	return inv_ixm42xxx_set_reg_cache_mode(s, c->batch_saved_mode);
+}
+
+void inv_ixm42xxx_invalidate_reg_cache(struct inv_ixm42xxx * s)
+{
+	struct inv_ixm42xxx_transport *t = (struct inv_ixm42xxx_transport *)s;
+	uint32_t i;
+
+	for(i=0; i<sizeof(t->register_cache.valid); i++) {
+		t->register_cache.valid[i] = 0;
+		t->register_cache.dirty[i] = 0;
+	}
+}
+
+/* Static function */
+
+/* Write REG_BANK_SEL if the device is not on the bank selected by the driver */
+static int sync_bank(struct inv_ixm42xxx_transport *t)
+{
+	struct register_cache *c = &t->register_cache;
+
+	if(c->bank_sel_dev == c->bank_sel_reg)
+		return 0;
+
+	t->stats.write_count++;
+	t->stats.bank_switch_count++;
+	if(t->serif.write_reg(&(t->serif), MPUREG_REG_BANK_SEL, &c->bank_sel_reg, 1) != 0) {
+		c->bank_sel_dev = 0xFF;
+		return INV_ERROR_TRANSPORT;
+	}
+	c->bank_sel_dev = c->bank_sel_reg;
+
+	return 0;
+}
+
+/* MPUREG_REG_BANK_SEL shall never be shadowed, it is tracked by register_cache.bank_sel_reg */
+/* Write the dirty entries of one shadow range, leaves bank_sel_reg on the range bank */
+static int flush_range(struct inv_ixm42xxx_transport *t, const struct reg_shadow_range *range)
+{
+	struct register_cache *c = &t->register_cache;
+	uint32_t addr, n;
+	int slot, status = 0;
+
+	addr = range->first;
+	while(addr <= range->last) {
+		slot = range->slot + (addr - range->first);
+		if(!test_bit(c->dirty, slot)) {
+			addr++;
+			continue;
+		}
 
-	switch(reg) {
-		case MPUREG_INTF_CONFIG1:     return &(t->register_cache.intf_cfg_1_reg);
-		case MPUREG_PWR_MGMT_0:       return &(t->register_cache.pwr_mngt_0_reg);
-		case MPUREG_GYRO_CONFIG0:     return &(t->register_cache.gyro_cfg_0_reg);
-		case MPUREG_ACCEL_CONFIG0:    return &(t->register_cache.accel_cfg_0_reg);
-		case MPUREG_TMST_CONFIG:      return &(t->register_cache.tmst_cfg_reg);
-		default:                      return (uint8_t *)0; // Not found
+		// Merge contiguous dirty registers of the range into one write
+		n = 1;
+		while((addr + n <= range->last) && test_bit(c->dirty, slot + n) && (n < t->serif.max_write))
+			n++;
+
+		// Ranges are sorted by bank: at most one switch per bank holding dirty registers
+		c->bank_sel_reg = range->bank;
+		if(sync_bank(t) != 0)
+			return INV_ERROR_TRANSPORT;
+
+		t->stats.write_count++;
+		if(t->serif.write_reg(&(t->serif), (uint8_t)addr, &c->shadow[slot], n) != 0)
+			status = INV_ERROR_TRANSPORT;
+
+		for(; n > 0; n--, slot++, addr++) {
+			clear_bit(c->dirty, slot);
+			if(status)
+				clear_bit(c->valid, slot);
+		}
 	}
+
+	return status;
+}
+
+static int get_shadow_slot(uint8_t bank, uint32_t reg)
+{
+	uint32_t r;
+
+	if(bank >= REG_SHADOW_BANK_COUNT)
+		return -1;
+
+	for(r=0; r<REG_VOLATILE_RANGE_COUNT; r++) {
+		if((reg_volatile_table[r].bank == bank) && (reg >= reg_volatile_table[r].first) && (reg <= reg_volatile_table[r].last))
+			return -1;
+	}
+
+	for(r=0; r<REG_SHADOW_RANGE_COUNT; r++) {
+		if((reg_shadow_table[r].bank == bank) && (reg >= reg_shadow_table[r].first) && (reg <= reg_shadow_table[r].last))
+			return reg_shadow_table[r].slot + (int)(reg - reg_shadow_table[r].first);
+	}
+
+	return -1;
 }
 
 static uint8_t is_aux_interface(struct inv_ixm42xxx_transport *t)
@@ -64,25 +64,49 @@ struct inv_ixm42xxx_serif {
 	IXM42XXX_SERIAL_IF_TYPE_t serif_type;
 };
 
+/** @brief Number of configuration registers shadowed by the transport, all banks included.
+ *  Must match the shadow table in Ixm42xxxTransport.c.
+ */
+#define IXM42XXX_REG_SHADOW_SIZE 72
+
+/** @brief Write policy of the register shadow
+ */
+typedef enum {
+	IXM42XXX_REG_CACHE_WRITE_THROUGH = 0, /**< Every write reaches the device, writes of unchanged values are skipped */
+	IXM42XXX_REG_CACHE_WRITE_BACK    = 1, /**< Writes to shadowed registers only mark them dirty until inv_ixm42xxx_flush_reg_cache() */
+} IXM42XXX_REG_CACHE_MODE_t;
+
 /** @brief transport interface
  */
 struct inv_ixm42xxx_transport {
 	struct inv_ixm42xxx_serif serif; /**< Warning : this field MUST be the first one of struct inv_ixm42xxx_transport */
 
-	/** @brief Contains mirrored values of some IP registers */
+	/** @brief Contains mirrored values of the configuration registers of all banks */
 	struct register_cache {
-		uint8_t intf_cfg_1_reg;   /**< INTF_CONFIG1, Bank: 0, Address: 0x4D */
-		uint8_t pwr_mngt_0_reg;   /**< PWR_MGMT_0, Bank: 0, Address: 0x4E */
-		uint8_t gyro_cfg_0_reg;   /**< GYRO_CONFIG0, Bank: 0, Address: 0x4F */
-		uint8_t accel_cfg_0_reg;  /**< ACCEL_CONFIG0, Bank: 0, Address: 0x50 */
-		uint8_t tmst_cfg_reg;     /**< TMST_CONFIG, Bank: 0, Address: 0x54 */
-		uint8_t bank_sel_reg;     /**< MPUREG_REG_BANK_SEL, All banks, Address 0x76*/
-	} register_cache; /**< Store mostly used register values on SRAM. 
-	                    *  MPUREG_OTP_SEC_STATUS_B1 and MPUREG_INT_STATUS registers
-	                    *  are read before the cache has a chance to be initialized. 
-	                    *  Therefore, these registers shall never be added to the cache 
-						*  Registers from bank 1,2,3 or 4 shall never be added to the cache
+		uint8_t shadow[IXM42XXX_REG_SHADOW_SIZE];          /**< Last value read from or written to each shadowed register */
+		uint8_t valid[(IXM42XXX_REG_SHADOW_SIZE + 7) / 8]; /**< Bitmap, shadow entry holds the device value */
+		uint8_t dirty[(IXM42XXX_REG_SHADOW_SIZE + 7) / 8]; /**< Bitmap, shadow entry not written to the device yet */
+		uint8_t bank_sel_reg;     /**< MPUREG_REG_BANK_SEL, All banks, Address 0x76. Bank selected by the driver */
+		uint8_t bank_sel_dev;     /**< Bank selected in the device, written lazily before the next physical access. 0xFF if unknown */
+		uint8_t batch_depth;      /**< Nesting level of inv_ixm42xxx_begin_bank_batch() */
+		IXM42XXX_REG_CACHE_MODE_t batch_saved_mode; /**< Write policy restored by the outermost inv_ixm42xxx_end_bank_batch() */
+		uint8_t enabled;          /**< Shadow in use, set by inv_ixm42xxx_init_transport() and cleared by a soft reset */
+		IXM42XXX_REG_CACHE_MODE_t mode; /**< Write policy, write-through by default */
+	} register_cache; /**< Store configuration register values on SRAM. 
+	                    *  Entries are filled on first access: the shadow is only enabled by inv_ixm42xxx_init_transport(),
+	                    *  once the bank selection is known after soft reset.
+	                    *  Status, data, FIFO and self-clearing registers are blacklisted and always read from the device.
+	                    *  The shadow is not used on AUX interfaces, and shadowed registers shall not be written from them.
 	                    */
+
+	/** @brief Bus activity counters, never reset by the driver */
+	struct transport_stats {
+		uint32_t read_count;          /**< serif read_reg calls */
+		uint32_t write_count;         /**< serif write_reg calls, bank selection included */
+		uint32_t bank_sel_requests;   /**< REG_BANK_SEL writes requested by the driver */
+		uint32_t bank_switch_count;   /**< REG_BANK_SEL writes that reached the device */
+		uint32_t write_skipped;       /**< writes of shadowed registers dropped because the value was unchanged */
+	} stats;
 };
 
 /** @brief Init cache variable.
@@ -106,6 +130,46 @@ int inv_ixm42xxx_read_reg(struct inv_ixm42xxx * s, uint8_t reg, uint32_t len, ui
  */
 int inv_ixm42xxx_write_reg(struct inv_ixm42xxx * s, uint8_t reg, uint32_t len, const uint8_t * buf);
 
+/** @brief Select the register shadow write policy.
+ * @param[in] mode   IXM42XXX_REG_CACHE_WRITE_THROUGH or IXM42XXX_REG_CACHE_WRITE_BACK
+ * @return            0 in case of success, negative value on error
+ * @details
+ * Switching back to write-through flushes pending writes first.
+ */
+int inv_ixm42xxx_set_reg_cache_mode(struct inv_ixm42xxx * s, IXM42XXX_REG_CACHE_MODE_t mode);
+
+/** @brief Write dirty shadow entries to the device.
+ * @return            0 in case of success, negative value on error
+ * @details
+ * Entries are written bank by bank in ascending address order, starting with the bank
+ * the device is on, contiguous dirty registers being merged into one write of at most
+ * serif.max_write bytes.
+ * The bank selected by the driver is unchanged, the device one is restored lazily.
+ */
+int inv_ixm42xxx_flush_reg_cache(struct inv_ixm42xxx * s);
+
+/** @brief Start grouping register writes by bank.
+ * @return            0 in case of success, negative value on error
+ * @details
+ * Until the matching inv_ixm42xxx_end_bank_batch(), writes to shadowed registers are
+ * held in the shadow (write-back) and reads of shadowed registers are served from it,
+ * whatever bank they belong to. The outermost end writes them with one bank switch per bank.
+ * Calls may be nested. Only use it around sequences that do not depend on the order
+ * of writes across registers, e.g. disable interrupt / change threshold / enable interrupt
+ * would collapse into a single threshold write.
+ */
+int inv_ixm42xxx_begin_bank_batch(struct inv_ixm42xxx * s);
+
+/** @brief Close a batch opened by inv_ixm42xxx_begin_bank_batch()
+ * @return            0 in case of success, negative value on error
+ */
+int inv_ixm42xxx_end_bank_batch(struct inv_ixm42xxx * s);
+
+/** @brief Drop every shadow entry, next accesses read the device again.
+ * Pending writes are lost.
+ */
+void inv_ixm42xxx_invalidate_reg_cache(struct inv_ixm42xxx * s);
+
 /** @brief Enable MCLK so that MREG are clocked and system beyond SOI can be safely accessed
  * @param[out] idle_en Value of IDLE bit prior to function access, this might be useful to understand if MCLK was already enabled or not
  * @return            0 in case of success, -1 for any error
@@ -17,6 +17,9 @@
  * __________________________________________________________________
  */
 
+#include <math.h>
+#include <string.h>
+
 #include "Message.h"
 
 
@@ -25,9 +28,7 @@
 
 
 /* forward declaration */
-static int clock_calibration_initial(struct inv_ixm42xxx * s, struct clk_calib *clk_cal);
-static int clock_calibration_update_coef(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, uint8_t *on_going, uint64_t irq_timestamp, uint16_t fifo_timestamp);
-static int get_fastest_running_odr(struct inv_ixm42xxx * s, uint32_t *odr);
+static void clock_calibration_add_pair(struct clk_calib *clk_cal, uint64_t irq_timestamp, uint16_t fifo_timestamp);
 static enum inv_ixm42xxx_sensor get_fastest_sensor(struct inv_ixm42xxx * s);
 
 static enum inv_ixm42xxx_clock_source get_current_clock_source(struct inv_ixm42xxx * s)
@@ -58,9 +59,9 @@ static enum inv_ixm42xxx_clock_source get_current_clock_source(struct inv_ixm42x
 		return INV_IXM42XXX_WU_OSC;
 }
 
-static char * get_current_clock_source_name(struct inv_ixm42xxx * s)
+static char * get_clock_source_name(enum inv_ixm42xxx_clock_source source)
 {
-	switch(get_current_clock_source(s)) {
+	switch(source) {
 		case INV_IXM42XXX_PLL:    return "PLL";
 		case INV_IXM42XXX_RC_OSC: return "RC_OSC";
 		case INV_IXM42XXX_WU_OSC: return "WU_OSC";
@@ -68,24 +69,231 @@ static char * get_current_clock_source_name(struct inv_ixm42xxx * s)
 	}
 }
 
-static int64_t apply_time_factor(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, float dt_fifo)
+/*
+ * Resolution times coefficient in us Q32: 16 us at most, so 2^36 and a product with a
+ * burst worth of ticks stays far below 2^64
+ */
+static void update_scale(struct clk_calib *clk_cal)
 {
-	// Retrieve coef that needs to be applied
-	float time_factor = clk_cal->coef[get_current_clock_source(s)];
+	float coef = 1.0f;
 
-	float dt_float = ((dt_fifo) * (time_factor)) + clk_cal->dt_error;
-	clk_cal->dt_error = dt_float - (int64_t)(dt_float);
-	return (int64_t)(dt_float);
+	if (!clk_cal->rtc && clk_cal->cur_source < INV_IXM42XXX_CLOCK_SOURCE_MAX)
+		coef = clk_cal->coef[clk_cal->cur_source];
+
+	clk_cal->us_per_tick_q32 = (uint64_t)((double)clk_cal->res_us_q24 * (1UL<<8) * coef + 0.5);
 }
 
-static float get_fifo_timestamp_resolution(struct inv_ixm42xxx * s)
+/*
+ * FIFO timestamp ticks elapsed between two packets, equal timestamps mean a full rollover
+ */
+static uint32_t get_dt_ticks(uint16_t cur_fifo_timestamp, uint16_t last_fifo_timestamp)
 {
-	return (float)inv_ixm42xxx_get_fifo_timestamp_resolution_us_q24(s)/(1UL<<24);
+	uint32_t dt_ticks = (uint16_t)(cur_fifo_timestamp - last_fifo_timestamp);
+
+	return dt_ticks ? dt_ticks : ROLLOVER_16BITS;
 }
 
-static float get_reg_timestamp_resolution(struct inv_ixm42xxx * s)
+/*
+ * Forget the tracked line; keep_ticks keeps the FIFO timestamp continuity, so that the next
+ * interrupt anchors the line on the same timeline
+ */
+static void tracker_unlock(struct clk_calib *clk_cal, int keep_ticks)
 {
-	return (float)inv_ixm42xxx_get_reg_timestamp_resolution_us_q24(s)/(1UL<<24);
+	clk_cal->trk.locked = 0;
+	clk_cal->trk.rejected = 0;
+	if (!keep_ticks)
+		clk_cal->trk.started = 0;
+}
+
+/*
+ * Configuration the timestamps depend on (all registers involved are served by the register shadow)
+ */
+static void read_config(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
+{
+	clk_cal->rtc = (uint8_t)inv_ixm42xxx_get_clkin_rtc_status(s);
+	clk_cal->cur_source = get_current_clock_source(s);
+	clk_cal->fastest_sensor = get_fastest_sensor(s);
+	clk_cal->res_us_q24 = inv_ixm42xxx_get_fifo_timestamp_resolution_us_q24(s);
+}
+
+/*
+ * Read the configuration once per FIFO read instead of once per packet. When FIFO is decoded
+ * apart from the reads (see inv_ixm42xxx_set_fifo_decode_detached()), the bus is not accessed
+ * and the configuration read by clock_calibration_init() is kept.
+ */
+static void start_drain(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, uint64_t irq_timestamp)
+{
+	clk_calib_tracker_t *trk = &clk_cal->trk;
+	enum inv_ixm42xxx_clock_source prev_source = clk_cal->cur_source;
+	uint32_t prev_res_us_q24 = clk_cal->res_us_q24;
+	uint16_t wm = clk_cal->drain_wm ? clk_cal->drain_wm : s->fifo_wm;
+
+	clk_cal->drain_irq_timestamp = irq_timestamp;
+	clk_cal->drain_packets = 0;
+	clk_cal->irq_packet = wm ? wm - 1 : 0;
+	if (!s->fifo_decode_detached)
+		read_config(s, clk_cal);
+	update_scale(clk_cal);
+
+	if (clk_cal->res_us_q24 != prev_res_us_q24) {
+		// Ticks of another length, the timeline starts over
+		tracker_unlock(clk_cal, 0);
+	} else if (clk_cal->cur_source != prev_source && trk->locked) {
+		// Move the reference to the last packet and restart the rate from the new oscillator
+		trk->host_us += trk->us_per_tick * (double)(int64_t)(trk->ticks - trk->ref_ticks);
+		trk->ref_ticks = trk->ticks;
+		trk->us_per_tick = (double)clk_cal->us_per_tick_q32 / 4294967296.0;
+		trk->p01 = 0;
+		trk->p11 = trk->us_per_tick * clock_calibration_get_uncertainty_ppm(clk_cal, clk_cal->cur_source) / 1e6;
+		trk->p11 *= trk->p11;
+	}
+}
+
+static uint64_t tracker_advance(struct clk_calib *clk_cal, uint16_t cur_fifo_timestamp)
+{
+	clk_calib_tracker_t *trk = &clk_cal->trk;
+
+	if (trk->started)
+		trk->ticks += get_dt_ticks(cur_fifo_timestamp, trk->last_fifo);
+	trk->started = 1;
+	trk->last_fifo = cur_fifo_timestamp;
+
+	return trk->ticks;
+}
+
+/*
+ * Evaluate the tracked line at base_ticks, timestamps of the next packets are computed from it
+ */
+static void tracker_rebase(struct clk_calib *clk_cal, uint64_t base_ticks)
+{
+	clk_calib_tracker_t *trk = &clk_cal->trk;
+	double host_us = trk->host_us + trk->us_per_tick * (double)(int64_t)(base_ticks - trk->ref_ticks);
+
+	if (host_us < 0)
+		host_us = 0;
+	trk->base_ticks = base_ticks;
+	trk->base_us = (uint64_t)host_us;
+	trk->base_frac = (uint32_t)((host_us - (double)trk->base_us) * 4294967296.0);
+	trk->scale_q32 = (uint64_t)(trk->us_per_tick * 4294967296.0 + 0.5);
+}
+
+/*
+ * Rebase when packets get too far from the base point, so that ticks times scale stays within 64 bits
+ */
+#define CLOCK_TRACKER_REBASE_TICKS (1UL<<24)
+
+static uint64_t tracker_eval(struct clk_calib *clk_cal, uint64_t ticks)
+{
+	clk_calib_tracker_t *trk = &clk_cal->trk;
+	uint64_t timestamp;
+
+	if (ticks - trk->base_ticks > CLOCK_TRACKER_REBASE_TICKS)
+		tracker_rebase(clk_cal, ticks);
+
+	timestamp = trk->base_us + (((ticks - trk->base_ticks) * trk->scale_q32 + trk->base_frac) >> 32);
+
+	// A correction never moves time backwards
+	if (timestamp <= trk->last_sent)
+		timestamp = trk->last_sent + 1;
+	trk->last_sent = timestamp;
+
+	return timestamp;
+}
+
+/*
+ * Kalman update of the tracked line with the interrupt raised by the packet at ticks
+ * @return 1 if the line changed, 0 if the interrupt was refused
+ */
+static int tracker_observe(struct clk_calib *clk_cal, uint64_t irq_timestamp, uint64_t ticks)
+{
+	clk_calib_tracker_t *trk = &clk_cal->trk;
+	double res_us = (double)clk_cal->res_us_q24 / (1UL<<24);
+	double r = CLOCK_TRACKER_IRQ_NOISE_US * CLOCK_TRACKER_IRQ_NOISE_US + res_us * res_us / 12;
+	double d, dt_s, h, p00, p01, p11, y, sk, k0, k1, q;
+
+	if (!trk->locked || trk->rejected >= CLOCK_TRACKER_MAX_REJECT) {
+		// Anchor on this interrupt, keep the rate already tracked if any
+		if (!trk->locked) {
+			trk->us_per_tick = (double)clk_cal->us_per_tick_q32 / 4294967296.0;
+			trk->p11 = trk->us_per_tick * clock_calibration_get_uncertainty_ppm(clk_cal, clk_cal->cur_source) / 1e6;
+			trk->p11 *= trk->p11;
+		}
+		trk->locked = 1;
+		trk->rejected = 0;
+		trk->ref_ticks = ticks;
+		trk->host_us = (double)irq_timestamp;
+		trk->p00 = r;
+		trk->p01 = 0;
+		trk->observations++;
+		return 1;
+	}
+
+	// Predict to the packet
+	d = (double)(int64_t)(ticks - trk->ref_ticks);
+	dt_s = (d < 0 ? -d : d) * trk->us_per_tick / 1e6;
+	q = CLOCK_TRACKER_SKEW_NOISE_PPM / 1e6 * trk->us_per_tick;
+	h = trk->host_us + trk->us_per_tick * d;
+	p00 = trk->p00 + 2 * d * trk->p01 + d * d * trk->p11 + CLOCK_TRACKER_OFFSET_NOISE_US * CLOCK_TRACKER_OFFSET_NOISE_US * dt_s;
+	p01 = trk->p01 + d * trk->p11;
+	p11 = trk->p11 + q * q * dt_s;
+
+	// Refuse an interrupt far from the line (packets lost, late timestamp)
+	y = (double)irq_timestamp - h;
+	sk = p00 + r;
+	if (y * y > CLOCK_TRACKER_OUTLIER_SIGMA * CLOCK_TRACKER_OUTLIER_SIGMA * sk) {
+		trk->outliers++;
+		trk->rejected++;
+		return 0;
+	}
+
+	// Correct
+	k0 = p00 / sk;
+	k1 = p01 / sk;
+	trk->ref_ticks = ticks;
+	trk->host_us = h + k0 * y;
+	trk->us_per_tick += k1 * y;
+	trk->p00 = (1 - k0) * p00;
+	trk->p01 = (1 - k0) * p01;
+	trk->p11 = p11 - k1 * p01;
+	trk->rejected = 0;
+	trk->observations++;
+
+	return 1;
+}
+
+static void reset_sensor_timeline(struct clk_calib *clk_cal, enum inv_ixm42xxx_sensor sensor, uint64_t timestamp)
+{
+	clk_cal->last_timestamp_sent[sensor] = timestamp;
+	clk_cal->last_timestamp_frac[sensor] = 0;
+}
+
+/*
+ * Reference sensor of a packet, INV_IXM42XXX_SENSOR_MAX if it has neither accel nor gyro
+ */
+static enum inv_ixm42xxx_sensor get_reference_sensor(struct clk_calib *clk_cal, int sensor_mask)
+{
+	if ((sensor_mask & (1 << INV_IXM42XXX_SENSOR_ACCEL)) && (sensor_mask & (1 << INV_IXM42XXX_SENSOR_GYRO)))
+		return clk_cal->fastest_sensor; // ACC and GYR are in FIFO, use the fastest sensor
+	else if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_ACCEL))
+		return INV_IXM42XXX_SENSOR_ACCEL;
+	else if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_GYRO))
+		return INV_IXM42XXX_SENSOR_GYRO;
+	else
+		return INV_IXM42XXX_SENSOR_MAX;
+}
+
+static void save_sensor_timeline(struct clk_calib *clk_cal, int sensor_mask, enum inv_ixm42xxx_sensor sensor_ref, uint16_t cur_fifo_timestamp)
+{
+	int i;
+
+	for (i = INV_IXM42XXX_SENSOR_ACCEL; i <= INV_IXM42XXX_SENSOR_GYRO; i++) {
+		if (!(sensor_mask & (1 << i)) || i == (int)sensor_ref)
+			continue;
+		clk_cal->last_fifo_timestamp[i] = cur_fifo_timestamp;
+		clk_cal->last_timestamp_sent[i] = clk_cal->last_timestamp_sent[sensor_ref];
+		clk_cal->last_timestamp_frac[i] = clk_cal->last_timestamp_frac[sensor_ref];
+	}
+	clk_cal->last_fifo_timestamp[sensor_ref] = cur_fifo_timestamp;
 }
 
 int inv_helper_extend_timestamp_from_fifo(struct inv_ixm42xxx * s, 
@@ -96,11 +304,12 @@ int inv_helper_extend_timestamp_from_fifo(struct inv_ixm42xxx * s,
 	                                      uint64_t * timestamp)
 {
 	enum inv_ixm42xxx_sensor sensor_ref;
-	float dt_fifo;
-	int64_t dt_us;
+	uint64_t dt_q32, ticks;
+	uint16_t packet;
 
-	// by default we assume there is nothing in FIFO. timestamp is reset.
-	*timestamp = 0;
+	if (irq_timestamp != clk_cal->drain_irq_timestamp)
+		start_drain(s, clk_cal, irq_timestamp);
+	packet = clk_cal->drain_packets++;
 
 	// If FSYNC event is received, the FSYNC delay will replace the timestamp field
 	if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_FSYNC_EVENT)) { 
@@ -108,72 +317,164 @@ int inv_helper_extend_timestamp_from_fifo(struct inv_ixm42xxx * s,
 		*timestamp = irq_timestamp;
 		clk_cal->last_fifo_timestamp[INV_IXM42XXX_SENSOR_ACCEL] = 0xDEADBEEF;
 		clk_cal->last_fifo_timestamp[INV_IXM42XXX_SENSOR_GYRO] = 0xDEADBEEF;
-		clk_cal->dt_error = 0; // reset error on deltatime*/
 		return 0;
-	} else if (!inv_ixm42xxx_get_clkin_rtc_status(s)) { 
-		// Update calibration coefficient unless RTC is enabled
-		clock_calibration_update(s, clk_cal, irq_timestamp, cur_fifo_timestamp);	
 	}
 
 	// Select which sensor to use for reference (sensor_ref) depending on FIFO content
-	if ((sensor_mask & (1 << INV_IXM42XXX_SENSOR_ACCEL)) && (sensor_mask & (1 << INV_IXM42XXX_SENSOR_GYRO))) {
-		// ACC and GYR are in FIFO, use the fastest sensor
-		sensor_ref = get_fastest_sensor(s);
-	} else if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_ACCEL)) {
-		// ACC in FIFO
-		sensor_ref = INV_IXM42XXX_SENSOR_ACCEL; 
-	} else if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_GYRO)) {
-		// GYR in FIFO
-		sensor_ref = INV_IXM42XXX_SENSOR_GYRO; 
-	} else {
+	sensor_ref = get_reference_sensor(clk_cal, sensor_mask);
+	if (sensor_ref == INV_IXM42XXX_SENSOR_MAX) {
 		// Only temperature is in the FIFO, use MCU timestamp
 		*timestamp = irq_timestamp;
-		clk_cal->dt_error = 0; // reset error on deltatime
 		return 0; // return here, no need to execute the rest
 	}
 
-	if(clk_cal->last_fifo_timestamp[sensor_ref] == 0xDEADBEEF) {
+	// The packet that crossed the watermark was produced when the interrupt fired
+	ticks = tracker_advance(clk_cal, cur_fifo_timestamp);
+	if (irq_timestamp != 0 && packet == clk_cal->irq_packet) {
+		// Update calibration coefficient unless RTC is enabled
+		if (!clk_cal->rtc)
+			clock_calibration_add_pair(clk_cal, irq_timestamp, cur_fifo_timestamp);
+		if (tracker_observe(clk_cal, irq_timestamp, ticks))
+			tracker_rebase(clk_cal, ticks);
+	}
+
+	if (clk_cal->trk.locked) {
+		reset_sensor_timeline(clk_cal, sensor_ref, tracker_eval(clk_cal, ticks));
+	} else if(clk_cal->last_fifo_timestamp[sensor_ref] == 0xDEADBEEF) {
 		// no last timestamp from FIFO to compute a valid delta, so timestamp from FIFO not used
-		*timestamp = irq_timestamp;
-		clk_cal->dt_error = 0; // reset error on deltatime
+		reset_sensor_timeline(clk_cal, sensor_ref, irq_timestamp);
 	} else {
-		// last timestamp from FIFO is available to compute a valid dt based on read timestamp from FIFO
-		dt_fifo = (float)(cur_fifo_timestamp - (uint16_t)clk_cal->last_fifo_timestamp[sensor_ref]);
-		
-		// Handle rollover
-		if (dt_fifo <= 0)
-			dt_fifo += (UINT16_MAX+1);
+		// last timestamp from FIFO is available, scale the delta and carry the remainder
+		dt_q32 = get_dt_ticks(cur_fifo_timestamp, (uint16_t)clk_cal->last_fifo_timestamp[sensor_ref]) * clk_cal->us_per_tick_q32
+		       + clk_cal->last_timestamp_frac[sensor_ref];
+		clk_cal->last_timestamp_sent[sensor_ref] += dt_q32 >> 32;
+		clk_cal->last_timestamp_frac[sensor_ref] = (uint32_t)dt_q32;
+	}
+	*timestamp = clk_cal->last_timestamp_sent[sensor_ref];
+	clk_cal->trk.last_sent = *timestamp;
+	save_sensor_timeline(clk_cal, sensor_mask, sensor_ref, cur_fifo_timestamp);
+
+	return 0;
+}
 
-		// Apply proper timestamp resolution
-		dt_fifo *= get_fifo_timestamp_resolution(s);
+int inv_helper_extend_timestamps_from_fifo_batch(struct inv_ixm42xxx * s, 
+	                                             struct clk_calib *clk_cal, 
+	                                             const inv_ixm42xxx_fifo_batch_t * batch, 
+	                                             uint64_t irq_timestamp, 
+	                                             uint64_t * timestamps)
+{
+	const uint16_t *fifo_timestamp = batch->timestamp_fsync;
+	clk_calib_tracker_t *trk = &clk_cal->trk;
+	enum inv_ixm42xxx_sensor sensor_ref;
+	uint64_t base, frac, scale, sum, start_ticks, first_ticks;
+	uint16_t mask;
+	int i, irq_index, count = batch->count;
 
-		// Apply calibration coefficient
-		dt_us = apply_time_factor(s, clk_cal, dt_fifo);
+	if (count == 0)
+		return 0;
 
-		// Compute timestamp
-		*timestamp = clk_cal->last_timestamp_sent[sensor_ref] + dt_us;
+	if (irq_timestamp != clk_cal->drain_irq_timestamp)
+		start_drain(s, clk_cal, irq_timestamp);
+
+	// Packet of the burst that crossed the watermark, -1 if none
+	irq_index = (int)clk_cal->irq_packet - (int)clk_cal->drain_packets;
+	if (irq_timestamp == 0 || irq_index >= count)
+		irq_index = -1;
+
+	// Fast path only for a uniform burst continuing a valid timeline, otherwise packet by packet
+	mask = batch->sensor_mask[0];
+	for (i = 1; i < count; i++)
+		if (batch->sensor_mask[i] != mask)
+			break;
+	sensor_ref = get_reference_sensor(clk_cal, mask);
+	if (i < count || (mask & (1 << INV_IXM42XXX_SENSOR_FSYNC_EVENT)) || sensor_ref == INV_IXM42XXX_SENSOR_MAX
+	 || (!trk->locked && irq_index < 0 && clk_cal->last_fifo_timestamp[sensor_ref] == 0xDEADBEEF)) {
+		for (i = 0; i < count; i++)
+			inv_helper_extend_timestamp_from_fifo(s, clk_cal, fifo_timestamp[i], irq_timestamp, batch->sensor_mask[i], &timestamps[i]);
+		return 0;
 	}
-	
-	if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_ACCEL)) {
-		clk_cal->last_fifo_timestamp[INV_IXM42XXX_SENSOR_ACCEL] = cur_fifo_timestamp;
-		clk_cal->last_timestamp_sent[INV_IXM42XXX_SENSOR_ACCEL] = *timestamp;
+	clk_cal->drain_packets += count;
+
+	// Ticks since the previous packet
+	first_ticks = trk->started ? get_dt_ticks(fifo_timestamp[0], trk->last_fifo) : 0;
+	timestamps[0] = first_ticks;
+	trk->started = 1;
+	for (i = 1; i < count; i++)
+		timestamps[i] = get_dt_ticks(fifo_timestamp[i], fifo_timestamp[i-1]);
+
+	// Ticks since the last packet of the previous read
+	sum = 0;
+	for (i = 0; i < count; i++) {
+		sum += timestamps[i];
+		timestamps[i] = sum;
 	}
 
-	if (sensor_mask & (1 << INV_IXM42XXX_SENSOR_GYRO)) {
-		clk_cal->last_fifo_timestamp[INV_IXM42XXX_SENSOR_GYRO] = cur_fifo_timestamp;
-		clk_cal->last_timestamp_sent[INV_IXM42XXX_SENSOR_GYRO] = *timestamp;
+	// Correct the tracker first, the whole burst is then interpolated from the new line
+	start_ticks = trk->ticks;
+	if (irq_index >= 0) {
+		if (!clk_cal->rtc)
+			clock_calibration_add_pair(clk_cal, irq_timestamp, fifo_timestamp[irq_index]);
+		if (tracker_observe(clk_cal, irq_timestamp, start_ticks + timestamps[irq_index]))
+			tracker_rebase(clk_cal, start_ticks);
+	}
+	trk->ticks = start_ticks + sum;
+	trk->last_fifo = fifo_timestamp[count-1];
+
+	if (trk->locked) {
+		if (start_ticks + sum - trk->base_ticks > CLOCK_TRACKER_REBASE_TICKS)
+			tracker_rebase(clk_cal, start_ticks);
+		sum = start_ticks - trk->base_ticks;
+		base = trk->base_us;
+		frac = trk->base_frac;
+		scale = trk->scale_q32;
+		for (i = 0; i < count; i++)
+			timestamps[i] = base + (((sum + timestamps[i]) * scale + frac) >> 32);
+
+		// A correction never moves time backwards, packets wait for the line to catch up
+		base = trk->last_sent;
+		for (i = 0; i < count && timestamps[i] <= base; i++)
+			timestamps[i] = ++base;
+		reset_sensor_timeline(clk_cal, sensor_ref, timestamps[count-1]);
+	} else if (clk_cal->last_fifo_timestamp[sensor_ref] == 0xDEADBEEF) {
+		// Not anchored yet and no delta, like packet by packet
+		for (i = 0; i < count; i++)
+			timestamps[i] = irq_timestamp;
+		reset_sensor_timeline(clk_cal, sensor_ref, irq_timestamp);
+	} else {
+		// Same rounding as carrying the remainder packet by packet. The first delta comes from the
+		// last packet of the reference sensor, which outlives a restart of the tracker timeline
+		base = clk_cal->last_timestamp_sent[sensor_ref];
+		frac = clk_cal->last_timestamp_frac[sensor_ref];
+		scale = clk_cal->us_per_tick_q32;
+		first_ticks = get_dt_ticks(fifo_timestamp[0], (uint16_t)clk_cal->last_fifo_timestamp[sensor_ref]) - first_ticks;
+		sum += first_ticks;
+		for (i = 0; i < count; i++)
+			timestamps[i] = base + (((timestamps[i] + first_ticks) * scale + frac) >> 32);
+		clk_cal->last_timestamp_sent[sensor_ref] = timestamps[count-1];
+		clk_cal->last_timestamp_frac[sensor_ref] = (uint32_t)(sum * scale + frac);
 	}
+	trk->last_sent = timestamps[count-1];
+	save_sensor_timeline(clk_cal, mask, sensor_ref, fifo_timestamp[count-1]);
 
 	return 0;
 }
 
 void clock_calibration_reset(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
 {
-	/* Let's compute the number of samples before calibration based on the ODR configured at POR */
-	clk_cal->initial_recalib_after_n_samples = NUMBER_OF_SAMPLES_FOR_ODR(inv_ixm42xxx_convert_odr_bitfield_to_us(IXM42XXX_ACCEL_CONFIG0_ODR_200_HZ));
-	clk_cal->recalib_after_n_samples = clk_cal->initial_recalib_after_n_samples;
-	clk_cal->on_going = 0;
-	clk_cal->dt_error = 0;
+	int i;
+
+	for (i = 0; i < INV_IXM42XXX_CLOCK_SOURCE_MAX; i++) {
+		clk_cal->coef[i] = 1.0f;
+		memset(&clk_cal->fit[i], 0, sizeof(clk_cal->fit[i]));
+		clk_cal->fit[i].uncertainty_ppm = CLOCK_CALIBRATION_NOMINAL_PPM;
+	}
+	clk_cal->pair_source = INV_IXM42XXX_CLOCK_SOURCE_MAX;
+	memset(&clk_cal->trk, 0, sizeof(clk_cal->trk));
+	clk_cal->cur_source = INV_IXM42XXX_CLOCK_SOURCE_MAX;
+	clk_cal->res_us_q24 = 0;
+
+	/* Force start_drain() on the next packet */
+	clk_cal->drain_irq_timestamp = UINT64_MAX;
 
 	clock_calibration_reset_sensors_stats(s, clk_cal, INV_IXM42XXX_SENSOR_ACCEL);
 	clock_calibration_reset_sensors_stats(s, clk_cal, INV_IXM42XXX_SENSOR_GYRO);
@@ -181,260 +482,200 @@ void clock_calibration_reset(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
 
 void clock_calibration_reset_sensors_stats(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, enum inv_ixm42xxx_sensor sensor)
 {
-	clk_cal->last_timestamp_sent[sensor] = 0;
+	reset_sensor_timeline(clk_cal, sensor, 0);
 	clk_cal->last_fifo_timestamp[sensor] = 0xDEADBEEF;
 }
 
 
 int clock_calibration_restart(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
 {
-	int rc;
-	uint32_t smallest_running_odr_us;
-		
-	if ((rc = get_fastest_running_odr(s, &smallest_running_odr_us)) != 0)
-		return rc;
-	
-	/* in case no valid odr was returned, let's use the default odr value */
-	if(smallest_running_odr_us == 0xffffffff)
-		smallest_running_odr_us = 10;
-	
-	clk_cal->recalib_after_n_samples = NUMBER_OF_SAMPLES_FOR_ODR(smallest_running_odr_us);
-	clk_cal->on_going = 0;
+	/* The configuration cached for the FIFO read in progress may be the previous one */
+	clk_cal->drain_irq_timestamp = UINT64_MAX;
+
+	/* The FIFO timestamp may have wrapped while sensors were off, anchor again on the next interrupt */
+	tracker_unlock(clk_cal, 0);
+	clock_calibration_reset_sensors_stats(s, clk_cal, INV_IXM42XXX_SENSOR_ACCEL);
+	clock_calibration_reset_sensors_stats(s, clk_cal, INV_IXM42XXX_SENSOR_GYRO);
 	
-	return rc;
+	return 0;
 }
 
 
 int clock_calibration_init(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
 {
-	int rc;
-	
 	clock_calibration_reset(s, clk_cal);
-	rc = clock_calibration_initial(s, clk_cal);
+	clk_cal->drain_wm = 0;
+
+	/* Configuration used while FIFO decoding is detached from the bus */
+	read_config(s, clk_cal);
+	update_scale(clk_cal);
 	
-	return rc;
+	return 0;
 }
 
-static float compute_calibration_coefficient(struct inv_ixm42xxx * s, uint32_t duration_us)
+float clock_calibration_get_uncertainty_ppm(const struct clk_calib *clk_cal, enum inv_ixm42xxx_clock_source source)
 {
-	uint32_t tICM_1, tICM_2;
-	uint64_t tMCU_1, tMCU_2;
-	uint8_t nb_rollover;
-	float tICM_rollover;
-	float tICM_1f, tICM_2f;
-
-	/* Get the MCU and ICM time */
-	inv_helper_disable_irq();
-	tMCU_1 = inv_ixm42xxx_get_time_us();
-	inv_ixm42xxx_get_current_timestamp(s, &tICM_1);
-	inv_helper_enable_irq();
-
-	/* Wait 200ms */
-	while(inv_ixm42xxx_get_time_us() < (tMCU_1 + duration_us));
-
-	/* Get the MCU and ICM time once again */
-	inv_helper_disable_irq();
-	tMCU_2 = inv_ixm42xxx_get_time_us();
-	inv_ixm42xxx_get_current_timestamp(s, &tICM_2);
-	inv_helper_enable_irq();
-	
-	tICM_2f = (float)tICM_2 * get_reg_timestamp_resolution(s);
-	tICM_1f = (float)tICM_1 * get_reg_timestamp_resolution(s);
-	tICM_rollover = (float) ROLLOVER_20BITS * get_reg_timestamp_resolution(s);
+	if (source >= INV_IXM42XXX_CLOCK_SOURCE_MAX)
+		return CLOCK_CALIBRATION_NOMINAL_PPM;
+
+	return clk_cal->fit[source].uncertainty_ppm;
+}
 
-	/* Compute the time factor in order to align the MCU time to the ixm42xxx timestamp outputted from the FIFO */
-	nb_rollover = (uint8_t)((tMCU_2 - tMCU_1) / tICM_rollover);
+int clock_calibration_is_locked(const struct clk_calib *clk_cal, float *offset_sigma_us)
+{
+	if (offset_sigma_us)
+		*offset_sigma_us = clk_cal->trk.locked ? (float)sqrt(clk_cal->trk.p00) : 0;
 
-	/* If tICM_2 is smaller than tICM_1, there was one more rollover than what we estimated */
-	if (tICM_2f < tICM_1f)
-		nb_rollover += 1;
+	return clk_cal->trk.locked;
+}
 
-	return (float) (tMCU_2 - tMCU_1) / (float) (nb_rollover * tICM_rollover + tICM_2f - tICM_1f);
+int clock_calibration_is_converged(const struct clk_calib *clk_cal, enum inv_ixm42xxx_clock_source source)
+{
+	return clock_calibration_get_uncertainty_ppm(clk_cal, source) <= CLOCK_CALIBRATION_CONVERGED_PPM;
 }
 
-static int clock_calibration_initial(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
+static void start_segment(clk_calib_fit_t *fit, uint64_t irq_timestamp)
 {
-	int status = 0;
-	uint64_t time;
-	uint8_t prev_src0, prev_src8, data;
-	
-	/*
-	 * Enable the ICM time register reading
-	 */
-	status |= inv_ixm42xxx_enable_timestamp_to_register(s);
-
-	/*
-	 * Power ON the ICM
-	 * Enable gyro (the gyro clock is used for combo accel/gyro clocking)
-	 * But disable interrupt since we don't want the data here
-	 */
-	data = 0;
-	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_SOURCE0, 1, &prev_src0);
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE0, 1, &data);
-	status |= inv_ixm42xxx_set_reg_bank(s, 4);
-	status |= inv_ixm42xxx_read_reg(s, MPUREG_INT_SOURCE8_B4, 1, &prev_src8);
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE8_B4, 1, &data);
-	status |= inv_ixm42xxx_set_reg_bank(s, 0);
-
-	/* Compute coefficient for PLL */ 
-	status |= inv_ixm42xxx_enable_gyro_low_noise_mode(s);
-	/* Wait 40 ms for MEMS start-up */
-	time = inv_ixm42xxx_get_time_us();
-	while(inv_ixm42xxx_get_time_us() < (time + (40 * 1000)));
-	clk_cal->coef[INV_IXM42XXX_PLL] = compute_calibration_coefficient(s, 200000); // 200 msec
-	status |= inv_ixm42xxx_disable_gyro(s);
-
-	/* Compute coefficient for RC osc*/
-	status |= inv_ixm42xxx_enable_accel_low_noise_mode(s);
-	/* Wait 40 ms for MEMS start-up */
-	time = inv_ixm42xxx_get_time_us();
-	while(inv_ixm42xxx_get_time_us() < (time + (40 * 1000)));
-	clk_cal->coef[INV_IXM42XXX_RC_OSC] = compute_calibration_coefficient(s, 200000); // 200 msec
-	status |= inv_ixm42xxx_disable_accel(s);
-
-	/* Coefficient for WU osc can't be measured as timestamp register is not reliable in this mode */
-	clk_cal->coef[INV_IXM42XXX_WU_OSC] = clk_cal->coef[INV_IXM42XXX_RC_OSC];
-
-	INV_MSG(INV_MSG_LEVEL_DEBUG, "HelperClockCalib: Initial coefficient computed:");
-	INV_MSG(INV_MSG_LEVEL_DEBUG, "HelperClockCalib:    - PLL:    %f", clk_cal->coef[INV_IXM42XXX_PLL]);
-	INV_MSG(INV_MSG_LEVEL_DEBUG, "HelperClockCalib:    - RC_OSC: %f", clk_cal->coef[INV_IXM42XXX_RC_OSC]);
-	INV_MSG(INV_MSG_LEVEL_DEBUG, "HelperClockCalib:    - WU_OSC: %f", clk_cal->coef[INV_IXM42XXX_WU_OSC]);
-
-	/* Disable the 20-bits timestamp register reading */
-	status |= inv_ixm42xxx_disable_timestamp_to_register(s);
-
-	/* Re-enable interrupts */
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE0, 1, &prev_src0);
-	status |= inv_ixm42xxx_set_reg_bank(s, 4);
-	status |= inv_ixm42xxx_write_reg(s, MPUREG_INT_SOURCE8_B4, 1, &prev_src8);
-	status |= inv_ixm42xxx_set_reg_bank(s, 0);
-	
-	return status;
+	fit->segments += 1;
+	fit->seg_weight = 0;
+	fit->mean_icm = 0;
+	fit->mean_mcu = 0;
+	fit->seg_mcu_origin = irq_timestamp;
+	fit->icm_ticks = 0;
+	fit->rejected = 0;
 }
 
 /*
- * Update the calibration factor after N samples (60 x 20ms at default ODR, every 1200ms)
+ * The FIFO timestamp can be unwrapped over a gap as long as the time predicted from the MCU
+ * is off by less than a quarter of a rollover, the other quarter being left to the FIFO read
+ * latency. The error is the nominal bound until the coefficient is measured, then 4 times its
+ * uncertainty but never below 1000 ppm to cover the drift since the last fit.
  */
-int clock_calibration_update(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, uint64_t irq_timestamp, uint16_t fifo_timestamp)
+static int can_unwrap(clk_calib_fit_t *fit, uint64_t gap_us, double rollover_us)
 {
-	int rc = 0;
-
-	if((--clk_cal->recalib_after_n_samples) == 0) {
-		uint32_t smallest_running_odr_us;
-		
-		rc = clock_calibration_update_coef(s, clk_cal, &clk_cal->on_going, irq_timestamp, fifo_timestamp);
-		
-		/* now find the smallest running odr to program new calibration */
-		if ((rc = get_fastest_running_odr(s, &smallest_running_odr_us)) != 0) {
-			/* in case off error we set recalib n sample to the initial one */
-			clk_cal->recalib_after_n_samples = clk_cal->initial_recalib_after_n_samples;
-			return rc;
-		}
-		/* in case no valid odr was returned, let's use the default odr value */
-		if(smallest_running_odr_us == 0xffffffff)
-			smallest_running_odr_us = 10;	
-		
-		clk_cal->recalib_after_n_samples = NUMBER_OF_SAMPLES_FOR_ODR(smallest_running_odr_us);
+	double error_ppm = CLOCK_CALIBRATION_NOMINAL_PPM;
+
+	if (fit->uncertainty_ppm < CLOCK_CALIBRATION_NOMINAL_PPM) {
+		error_ppm = 4 * (double)fit->uncertainty_ppm;
+		if (error_ppm < 1000)
+			error_ppm = 1000;
+		else if (error_ppm > CLOCK_CALIBRATION_NOMINAL_PPM)
+			error_ppm = CLOCK_CALIBRATION_NOMINAL_PPM;
 	}
-	
-	return rc;
+
+	return (double)gap_us * error_ppm / 1e6 < rollover_us / 4;
 }
 
-static int clock_calibration_update_coef(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, uint8_t *on_going, uint64_t irq_timestamp, uint16_t fifo_timestamp)
+/*
+ * Clock source and timestamp resolution come from the values cached by read_config(),
+ * no register access: in pipelined mode this runs on the decode thread.
+ */
+static void clock_calibration_add_pair(struct clk_calib *clk_cal, uint64_t irq_timestamp, uint16_t fifo_timestamp)
 {
-	int status = 0;
-	uint64_t tMCU_2;
-	uint32_t tICM_2;
-	float tICM_1f, tICM_2f;
-	float computed_coef_time, tICM_rollover;
-	uint8_t nb_rollover;
-	/* These variables needs to be static since we assign them in stage 1 and use them in stage 2 */
-	static uint64_t tMCU_1;
-	static uint32_t tICM_1;
-	static enum inv_ixm42xxx_clock_source cur_source;
-	
-	
-	if(*on_going == 0) {
-		/* Stage 1 */ 
-
-		/* Set initial MCU and ICM time */
-		tICM_1 = fifo_timestamp;
-		tMCU_1 = irq_timestamp;
-		*on_going = 1;
-		cur_source = get_current_clock_source(s);
-	} else if(*on_going == 1) {
-		/* Stage 2 */ 
-
-		/* If the clock source has changed between both stages, do not compute new coef */
-		if (cur_source != get_current_clock_source(s)) {
-			*on_going = 0;
-			return status;
-		}
+	enum inv_ixm42xxx_clock_source source = clk_cal->cur_source;
+	clk_calib_fit_t *fit;
+	double res_us, x, y, dx, dy, dof, slope, sigma2, residual, ppm;
+
+	if (source >= INV_IXM42XXX_CLOCK_SOURCE_MAX || clk_cal->res_us_q24 == 0)
+		return;
 
-		/* Set second MCU and ICM time */
-		tICM_2 = fifo_timestamp;
-		tMCU_2 = irq_timestamp;
+	fit = &clk_cal->fit[source];
+	res_us = (double)clk_cal->res_us_q24 / (1UL<<24);
 
-		tICM_1f = (float)tICM_1 * get_fifo_timestamp_resolution(s);
-		tICM_2f = (float)tICM_2 * get_fifo_timestamp_resolution(s);
-		tICM_rollover = (float) ROLLOVER_16BITS * get_fifo_timestamp_resolution(s);
+	if (fit->weight == 0)
+		fit->window_start = irq_timestamp;
 
-		/* Estimate number of rollover of the FIFO timestamp */
-		nb_rollover = (uint8_t)((tMCU_2 - tMCU_1) / tICM_rollover);
+	/* A change of clock source or a long gap breaks the FIFO timestamp continuity */
+	if (fit->seg_weight == 0 || source != clk_cal->pair_source || irq_timestamp <= fit->last_mcu
+	 || !can_unwrap(fit, irq_timestamp - fit->last_mcu, ROLLOVER_16BITS * res_us)) {
+		start_segment(fit, irq_timestamp);
+	} else {
+		uint16_t dt_ticks = (uint16_t)(fifo_timestamp - fit->last_fifo);
+		double expected_ticks = (double)(irq_timestamp - fit->last_mcu) / (clk_cal->coef[source] * res_us);
+		double nb_rollover = floor((expected_ticks - dt_ticks) / ROLLOVER_16BITS + 0.5);
+
+		if (nb_rollover < 0)
+			nb_rollover = 0;
+		fit->icm_ticks += dt_ticks + (uint64_t)nb_rollover * ROLLOVER_16BITS;
+	}
+	fit->last_fifo = fifo_timestamp;
+	fit->last_mcu = irq_timestamp;
+	clk_cal->pair_source = source;
 
-		/* If tICM_2 is smaller than tICM_1, there was one more rollover than what we estimated */
-		if (tICM_2f < tICM_1f)
-			nb_rollover += 1;
+	x = (double)fit->icm_ticks * res_us;
+	y = (double)(irq_timestamp - fit->seg_mcu_origin);
 
-		computed_coef_time = (tMCU_2 - tMCU_1) / (float) (nb_rollover * tICM_rollover + tICM_2f - tICM_1f);
+	/* One slope and one offset per segment are fitted */
+	dof = fit->weight - 1 - fit->segments;
 
-		/* error management : only allow 90-110% variation */
-		if ( (computed_coef_time < 1.1) && (computed_coef_time > 0.9) ) {
-			clk_cal->coef[get_current_clock_source(s)] = computed_coef_time;
-			INV_MSG(INV_MSG_LEVEL_DEBUG, "helperClockCalib: New coefficient computed for %s: %f", 
-				get_current_clock_source_name(s), clk_cal->coef[get_current_clock_source(s)]);
+	/* Once the fit is trusted, refuse pairs far from the line (late FIFO read) */
+	if (fit->weight >= CLOCK_CALIBRATION_MIN_PAIRS && fit->seg_weight > 0 && fit->cxx > 0 && dof > 0) {
+		slope = fit->cxy / fit->cxx;
+		sigma2 = (fit->cyy - fit->cxy * slope) / dof;
+		residual = (y - fit->mean_mcu) - slope * (x - fit->mean_icm);
+		
+		if (residual * residual > CLOCK_CALIBRATION_OUTLIER_SIGMA * CLOCK_CALIBRATION_OUTLIER_SIGMA * sigma2 + res_us * res_us) {
+			/* Several in a row means the offset moved, start over from this pair */
+			if (++fit->rejected < 3)
+				return;
+			start_segment(fit, irq_timestamp);
+			y = 0;
+			x = 0;
 		} else
-			INV_MSG(INV_MSG_LEVEL_ERROR, "helperClockCalib: Bad coefficient computed for %s: %f, skipping it and keeping %f", 
-				get_current_clock_source_name(s), computed_coef_time, clk_cal->coef[get_current_clock_source(s)]);
+			fit->rejected = 0;
+	}
 
-		*on_going = 0;
+	/* Forget older pairs progressively so that the coefficient follows temperature drift */
+	if (irq_timestamp - fit->window_start >= TIME_US_FOR_CLOCK_CALIBRATION) {
+		fit->weight /= 2;
+		fit->segments /= 2;
+		fit->seg_weight /= 2;
+		fit->cxx /= 2;
+		fit->cxy /= 2;
+		fit->cyy /= 2;
+		fit->window_start = irq_timestamp;
 	}
-	return status;
-}
 
-static int get_fastest_running_odr(struct inv_ixm42xxx * s, uint32_t *odr)
-{
-	int rc = 0;
-	uint8_t accel_cfg_0_reg, gyro_cfg_0_reg, pwr_mngt_0_reg;
-
-	uint32_t smallest_odr = 0xffffffff, accel_odr_us, gyro_odr_us;
-	IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t accel_mode;
-	IXM42XXX_PWR_MGMT_0_GYRO_MODE_t gyro_mode;
-	IXM42XXX_ACCEL_CONFIG0_ODR_t accel_odr;
-	IXM42XXX_GYRO_CONFIG0_ODR_t gyro_odr;
-
-	/* Access current sensors ODR */
-	rc |= inv_ixm42xxx_read_reg(s, MPUREG_ACCEL_CONFIG0, 1, &accel_cfg_0_reg);
-	rc |= inv_ixm42xxx_read_reg(s, MPUREG_GYRO_CONFIG0, 1, &gyro_cfg_0_reg);
-	rc |= inv_ixm42xxx_read_reg(s, MPUREG_PWR_MGMT_0, 1, &pwr_mngt_0_reg);
-	accel_mode = (IXM42XXX_PWR_MGMT_0_ACCEL_MODE_t)(pwr_mngt_0_reg & BIT_PWR_MGMT_0_ACCEL_MODE_MASK);
-	gyro_mode  = (IXM42XXX_PWR_MGMT_0_GYRO_MODE_t)(pwr_mngt_0_reg & BIT_PWR_MGMT_0_GYRO_MODE_MASK);
-	gyro_odr   = (IXM42XXX_GYRO_CONFIG0_ODR_t)(gyro_cfg_0_reg & BIT_GYRO_CONFIG0_ODR_MASK);
-	accel_odr  = (IXM42XXX_ACCEL_CONFIG0_ODR_t)(accel_cfg_0_reg & BIT_ACCEL_CONFIG0_ODR_MASK);
-	accel_odr_us = inv_ixm42xxx_convert_odr_bitfield_to_us(accel_odr);
-	gyro_odr_us = inv_ixm42xxx_convert_odr_bitfield_to_us(gyro_odr);
-
-	/* now let's find the smallest ODR of running sensors among ACC and GYR */
-	if (accel_mode != IXM42XXX_PWR_MGMT_0_ACCEL_MODE_OFF)
-		smallest_odr = accel_odr_us;
-
-	if (gyro_mode != IXM42XXX_PWR_MGMT_0_GYRO_MODE_OFF)
-		if (gyro_odr_us < smallest_odr)
-			smallest_odr = gyro_odr_us;
-
-	*odr = smallest_odr;
-
-	return rc;
+	/* Online update of the means and co-moments */
+	fit->weight += 1;
+	fit->seg_weight += 1;
+	dx = x - fit->mean_icm;
+	dy = y - fit->mean_mcu;
+	fit->mean_icm += dx / fit->seg_weight;
+	fit->mean_mcu += dy / fit->seg_weight;
+	fit->cxx += dx * (x - fit->mean_icm);
+	fit->cxy += dx * (y - fit->mean_mcu);
+	fit->cyy += dy * (y - fit->mean_mcu);
+
+	dof = fit->weight - 1 - fit->segments;
+	if (fit->weight < CLOCK_CALIBRATION_MIN_PAIRS || fit->cxx <= 0 || dof <= 0)
+		return;
+
+	slope = fit->cxy / fit->cxx;
+	sigma2 = (fit->cyy - fit->cxy * slope) / dof;
+	if (sigma2 < 0)
+		sigma2 = 0;
+	ppm = 1e6 * sqrt(sigma2 / fit->cxx) / slope;
+
+	/* error management : only allow 90-110% variation */
+	if ((slope >= 1.1) || (slope <= 0.9)) {
+		INV_MSG(INV_MSG_LEVEL_ERROR, "helperClockCalib: Bad coefficient computed for %s: %f, skipping it and keeping %f", 
+			get_clock_source_name(source), slope, clk_cal->coef[source]);
+		return;
+	}
+
+	if (ppm <= CLOCK_CALIBRATION_CONVERGED_PPM && fit->uncertainty_ppm > CLOCK_CALIBRATION_CONVERGED_PPM)
+		INV_MSG(INV_MSG_LEVEL_DEBUG, "helperClockCalib: Coefficient converged for %s: %f (%.1f ppm)", 
+			get_clock_source_name(source), slope, ppm);
+
+	clk_cal->coef[source] = (float)slope;
+	fit->uncertainty_ppm = (float)ppm;
+
+	/* WU_OSC runs at the RC_OSC rate until it is measured on its own */
+	if (source == INV_IXM42XXX_RC_OSC && clk_cal->fit[INV_IXM42XXX_WU_OSC].weight < CLOCK_CALIBRATION_MIN_PAIRS)
+		clk_cal->coef[INV_IXM42XXX_WU_OSC] = clk_cal->coef[INV_IXM42XXX_RC_OSC];
+
+	update_scale(clk_cal);
 }
 
 static enum inv_ixm42xxx_sensor get_fastest_sensor(struct inv_ixm42xxx * s)
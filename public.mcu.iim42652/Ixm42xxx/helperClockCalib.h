@@ -34,21 +34,56 @@
 #define ROLLOVER_16BITS 0x10000
 
 /*
- * Time between 2 MCU/ICM clock calibrations and for 1 calibration
+ * Length of MCU time after which the clock calibration sums are halved, so that the
+ * coefficient follows the oscillator drift with temperature
  */
-#define TIME_US_FOR_CLOCK_CALIBRATION 1200000
+#define TIME_US_FOR_CLOCK_CALIBRATION 10000000
 
 /*
- * Number of neccessary rollover occured during the TIME_US_FOR_CLOCK_CALIBRATION
+ * A gap longer than this between two pairs of the same clock source starts a new segment
+ * instead of unwrapping the 16-bit FIFO timestamp across it
  */
-#define NB_ROLLOVER    (uint8_t)(TIME_US_FOR_CLOCK_CALIBRATION / TIME_US_FOR_20BITS_TMSP_ROLLOVER)
+#define CLOCK_CALIBRATION_MAX_GAP_US 500000
 
 /*
- * Number of samples needed before computing the clock calibration coefficient 
- * To round up the division is critical when the number of samples is low, i.e when the sensor frequency set is low.
+ * Pairs needed before a fit is trusted
  */
-#define NUMBER_OF_SAMPLES_FOR_ODR(odr_us)   TIME_US_FOR_CLOCK_CALIBRATION/(odr_us) + TIME_US_FOR_CLOCK_CALIBRATION%(odr_us);
+#define CLOCK_CALIBRATION_MIN_PAIRS 8
 
+/*
+ * Uncertainty reported while a clock source still uses its nominal coefficient (10%, the
+ * sanity bound of the coefficients)
+ */
+#define CLOCK_CALIBRATION_NOMINAL_PPM 100000.0f
+
+/*
+ * Uncertainty below which a clock source is reported as converged
+ */
+#define CLOCK_CALIBRATION_CONVERGED_PPM 50.0f
+
+/*
+ * Pairs whose residual exceeds this many standard deviations are not accumulated once the fit is trusted
+ */
+#define CLOCK_CALIBRATION_OUTLIER_SIGMA 5
+
+/*
+ * Noise of an interrupt timestamp against the production of the packet that crossed the
+ * watermark (interrupt latency), for the drift tracker
+ */
+#define CLOCK_TRACKER_IRQ_NOISE_US 20.0
+
+/*
+ * Random walk of the host time and of the oscillator rate, per square root of second, for the drift tracker
+ */
+#define CLOCK_TRACKER_OFFSET_NOISE_US 1.0
+#define CLOCK_TRACKER_SKEW_NOISE_PPM  3.0
+
+/*
+ * Interrupts whose innovation exceeds this many standard deviations are refused, and after
+ * CLOCK_TRACKER_MAX_REJECT in a row the tracker restarts from the next one
+ */
+#define CLOCK_TRACKER_OUTLIER_SIGMA 5
+#define CLOCK_TRACKER_MAX_REJECT    3
 
 /* Interrupt enum state for PLL, RC_OSC and WU_OSC */
 enum inv_ixm42xxx_clock_source{
@@ -58,17 +93,81 @@ enum inv_ixm42xxx_clock_source{
 	INV_IXM42XXX_CLOCK_SOURCE_MAX
 };
 
+/*
+ * Least squares fit of MCU time against FIFO time for one clock source
+ *
+ * Pairs are accumulated online (running means and co-moments). A segment is a run of pairs
+ * over which the 16-bit FIFO timestamp could be unwrapped; each segment has its own means
+ * and only the co-moments are shared, so the slope is fitted across segments whatever
+ * their offsets.
+ */
+typedef struct clk_calib_fit {
+	float    weight;          /**< pairs accumulated, halved with the co-moments */
+	float    segments;        /**< segments accumulated, halved with the co-moments */
+	float    seg_weight;      /**< pairs of the current segment */
+	double   mean_icm;        /**< mean FIFO time of the current segment, in us at nominal resolution */
+	double   mean_mcu;        /**< mean MCU time of the current segment, in us from seg_mcu_origin */
+	double   cxx, cxy, cyy;   /**< co-moments */
+	uint64_t seg_mcu_origin;  /**< MCU time of the first pair of the current segment */
+	uint64_t icm_ticks;       /**< unwrapped FIFO timestamp of the last pair */
+	uint64_t last_mcu;        /**< MCU time of the last pair */
+	uint64_t window_start;    /**< MCU time of the last halving */
+	uint16_t last_fifo;       /**< raw FIFO timestamp of the last pair */
+	uint32_t rejected;        /**< pairs refused as outliers */
+	float    uncertainty_ppm; /**< 1-sigma uncertainty of the coefficient in use */
+} clk_calib_fit_t;
+
+/*
+ * Drift tracker: host time of the FIFO timestamp counter
+ *
+ * The 16-bit FIFO timestamp of every packet is unwrapped into one device timeline. A Kalman
+ * filter with two states, host time at ref_ticks and host microseconds per tick, is predicted
+ * to the packet that crossed the FIFO watermark and corrected with the interrupt timestamp.
+ * Packet timestamps are the filter line evaluated at their tick, in integer from a base point.
+ */
+typedef struct clk_calib_tracker {
+	uint8_t  started;         /**< last_fifo holds the timestamp of a previous packet */
+	uint8_t  locked;          /**< an interrupt anchored the filter */
+	uint8_t  rejected;        /**< interrupts refused in a row */
+	uint16_t last_fifo;       /**< raw FIFO timestamp of the last packet */
+	uint64_t ticks;           /**< unwrapped FIFO timestamp of the last packet */
+	uint64_t ref_ticks;       /**< tick the filter state refers to */
+	double   host_us;         /**< filtered host time at ref_ticks */
+	double   us_per_tick;     /**< filtered host microseconds per tick */
+	double   p00, p01, p11;   /**< covariance of host_us and us_per_tick */
+	uint64_t base_ticks;      /**< tick of base_us, never after the next packet */
+	uint64_t base_us;         /**< host time at base_ticks */
+	uint32_t base_frac;       /**< fractional part of base_us, in us Q32 */
+	uint64_t scale_q32;       /**< us_per_tick in us Q32 */
+	uint64_t last_sent;       /**< keeps timestamps increasing across corrections */
+	uint32_t observations;    /**< interrupts accepted */
+	uint32_t outliers;        /**< interrupts refused */
+} clk_calib_tracker_t;
+
 /* 
  * Coefficient to interpolate the linear regression between the ICM time and the MCU time
+ *
+ * The coefficients start at their nominal value and are estimated while streaming from
+ * (IRQ timestamp, FIFO timestamp) pairs, one per interrupt. They seed the drift tracker,
+ * which then gives the timestamps.
  */
 typedef struct clk_calib{
-	int initial_recalib_after_n_samples;
-	int recalib_after_n_samples;
-	uint8_t on_going;
 	float    coef[INV_IXM42XXX_CLOCK_SOURCE_MAX];   /**< Calibration coefficient */
+	clk_calib_fit_t fit[INV_IXM42XXX_CLOCK_SOURCE_MAX]; /**< fit per clock source */
+	enum inv_ixm42xxx_clock_source pair_source;     /**< clock source of the last pair accumulated */
+	uint64_t drain_irq_timestamp;                   /**< interrupt the cached configuration below was read for */
+	enum inv_ixm42xxx_clock_source cur_source;      /**< clock source of the FIFO read in progress */
+	enum inv_ixm42xxx_sensor fastest_sensor;        /**< reference sensor when accel and gyro share a packet */
+	uint8_t  rtc;                                   /**< CLKIN is used, timestamps are not calibrated */
+	uint32_t res_us_q24;                            /**< FIFO timestamp resolution */
+	uint64_t us_per_tick_q32;                       /**< resolution times coef[cur_source], in us Q32 */
+	uint16_t drain_wm;                              /**< watermark of the FIFO read in progress, 0 to use the driver one */
+	uint16_t irq_packet;                            /**< packet of a FIFO read that crossed the watermark */
+	uint16_t drain_packets;                         /**< packets of the FIFO read in progress */
+	clk_calib_tracker_t trk;                        /**< drift tracker */
 	uint64_t last_timestamp_sent[INV_IXM42XXX_SENSOR_MAX]; /**< last timestamp sent when using the extended timestamp API */
+	uint32_t last_timestamp_frac[INV_IXM42XXX_SENSOR_MAX]; /**< fractional part of last_timestamp_sent, in us Q32 */
 	uint32_t last_fifo_timestamp[INV_IXM42XXX_SENSOR_MAX]; /**< last timestamp read from FIFO */
-	float    dt_error;                                     /**< keep track of the error on the timestamp due to the usec resolution */
 } clk_calib_t;
 
 /** @brief Extend timestamp from FIFO by getting time base from upper layer
@@ -77,14 +176,39 @@ typedef struct clk_calib{
  *  @param[in] timestamp_fsync according which is selected :
  *         - timestamp counter  absolute time at 16us/1us rate resolution according to settings (16us by default)
  *         - fsync counter 
- * @param[in] irq_timestamp     interrupt data ready timestamp computing by upper layer
+ * @param[in] irq_timestamp     timestamp of the FIFO watermark interrupt that triggered the read, taken
+ *                              by the upper layer, the same for every packet of the read, 0 if unknown
  * @param[in] sensor_mask    sensors which have location in the FIFO packet
  * @param[out] timestamp extended timestamp
+ *
+ * One interrupt timestamp per FIFO read is enough: it is matched with the packet that
+ * crossed the watermark (the FIFO being emptied by each read) and corrects the drift
+ * tracker, packets are then placed on the tracked line. Until the first interrupt, deltas
+ * of the FIFO timestamp are scaled from the last packet. The configuration is read once
+ * per interrupt and timestamps are computed in integer with the sub-microsecond remainder
+ * carried, so that no error accumulates.
  */
 int inv_helper_extend_timestamp_from_fifo(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, 
 		uint16_t timestamp_fsync, uint64_t irq_timestamp, int sensor_mask, uint64_t * timestamp);
 
-/** @brief Intitialisation function to be executed before clock_calibration_update
+/** @brief Extend the timestamps of a whole decoded FIFO burst
+ *  @param[in] states     placeholder to inv_ixm42xxx_t states
+ *  @param[in] clk_calib  placeholder to clk_calib_t states
+ *  @param[in] batch      burst decoded by inv_ixm42xxx_decode_fifo_batch() or inv_ixm42xxx_get_data_from_fifo_batch()
+ *  @param[in] irq_timestamp  interrupt data ready timestamp computing by upper layer
+ *  @param[out] timestamps    extended timestamp of each packet, batch->count elements
+ *  @return 0 on success, negative value on error.
+ *
+ *  When all packets carry the same sensors and no FSYNC event, the tracker is corrected
+ *  first and every packet of the burst is interpolated from the corrected line, the ones
+ *  before the watermark included; the burst is extended with loops over arrays only
+ *  (deltas, running sum, scaling). Otherwise inv_helper_extend_timestamp_from_fifo() is
+ *  called for each packet, which can only correct the packets from the watermark on.
+ */
+int inv_helper_extend_timestamps_from_fifo_batch(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, 
+		const inv_ixm42xxx_fifo_batch_t * batch, uint64_t irq_timestamp, uint64_t * timestamps);
+
+/** @brief Intitialisation function to be executed before inv_helper_extend_timestamp_from_fifo
  *  @param[in] states     placeholder to inv_ixm42xxx_t states
  *  @param[in] clk_calib  placeholder to clk_calib_t states
  */
@@ -101,23 +225,19 @@ void clock_calibration_reset(struct inv_ixm42xxx * s, struct clk_calib *clk_cal)
  */
 void clock_calibration_reset_sensors_stats(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, enum inv_ixm42xxx_sensor );
 
-/** @brief First calibration done just after start'up to calculate first time factor
+/** @brief Start the clock calibration with nominal coefficients
+ *
+ *  Nothing is measured here: the device can stream right away and the coefficients
+ *  converge from the FIFO traffic, see clock_calibration_get_uncertainty_ppm().
+ *  The configuration is read here, call it again after a configuration change when
+ *  FIFO is decoded detached from the bus.
+ *
  *  @param[in] states     placeholder to inv_ixm42xxx_t states
  *  @param[in] clk_calib  placeholder to clk_calib_t states
  */
 int clock_calibration_init(struct inv_ixm42xxx * s, struct clk_calib *clk_cal);
 
-/** @brief Update time factor for clock calibration
- *  @param[in] states         placeholder to inv_ixm42xxx_t states
- *  @param[in] clk_calib      placeholder to clk_calib_t states
- *  @param[in] irq_timestamp  timestamp from the MCU to be used to compute coefficient (need to be taken at the same time as fifo_timestamp)
- *  @param[in] fifo_timestamp timestamp from the FIFO (ICM) to be used to compute coefficient (need to be taken at the same time as irq_timestamp)
- */
-int clock_calibration_update(struct inv_ixm42xxx * s, struct clk_calib *clk_cal, uint64_t irq_timestamp, uint16_t fifo_timestamp);
-
-/** @brief Restart the computation of the time factor.
- * This function finds the smallest ODR of running sensors among ACC and GYR. Then it restarts
- * the time deviation computation based on this ODR.
+/** @brief Drop the FIFO read in progress from the calibration.
  *
  *  Note: This function should be called when enabling Accel or Gyro or when changing ODR
  *
@@ -126,6 +246,27 @@ int clock_calibration_update(struct inv_ixm42xxx * s, struct clk_calib *clk_cal,
  */
 int clock_calibration_restart(struct inv_ixm42xxx * s, struct clk_calib *clk_cal);
 
+/** @brief Confidence of the coefficient in use for a clock source
+ *  @param[in] clk_calib  placeholder to clk_calib_t states
+ *  @param[in] source     clock source
+ *  @return 1-sigma uncertainty of coef[source] in ppm, CLOCK_CALIBRATION_NOMINAL_PPM while the nominal value is used
+ */
+float clock_calibration_get_uncertainty_ppm(const struct clk_calib *clk_cal, enum inv_ixm42xxx_clock_source source);
+
+/** @brief Tell if the drift tracker follows the interrupts
+ *  @param[in] clk_calib  placeholder to clk_calib_t states
+ *  @param[out] offset_sigma_us  1-sigma uncertainty of the tracked host time, can be NULL
+ *  @return 1 if an interrupt anchored the tracker, 0 otherwise
+ */
+int clock_calibration_is_locked(const struct clk_calib *clk_cal, float *offset_sigma_us);
+
+/** @brief Tell if a clock source coefficient is known within CLOCK_CALIBRATION_CONVERGED_PPM
+ *  @param[in] clk_calib  placeholder to clk_calib_t states
+ *  @param[in] source     clock source
+ *  @return 1 if converged, 0 otherwise
+ */
+int clock_calibration_is_converged(const struct clk_calib *clk_cal, enum inv_ixm42xxx_clock_source source);
+
 /*!
  * \brief Converter function from period (in usec) to frequency (in Hz)
  */
@@ -23,7 +23,7 @@
 #include "helperClockCalib.h"
 
 #include "Message.h"
-//#include "Invn/EmbUtils/RingBuffer.h"
+#include "RingBuffer.h"
 
 /* --------------------------------------------------------------------------------------
  *  Static and extern variables
@@ -35,8 +35,11 @@ static struct inv_ixm42xxx icm_driver;
 /* structure allowing to handle clock calibration */
 static clk_calib_t clk_calib;
 
-/* Buffer to keep track of the timestamp when ixm42xxx data ready interrupt fires. */
-//extern  RINGBUFFER(timestamp_buffer, 64, uint64_t);
+/* Buffer to keep track of the timestamp when ixm42xxx FIFO threshold interrupt fires. */
+extern RINGBUFFER_VOLATILE(timestamp_buffer, 64, uint64_t);
+
+/* Timestamp of the interrupt that triggered the FIFO read in progress */
+static uint64_t irq_timestamp;
 
 
 /* --------------------------------------------------------------------------------------
@@ -71,7 +74,7 @@ int SetupInvDevice(struct inv_ixm42xxx_serif * icm_serif)
 		return INV_ERROR;
 	}
 
-	//RINGBUFFER_CLEAR(&timestamp_buffer);
+	RINGBUFFER_VOLATILE_CLEAR(&timestamp_buffer);
 	return rc;
 }
 
@@ -88,7 +91,7 @@ int ConfigureInvDevice(uint8_t is_low_noise_mode,
 	
 	if (!is_rtc_mode) {
 		/*
-		 * Compute the time drift between the MCU and ICM clock
+		 * Start with nominal MCU/ICM clock ratios, they are measured while streaming
 		 */
 		rc |= clock_calibration_init(&icm_driver, &clk_calib);
 	} else {
@@ -128,6 +131,19 @@ int ConfigureInvDevice(uint8_t is_low_noise_mode,
 
 int GetDataFromInvDevice(void)
 {
+	/*
+	 * Extract the timestamp that was buffered when the FIFO threshold IRQ fired. See 
+	 * ext_interrupt_cb() in main.c for more details. One timestamp per FIFO read is
+	 * enough, it is shared by all packets of the read.
+	 * As timestamp buffer is filled in interrupt handler, we should pop it with
+	 * interrupts disabled to avoid any concurrent access.
+	 */
+	irq_timestamp = 0;
+	inv_helper_disable_irq();
+	if (!RINGBUFFER_VOLATILE_EMPTY(&timestamp_buffer))
+		RINGBUFFER_VOLATILE_POP(&timestamp_buffer, &irq_timestamp);
+	inv_helper_enable_irq();
+
 	/*
 	 * Extract packets from FIFO. Callback defined at init time (i.e. 
 	 * HandleInvDeviceFifoPacket) will be called for each valid packet extracted from 
@@ -139,22 +155,12 @@ int GetDataFromInvDevice(void)
 
 void HandleInvDeviceFifoPacket(inv_ixm42xxx_sensor_event_t * event)
 {
-	uint64_t irq_timestamp = 0, extended_timestamp;
+	uint64_t extended_timestamp;
 	int32_t accel[3], gyro[3];
 	
 	/*
-	 * Extract the timestamp that was buffered when current packet IRQ fired. See 
-	 * ext_interrupt_cb() in main.c for more details.
-	 * As timestamp buffer is filled in interrupt handler, we should pop it with
-	 * interrupts disabled to avoid any concurrent access.
-	 */
-	//inv_disable_irq();
-	//if (!RINGBUFFER_EMPTY(&timestamp_buffer))
-	//	RINGBUFFER_POP(&timestamp_buffer, &irq_timestamp);
-	//inv_enable_irq();
-	
-	/*
-	 * Extend the 16-bit timestamp from the Ixm42xxx FIFO to a 64 bits timestamp.
+	 * Extend the 16-bit timestamp from the Ixm42xxx FIFO to a 64 bits timestamp,
+	 * locked on the FIFO threshold interrupts.
 	 */
 	inv_helper_extend_timestamp_from_fifo(&icm_driver, &clk_calib, event->timestamp_fsync, irq_timestamp, event->sensor_mask, &extended_timestamp);	
 	
@@ -21,6 +21,10 @@
 
 /* InvenSense utils */
 #include "Message.h"
+#include "RingBuffer.h"
+
+/* Ixm42xxx driver timebase, shared by the interrupt timestamps */
+#include "Ixm42xxxExtFunc.h"
 
 /* std */
 #include <stdio.h>
@@ -82,10 +86,10 @@
  * -------------------------------------------------------------------------------------- */
 
 /* 
- * Buffer to keep track of the timestamp when ixm42xxx data ready interrupt fires.
- * The buffer can contain up to 64 items in order to store one timestamp for each packet in FIFO.
+ * Buffer to keep track of the timestamp when ixm42xxx FIFO threshold interrupt fires.
+ * The buffer holds one timestamp per FIFO read, whatever the number of packets read.
  */
-//RINGBUFFER(timestamp_buffer, 64, uint64_t);
+RINGBUFFER_VOLATILE(timestamp_buffer, 64, uint64_t);
 
 
 /* --------------------------------------------------------------------------------------
@@ -268,24 +272,18 @@ static void SetupMCUHardware(struct inv_ixm42xxx_serif * icm_serif)
  */
 static void ext_interrupt_cb(void * context, unsigned int int_num)
 {
-	(void)context;
-
-#if USE_CLK_IN
-	/* 
-	 * Read timestamp from the RTC derived from SLCK, clocking CLKIN
-	 */
-	//uint64_t timestamp = rtc_timer_get_time_us();
-#else
 	/* 
-	 * Read timestamp from the timer dedicated to timestamping 
+	 * Read timestamp from the timebase given to the driver (RTC derived from SLCK when
+	 * CLKIN is used, timer dedicated to timestamping otherwise), see inv_ixm42xxx_get_time_us()
 	 */
-	//uint64_t timestamp = inv_timer_get_counter(TIMEBASE_TIMER);
-#endif
+	uint64_t timestamp = inv_ixm42xxx_get_time_us();
 
-	//if(int_num == INV_GPIO_INT1) {
-	//	if (!RINGBUFFER_FULL(&timestamp_buffer))
-	//		RINGBUFFER_PUSH(&timestamp_buffer, &timestamp);
-	//}
+	(void)context;
+
+	if(int_num == INV_GPIO_INT1) {
+		if (!RINGBUFFER_VOLATILE_FULL(&timestamp_buffer))
+			RINGBUFFER_VOLATILE_PUSH(&timestamp_buffer, &timestamp);
+	}
 
 	irq_from_device |= TO_MASK(int_num);
 }
@@ -0,0 +1,613 @@
+#include "iim42652_sim.h"
+#include <string.h>
+
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxExtFunc.h"
+#include "InvError.h"
+
+#define SIM_TMST_MASK       0xFFFFF     // 20 位时间戳计数器
+#define SIM_MAX_STEP_NS     1000000000000ULL
+#define SIM_TMST_DELTA_EN   0x04        // TMST_CONFIG.TMST_DELTA_EN, Ixm42xxxDefs.h 中未定义
+
+static void sim_reset_registers(struct iim42652_sim *sim);
+static void sim_schedule(struct iim42652_sim *sim);
+
+static uint64_t sim_host_time_ns(struct iim42652_sim *sim)
+{
+    if (sim->cfg.get_time_ns)
+        return sim->cfg.get_time_ns(sim->cfg.time_ctx);
+    return inv_ixm42xxx_get_time_us() * 1000ULL;
+}
+
+static void sim_default_generate(void *ctx, uint32_t index, int32_t accel[3], int32_t gyro[3], int16_t *temperature)
+{
+    (void)ctx;
+    // accel X 的高 16 位是一个 14 位的递增锯齿波，可以从任意一个包反推出样本序号
+    int32_t ramp = (int32_t)(index & 0x3FFF) - 0x2000;
+
+    accel[0] = ramp * 16 + (int32_t)(index & 0xF);
+    accel[1] = -ramp * 16;
+    accel[2] = 2048 * 16;
+    gyro[0] = (int32_t)(index % 200) * 16 - 1600;
+    gyro[1] = 0;
+    gyro[2] = -(int32_t)(index & 0xF);
+    *temperature = 662;    // 约 30 摄氏度
+}
+
+uint32_t iim42652_sim_ramp_index(int16_t accel_x_16)
+{
+    return (uint32_t)((int32_t)accel_x_16 + 0x2000) & 0x3FFF;
+}
+
+/* ODR 位域 -> 周期 (ns)，0 表示保留值 */
+static uint32_t sim_odr_period_ns(uint8_t odr)
+{
+    static const uint32_t period_ns[16] = {
+        0,          31250,      62500,      125000,
+        250000,     500000,     1000000,    5000000,
+        10000000,   20000000,   40000000,   80000000,
+        160000000,  320000000,  640000000,  2000000,
+    };
+    return period_ns[odr & 0x0F];
+}
+
+static uint8_t *sim_reg(struct iim42652_sim *sim, uint8_t bank, uint8_t reg)
+{
+    return &sim->regs[bank][reg & (IIM42652_SIM_BANK_SIZE - 1)];
+}
+
+static uint32_t sim_tmst_res_us(struct iim42652_sim *sim)
+{
+    return (sim->regs[0][MPUREG_TMST_CONFIG] & BIT_TMST_CONFIG_RESOL_MASK) ? 16 : 1;
+}
+
+static uint32_t sim_tmst_at(struct iim42652_sim *sim, uint64_t dev_ns)
+{
+    return (uint32_t)(((dev_ns - sim->tmst_epoch_ns) / 1000 / sim_tmst_res_us(sim)) & SIM_TMST_MASK);
+}
+
+static void sim_put16(struct iim42652_sim *sim, uint8_t *dst, int16_t v)
+{
+    uint16_t u = (uint16_t)v;
+
+    if (sim->regs[0][MPUREG_INTF_CONFIG0] & BIT_DATA_ENDIAN_MASK) {
+        dst[0] = (uint8_t)(u >> 8);
+        dst[1] = (uint8_t)u;
+    } else {
+        dst[0] = (uint8_t)u;
+        dst[1] = (uint8_t)(u >> 8);
+    }
+}
+
+static void sim_fifo_flush(struct iim42652_sim *sim)
+{
+    sim->fifo_head = 0;
+    sim->fifo_bytes = 0;
+    sim->rec_head = 0;
+    sim->rec_count = 0;
+    sim->rec_read = 0;
+}
+
+static uint16_t sim_fifo_count(struct iim42652_sim *sim)
+{
+    if (sim->regs[0][MPUREG_INTF_CONFIG0] & BIT_FIFO_COUNT_REC_MASK)
+        return sim->rec_count;
+    return sim->fifo_bytes;
+}
+
+/* 丢弃最老的一个完整记录（stream 模式下 FIFO 满时覆盖） */
+static void sim_fifo_drop_oldest(struct iim42652_sim *sim)
+{
+    uint8_t left = (uint8_t)(sim->rec_size[sim->rec_head] - sim->rec_read);
+
+    sim->fifo_head = (uint16_t)((sim->fifo_head + left) % IIM42652_SIM_FIFO_SIZE);
+    sim->fifo_bytes -= left;
+    sim->rec_head = (uint16_t)((sim->rec_head + 1) % sizeof(sim->rec_size));
+    sim->rec_count--;
+    sim->rec_read = 0;
+}
+
+static void sim_fifo_push(struct iim42652_sim *sim, const uint8_t *pkt, uint8_t size)
+{
+    uint8_t fifo_mode = sim->regs[0][MPUREG_FIFO_CONFIG] & BIT_FIFO_CONFIG_MODE_MASK;
+    uint16_t wm, count;
+    uint16_t tail;
+    uint8_t i;
+
+    if (sim->fifo_bytes + size > IIM42652_SIM_FIFO_SIZE) {
+        sim->regs[0][MPUREG_INT_STATUS] |= BIT_INT_STATUS_FIFO_FULL;
+        if (fifo_mode != (uint8_t)IXM42XXX_FIFO_CONFIG_MODE_STREAM) {
+            // stop-on-full：新数据丢弃
+            sim->lost_pkt++;
+            sim->stats.packets_dropped++;
+            return;
+        }
+        while (sim->fifo_bytes + size > IIM42652_SIM_FIFO_SIZE) {
+            sim_fifo_drop_oldest(sim);
+            sim->lost_pkt++;
+            sim->stats.packets_dropped++;
+        }
+    }
+
+    tail = (uint16_t)((sim->fifo_head + sim->fifo_bytes) % IIM42652_SIM_FIFO_SIZE);
+    for (i = 0; i < size; i++)
+        sim->fifo[(tail + i) % IIM42652_SIM_FIFO_SIZE] = pkt[i];
+    sim->fifo_bytes += size;
+    sim->rec_size[(sim->rec_head + sim->rec_count) % sizeof(sim->rec_size)] = size;
+    sim->rec_count++;
+    sim->stats.packets_produced++;
+
+    if (sim->fifo_bytes + IIM42652_SIM_FIFO_MIN_PACKET > IIM42652_SIM_FIFO_SIZE)
+        sim->regs[0][MPUREG_INT_STATUS] |= BIT_INT_STATUS_FIFO_FULL;
+
+    wm = (uint16_t)(sim->regs[0][MPUREG_FIFO_CONFIG2] | ((sim->regs[0][MPUREG_FIFO_CONFIG3] & 0x0F) << 8));
+    count = sim_fifo_count(sim);
+    if (wm != 0) {
+        if (sim->regs[0][MPUREG_FIFO_CONFIG1] & BIT_FIFO_CONFIG1_WM_GT_TH_MASK) {
+            if (count >= wm)
+                sim->regs[0][MPUREG_INT_STATUS] |= BIT_INT_STATUS_FIFO_THS;
+        } else if (count == wm) {
+            sim->regs[0][MPUREG_INT_STATUS] |= BIT_INT_STATUS_FIFO_THS;
+        }
+    }
+}
+
+static uint8_t sim_fifo_pop(struct iim42652_sim *sim)
+{
+    uint8_t b;
+
+    if (sim->fifo_bytes == 0)
+        return IIM42652_SIM_FIFO_EMPTY_BYTE;
+
+    b = sim->fifo[sim->fifo_head];
+    sim->fifo_head = (uint16_t)((sim->fifo_head + 1) % IIM42652_SIM_FIFO_SIZE);
+    sim->fifo_bytes--;
+    if (++sim->rec_read == sim->rec_size[sim->rec_head]) {
+        sim->rec_head = (uint16_t)((sim->rec_head + 1) % sizeof(sim->rec_size));
+        sim->rec_count--;
+        sim->rec_read = 0;
+    }
+    return b;
+}
+
+/* FSYNC_CONFIG UI_SEL 选中的轴的 LSB 被替换为 FSYNC 标志 */
+static void sim_apply_fsync_tag(uint8_t ui_sel, int fsync, int32_t accel[3], int32_t gyro[3], int16_t *temperature)
+{
+    int32_t *v;
+    int32_t t;
+
+    switch (ui_sel) {
+    case 1:
+        t = (*temperature & ~1) | fsync;
+        *temperature = (int16_t)t;
+        return;
+    case 2: case 3: case 4:
+        v = &gyro[ui_sel - 2];
+        break;
+    case 5: case 6: case 7:
+        v = &accel[ui_sel - 5];
+        break;
+    default:
+        return;
+    }
+    // 标志位于 16 位数据的 LSB，即 20 位值的 bit4
+    *v = (*v & ~0x10) | (fsync << 4);
+}
+
+static void sim_sample(struct iim42652_sim *sim, uint64_t t_ns)
+{
+    uint8_t pwr = sim->regs[0][MPUREG_PWR_MGMT_0];
+    uint8_t cfg1 = sim->regs[0][MPUREG_FIFO_CONFIG1];
+    uint8_t tmst_cfg = sim->regs[0][MPUREG_TMST_CONFIG];
+    uint8_t ui_sel = (sim->regs[0][MPUREG_FSYNC_CONFIG] & BIT_FSYNC_CONFIG_UI_SEL_MASK) >> BIT_FSYNC_CONFIG_UI_SEL_POS;
+    int accel_on = (pwr & BIT_PWR_MGMT_0_ACCEL_MODE_MASK) != 0;
+    int gyro_on = (pwr & BIT_PWR_MGMT_0_GYRO_MODE_MASK) == (uint8_t)IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN;
+    int hires = (cfg1 & BIT_FIFO_CONFIG1_HIRES_MASK) != 0;
+    int has_accel = hires || (cfg1 & BIT_FIFO_CONFIG1_ACCEL_MASK);
+    int has_gyro = hires || (cfg1 & BIT_FIFO_CONFIG1_GYRO_MASK);
+    int fsync = 0;
+    uint32_t fsync_delay = 0;
+    int32_t accel[3], gyro[3];
+    int16_t temperature;
+    int16_t a16[3], g16[3];
+    uint8_t pkt[FIFO_20BYTES_PACKET_SIZE];
+    uint8_t header = 0;
+    uint8_t idx = FIFO_HEADER_SIZE;
+    int i;
+
+    sim->cfg.generate(sim->cfg.generate_ctx, sim->sample_index++, accel, gyro, &temperature);
+
+    if (sim->fsync_pending && ui_sel != 0) {
+        fsync = 1;
+        fsync_delay = (uint32_t)((t_ns - sim->fsync_ns) / 1000 / sim_tmst_res_us(sim));
+        sim->regs[0][MPUREG_TMST_FSYNCH] = (uint8_t)(fsync_delay >> 8);
+        sim->regs[0][MPUREG_TMST_FSYNCL] = (uint8_t)fsync_delay;
+        sim->fsync_pending = 0;
+    }
+    sim_apply_fsync_tag(ui_sel, fsync, accel, gyro, &temperature);
+
+    for (i = 0; i < 3; i++) {
+        if (!accel_on)
+            accel[i] = (int32_t)INVALID_VALUE_FIFO * 16;
+        if (!gyro_on)
+            gyro[i] = (int32_t)INVALID_VALUE_FIFO * 16;
+        a16[i] = (int16_t)(accel[i] >> 4);
+        g16[i] = (int16_t)(gyro[i] >> 4);
+    }
+
+    // 数据寄存器与 FIFO 同步刷新
+    sim_put16(sim, sim_reg(sim, 0, MPUREG_TEMP_DATA1_UI), temperature);
+    for (i = 0; i < 3; i++) {
+        sim_put16(sim, sim_reg(sim, 0, MPUREG_ACCEL_DATA_X1_UI + 2 * i), a16[i]);
+        sim_put16(sim, sim_reg(sim, 0, MPUREG_GYRO_DATA_X1_UI + 2 * i), g16[i]);
+    }
+    sim->regs[0][MPUREG_INT_STATUS] |= BIT_INT_STATUS_DRDY;
+
+    if ((sim->regs[0][MPUREG_FIFO_CONFIG] & BIT_FIFO_CONFIG_MODE_MASK) == (uint8_t)IXM42XXX_FIFO_CONFIG_MODE_BYPASS)
+        return;
+    if (!has_accel && !has_gyro)
+        return;
+
+    if (has_accel) {
+        header |= FIFO_HEADER_ACC;
+        for (i = 0; i < 3; i++, idx += 2)
+            sim_put16(sim, &pkt[idx], a16[i]);
+    }
+    if (has_gyro) {
+        header |= FIFO_HEADER_GYRO;
+        for (i = 0; i < 3; i++, idx += 2)
+            sim_put16(sim, &pkt[idx], g16[i]);
+    }
+    if (hires) {
+        header |= FIFO_HEADER_HEADER_20;
+        sim_put16(sim, &pkt[idx], temperature);
+        idx += 2;
+    } else {
+        pkt[idx++] = (uint8_t)(int8_t)(temperature / 64);
+    }
+    if (has_accel && has_gyro) {
+        uint16_t ts = 0;
+
+        if (fsync && (tmst_cfg & BIT_TMST_CONFIG_TMST_FSYNC_MASK)) {
+            header |= FIFO_HEADER_TMST | FIFO_HEADER_FSYNC;
+            ts = (uint16_t)fsync_delay;
+        } else if ((cfg1 & BIT_FIFO_CONFIG1_TMST_FSYNC_MASK) && (tmst_cfg & BIT_TMST_CONFIG_TMST_EN_MASK)) {
+            header |= FIFO_HEADER_TMST;
+            if (tmst_cfg & SIM_TMST_DELTA_EN)
+                ts = (uint16_t)((t_ns - sim->last_ts_ns) / 1000 / sim_tmst_res_us(sim));
+            else
+                ts = (uint16_t)sim_tmst_at(sim, t_ns);
+        }
+        sim->last_ts_ns = t_ns;
+        sim_put16(sim, &pkt[idx], (int16_t)ts);
+        idx += 2;
+    }
+    if (hires) {
+        for (i = 0; i < 3; i++)
+            pkt[idx++] = (uint8_t)(((accel[i] & 0xF) << 4) | (gyro[i] & 0xF));
+    }
+    pkt[0] = header;
+
+    sim_fifo_push(sim, pkt, idx);
+}
+
+static void sim_advance(struct iim42652_sim *sim)
+{
+    uint64_t now = sim_host_time_ns(sim);
+    uint64_t elapsed, scaled;
+
+    if (now <= sim->host_ns)
+        return;
+    elapsed = now - sim->host_ns;
+    sim->host_ns = now;
+
+    while (elapsed) {
+        uint64_t step = elapsed > SIM_MAX_STEP_NS ? SIM_MAX_STEP_NS : elapsed;
+
+        scaled = step * (uint64_t)(1000000 + sim->cfg.drift_ppm) + sim->drift_rem;
+        sim->dev_ns += scaled / 1000000;
+        sim->drift_rem = scaled % 1000000;
+        elapsed -= step;
+    }
+
+    while (sim->next_sample_ns != 0 && sim->next_sample_ns <= sim->dev_ns) {
+        sim_sample(sim, sim->next_sample_ns);
+        sim->next_sample_ns += sim->period_ns;
+    }
+}
+
+/* 传感器开关或 ODR 改变后重新计算采样节拍 */
+static void sim_schedule(struct iim42652_sim *sim)
+{
+    uint8_t pwr = sim->regs[0][MPUREG_PWR_MGMT_0];
+    uint32_t accel_period = 0, gyro_period = 0, period;
+
+    if (pwr & BIT_PWR_MGMT_0_ACCEL_MODE_MASK)
+        accel_period = sim_odr_period_ns(sim->regs[0][MPUREG_ACCEL_CONFIG0] & BIT_ACCEL_CONFIG0_ODR_MASK);
+    if ((pwr & BIT_PWR_MGMT_0_GYRO_MODE_MASK) == (uint8_t)IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN)
+        gyro_period = sim_odr_period_ns(sim->regs[0][MPUREG_GYRO_CONFIG0] & BIT_GYRO_CONFIG0_ODR_MASK);
+
+    if (accel_period && gyro_period)
+        period = accel_period < gyro_period ? accel_period : gyro_period;
+    else
+        period = accel_period ? accel_period : gyro_period;
+
+    if (period == 0) {
+        sim->next_sample_ns = 0;
+        sim->period_ns = 0;
+        return;
+    }
+    if (sim->next_sample_ns == 0) {
+        sim->sample_index = 0;
+        sim->next_sample_ns = sim->dev_ns + period;
+    } else if (period != sim->period_ns) {
+        sim->next_sample_ns = sim->next_sample_ns - sim->period_ns + period;
+    }
+    sim->period_ns = period;
+}
+
+static void sim_reset_registers(struct iim42652_sim *sim)
+{
+    memset(sim->regs, 0, sizeof(sim->regs));
+
+    sim->regs[0][MPUREG_DRIVE_CONFIG]       = 0x05;
+    sim->regs[0][MPUREG_INTF_CONFIG0]       = 0x30;
+    sim->regs[0][MPUREG_INTF_CONFIG1]       = 0x91;
+    sim->regs[0][MPUREG_GYRO_CONFIG0]       = 0x06;
+    sim->regs[0][MPUREG_ACCEL_CONFIG0]      = 0x06;
+    sim->regs[0][MPUREG_GYRO_CONFIG1]       = 0x16;
+    sim->regs[0][MPUREG_GYRO_ACCEL_CONFIG0] = 0x11;
+    sim->regs[0][MPUREG_ACCEL_CONFIG1]      = 0x0D;
+    sim->regs[0][MPUREG_TMST_CONFIG]        = 0x23;
+    sim->regs[0][MPUREG_FSYNC_CONFIG]       = 0x10;
+    sim->regs[0][MPUREG_INT_CONFIG1]        = 0x10;
+    sim->regs[0][MPUREG_INT_SOURCE0]        = 0x10;
+    sim->regs[0][MPUREG_WHO_AM_I]           = ICM_WHOAMI;
+    sim->regs[0][MPUREG_TEMP_DATA1_UI]      = 0x80;
+    sim->regs[0][MPUREG_ACCEL_DATA_X1_UI]     = 0x80;
+    sim->regs[0][MPUREG_ACCEL_DATA_X1_UI + 2] = 0x80;
+    sim->regs[0][MPUREG_ACCEL_DATA_X1_UI + 4] = 0x80;
+    sim->regs[0][MPUREG_GYRO_DATA_X1_UI]      = 0x80;
+    sim->regs[0][MPUREG_GYRO_DATA_X1_UI + 2]  = 0x80;
+    sim->regs[0][MPUREG_GYRO_DATA_X1_UI + 4]  = 0x80;
+
+    sim->regs[1][MPUREG_GYRO_CONFIG_STATIC2_B1] = 0xA0;
+    sim->regs[1][MPUREG_INTF_CONFIG4_B1]        = 0x83;
+    sim->regs[1][MPUREG_INTF_CONFIG6_B1]        = 0x5F;
+
+    sim->regs[2][MPUREG_ACCEL_CONFIG_STATIC2_B2] = 0x30;
+
+    sim->regs[4][MPUREG_APEX_CONFIG1_B4] = 0xA2;
+    sim->regs[4][MPUREG_APEX_CONFIG2_B4] = 0x85;
+
+    sim_fifo_flush(sim);
+    sim->lost_pkt = 0;
+    sim->next_sample_ns = 0;
+    sim->period_ns = 0;
+    sim->fsync_pending = 0;
+    sim->tmst_epoch_ns = sim->dev_ns;
+    sim->last_ts_ns = sim->dev_ns;
+}
+
+void iim42652_sim_init(struct iim42652_sim *sim, const struct iim42652_sim_config *cfg)
+{
+    memset(sim, 0, sizeof(*sim));
+    if (cfg)
+        sim->cfg = *cfg;
+    if (!sim->cfg.generate)
+        sim->cfg.generate = sim_default_generate;
+
+    sim->host_ns = sim_host_time_ns(sim);
+    sim_reset_registers(sim);
+    sim->regs[0][MPUREG_INT_STATUS] = BIT_INT_STATUS_RESET_DONE;
+}
+
+void iim42652_sim_bind_serif(struct iim42652_sim *sim, struct inv_ixm42xxx_serif *serif, IXM42XXX_SERIAL_IF_TYPE_t serif_type)
+{
+    serif->context = sim;
+    serif->read_reg = iim42652_sim_read_reg;
+    serif->write_reg = iim42652_sim_write_reg;
+    serif->configure = iim42652_sim_configure;
+    serif->max_read = 1024 * 32;
+    serif->max_write = 1024 * 32;
+    serif->serif_type = serif_type;
+}
+
+int iim42652_sim_configure(struct inv_ixm42xxx_serif *serif)
+{
+    // I3C 动态地址分配由主控完成，模型无需处理
+    (void)serif;
+    return INV_ERROR_SUCCESS;
+}
+
+static uint8_t sim_read_byte(struct iim42652_sim *sim, uint8_t bank, uint8_t reg)
+{
+    uint8_t v;
+    uint16_t count;
+
+    if (reg == MPUREG_REG_BANK_SEL)
+        return sim->regs[0][MPUREG_REG_BANK_SEL];
+    if (bank != 0)
+        return *sim_reg(sim, bank, reg);
+
+    switch (reg) {
+    case MPUREG_INT_STATUS:
+        v = sim->regs[0][MPUREG_INT_STATUS];
+        sim->regs[0][MPUREG_INT_STATUS] = 0;    // 读清
+        return v;
+    case MPUREG_FIFO_COUNTH:
+        // 读第一个字节时锁存整个计数，保证两字节来自同一时刻
+        count = sim_fifo_count(sim);
+        if (sim->regs[0][MPUREG_INTF_CONFIG0] & BIT_FIFO_COUNT_ENDIAN_MASK) {
+            sim->count_latch = (uint8_t)count;
+            return (uint8_t)(count >> 8);
+        }
+        sim->count_latch = (uint8_t)(count >> 8);
+        return (uint8_t)count;
+    case MPUREG_FIFO_COUNTL:
+        return sim->count_latch;
+    case MPUREG_FIFO_DATA:
+        return sim_fifo_pop(sim);
+    case MPUREG_FIFO_LOST_PKT0:
+        return (uint8_t)sim->lost_pkt;
+    case MPUREG_FIFO_LOST_PKT1:
+        return (uint8_t)(sim->lost_pkt >> 8);
+    default:
+        return sim->regs[0][reg];
+    }
+}
+
+static void sim_write_byte(struct iim42652_sim *sim, uint8_t bank, uint8_t reg, uint8_t v)
+{
+    if (reg == MPUREG_REG_BANK_SEL) {
+        sim->regs[0][MPUREG_REG_BANK_SEL] = v & 0x07;
+        return;
+    }
+    if (bank != 0) {
+        *sim_reg(sim, bank, reg) = v;
+        return;
+    }
+
+    switch (reg) {
+    case MPUREG_DEVICE_CONFIG:
+        if (v & BIT_DEVICE_CONFIG_RESET_MASK) {
+            sim_reset_registers(sim);
+            sim->regs[0][MPUREG_INT_STATUS] = BIT_INT_STATUS_RESET_DONE;
+        } else {
+            sim->regs[0][reg] = v;
+        }
+        return;
+    case MPUREG_SIGNAL_PATH_RESET:
+        // 自清零的动作位，不保存
+        if (v & BIT_SIGNAL_PATH_RESET_FIFO_FLUSH_MASK)
+            sim_fifo_flush(sim);
+        if (v & BIT_SIGNAL_PATH_RESET_TMST_STROBE_MASK) {
+            uint32_t tmst = sim_tmst_at(sim, sim->dev_ns);
+
+            sim->regs[1][MPUREG_TMST_VAL0_B1] = (uint8_t)tmst;
+            sim->regs[1][MPUREG_TMST_VAL1_B1] = (uint8_t)(tmst >> 8);
+            sim->regs[1][MPUREG_TMST_VAL2_B1] = (uint8_t)((tmst >> 16) & 0x0F);
+        }
+        return;
+    case MPUREG_FIFO_CONFIG:
+        if ((v & BIT_FIFO_CONFIG_MODE_MASK) == (uint8_t)IXM42XXX_FIFO_CONFIG_MODE_BYPASS)
+            sim_fifo_flush(sim);
+        sim->regs[0][reg] = v;
+        return;
+    case MPUREG_PWR_MGMT_0:
+    case MPUREG_GYRO_CONFIG0:
+    case MPUREG_ACCEL_CONFIG0:
+        sim->regs[0][reg] = v;
+        sim_schedule(sim);
+        return;
+    case MPUREG_INT_STATUS:
+    case MPUREG_FIFO_COUNTH:
+    case MPUREG_FIFO_COUNTL:
+    case MPUREG_FIFO_DATA:
+    case MPUREG_FIFO_LOST_PKT0:
+    case MPUREG_FIFO_LOST_PKT1:
+    case MPUREG_WHO_AM_I:
+        return;    // 只读
+    default:
+        sim->regs[0][reg] = v;
+        return;
+    }
+}
+
+int iim42652_sim_read_reg(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len)
+{
+    struct iim42652_sim *sim = (struct iim42652_sim *)serif->context;
+    uint8_t bank;
+    uint32_t i;
+
+    if (!sim || reg >= IIM42652_SIM_BANK_SIZE)
+        return INV_ERROR_BAD_ARG;
+
+    sim_advance(sim);
+    bank = sim->regs[0][MPUREG_REG_BANK_SEL];
+    if (bank >= IIM42652_SIM_BANK_COUNT)
+        return INV_ERROR_BAD_ARG;
+
+    // 模拟总线中断：前一半字节已出 FIFO，事务以错误结束
+    if (bank == 0 && reg <= MPUREG_FIFO_DATA && reg + len > MPUREG_FIFO_DATA) {
+        sim->stats.fifo_reads++;
+        if (sim->cfg.fifo_read_fault_every && (sim->stats.fifo_reads % sim->cfg.fifo_read_fault_every) == 0) {
+            for (i = 0; i < len / 2; i++) {
+                buf[i] = sim_read_byte(sim, bank, reg);
+                if (reg != MPUREG_FIFO_DATA)
+                    reg++;
+            }
+            sim->stats.read_faults++;
+            return INV_ERROR_TRANSPORT;
+        }
+    }
+
+    for (i = 0; i < len; i++) {
+        buf[i] = sim_read_byte(sim, bank, reg);
+        // 连续读在 FIFO_DATA 处停止自增，与 burst 读 FIFO 的行为一致
+        if (!(bank == 0 && reg == MPUREG_FIFO_DATA) && reg < IIM42652_SIM_BANK_SIZE - 1)
+            reg++;
+    }
+    sim->stats.read_count++;
+    sim->stats.bytes_read += len;
+    return INV_ERROR_SUCCESS;
+}
+
+int iim42652_sim_write_reg(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len)
+{
+    struct iim42652_sim *sim = (struct iim42652_sim *)serif->context;
+    uint32_t i;
+
+    if (!sim || reg >= IIM42652_SIM_BANK_SIZE)
+        return INV_ERROR_BAD_ARG;
+
+    sim_advance(sim);
+    for (i = 0; i < len; i++) {
+        uint8_t bank = sim->regs[0][MPUREG_REG_BANK_SEL];
+
+        if (bank >= IIM42652_SIM_BANK_COUNT)
+            return INV_ERROR_BAD_ARG;
+        sim_write_byte(sim, bank, reg, buf[i]);
+        if (reg < IIM42652_SIM_BANK_SIZE - 1)
+            reg++;
+    }
+    sim->stats.write_count++;
+    sim->stats.bytes_written += len;
+    return INV_ERROR_SUCCESS;
+}
+
+void iim42652_sim_set_drift_ppm(struct iim42652_sim *sim, int32_t drift_ppm)
+{
+    sim_advance(sim);
+    sim->cfg.drift_ppm = drift_ppm;
+}
+
+void iim42652_sim_update(struct iim42652_sim *sim)
+{
+    sim_advance(sim);
+}
+
+void iim42652_sim_trigger_fsync(struct iim42652_sim *sim)
+{
+    sim_advance(sim);
+    sim->fsync_pending = 1;
+    sim->fsync_ns = sim->dev_ns;
+    sim->regs[0][MPUREG_INT_STATUS] |= BIT_INT_STATUS_UI_FSYNC;
+}
+
+int iim42652_sim_int1_asserted(struct iim42652_sim *sim)
+{
+    sim_advance(sim);
+    return (sim->regs[0][MPUREG_INT_STATUS] & sim->regs[0][MPUREG_INT_SOURCE0]) != 0;
+}
+
+uint32_t iim42652_sim_get_tmst(struct iim42652_sim *sim)
+{
+    sim_advance(sim);
+    return sim_tmst_at(sim, sim->dev_ns);
+}
+
+void iim42652_sim_reset_stats(struct iim42652_sim *sim)
+{
+    memset(&sim->stats, 0, sizeof(sim->stats));
+}
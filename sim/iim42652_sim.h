@@ -0,0 +1,167 @@
+#ifndef _IIM42652_SIM_H_
+#define _IIM42652_SIM_H_
+
+#include <stdint.h>
+#include "Ixm42xxxTransport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of register banks modelled (bank 0 .. bank 4) */
+#define IIM42652_SIM_BANK_COUNT     5
+
+/** Registers per bank, addresses are 7 bits on the serial interface */
+#define IIM42652_SIM_BANK_SIZE      128
+
+/** Hardware FIFO size in bytes */
+#define IIM42652_SIM_FIFO_SIZE      2048
+
+/** Smallest FIFO packet (accel or gyro only), bounds the number of records held */
+#define IIM42652_SIM_FIFO_MIN_PACKET 8
+
+/** Value returned by FIFO_DATA when the FIFO is empty (header with MSG bit set) */
+#define IIM42652_SIM_FIFO_EMPTY_BYTE 0x80
+
+/**
+ * @brief Sample source called once per ODR tick
+ * @param[in] ctx          iim42652_sim_config::generate_ctx
+ * @param[in] index        Sample index since the sensors were last enabled
+ * @param[out] accel       Accel in 20-bit LSB (16-bit data register value << 4 | hi-res nibble)
+ * @param[out] gyro        Gyro in 20-bit LSB
+ * @param[out] temperature Temperature in TEMP_DATA LSB (132.48 LSB/degC, 0 is 25 degC)
+ */
+typedef void (*iim42652_sim_generate_t)(void *ctx, uint32_t index, int32_t accel[3], int32_t gyro[3], int16_t *temperature);
+
+/**
+ * @brief Simulator configuration, copied by iim42652_sim_init()
+ */
+struct iim42652_sim_config {
+    uint64_t (*get_time_ns)(void *ctx); /**< host time base, NULL uses inv_ixm42xxx_get_time_us() */
+    void *time_ctx;                     /**< passed to get_time_ns */
+    int32_t drift_ppm;                  /**< device oscillator error vs host time base, positive runs fast */
+    iim42652_sim_generate_t generate;   /**< NULL selects a deterministic ramp, see iim42652_sim_ramp_index() */
+    void *generate_ctx;                 /**< passed to generate */
+    uint32_t fifo_read_fault_every;     /**< every Nth read covering FIFO_DATA stops halfway and fails, 0 disables */
+};
+
+/**
+ * @brief Bus and FIFO activity seen by the simulator
+ */
+struct iim42652_sim_stats {
+    uint32_t read_count;        /**< read_reg transactions */
+    uint32_t write_count;       /**< write_reg transactions */
+    uint32_t bytes_read;        /**< payload bytes returned by read_reg */
+    uint32_t bytes_written;     /**< payload bytes accepted by write_reg */
+    uint32_t packets_produced;  /**< packets pushed into the FIFO */
+    uint32_t packets_dropped;   /**< packets lost on FIFO full (also reported in FIFO_LOST_PKT) */
+    uint32_t fifo_reads;        /**< read_reg transactions covering FIFO_DATA */
+    uint32_t read_faults;       /**< of which cut by iim42652_sim_config::fifo_read_fault_every */
+};
+
+/**
+ * @brief Register-level model of one IIM42652
+ *
+ * Time is sampled from the host time base at the start of every transaction,
+ * so a burst read sees a consistent snapshot of INT_STATUS, FIFO_COUNT and
+ * FIFO_DATA. Accel and gyro are sampled together at the fastest enabled ODR.
+ */
+struct iim42652_sim {
+    struct iim42652_sim_config cfg;
+    uint8_t regs[IIM42652_SIM_BANK_COUNT][IIM42652_SIM_BANK_SIZE];
+
+    uint8_t fifo[IIM42652_SIM_FIFO_SIZE];
+    uint16_t fifo_head;         /**< offset of the next byte to read */
+    uint16_t fifo_bytes;        /**< bytes held, including the unread part of a partially read packet */
+    uint8_t rec_size[IIM42652_SIM_FIFO_SIZE / IIM42652_SIM_FIFO_MIN_PACKET];
+    uint16_t rec_head;          /**< record being read */
+    uint16_t rec_count;         /**< records held, a partially read one included */
+    uint8_t rec_read;           /**< bytes already read from the record at rec_head */
+    uint16_t lost_pkt;          /**< FIFO_LOST_PKT counter */
+    uint8_t count_latch;        /**< second FIFO_COUNT byte latched when the first one is read */
+
+    uint64_t host_ns;           /**< host time of the last update */
+    uint64_t dev_ns;            /**< device oscillator time */
+    uint64_t drift_rem;         /**< sub-ns remainder of the drift scaling */
+    uint64_t tmst_epoch_ns;     /**< device time when the timestamp counter was last reset */
+    uint64_t next_sample_ns;    /**< device time of the next ODR tick, 0 when sensors are off */
+    uint32_t period_ns;         /**< current ODR period */
+    uint32_t sample_index;
+    uint64_t last_ts_ns;        /**< device time of the previous FIFO timestamp, for TMST_DELTA_EN */
+
+    uint8_t fsync_pending;      /**< FSYNC edge seen, next packet is tagged */
+    uint64_t fsync_ns;          /**< device time of the pending FSYNC edge */
+
+    struct iim42652_sim_stats stats;
+};
+
+/**
+ * @brief Power-on the model: registers at reset value, empty FIFO
+ * @param[out] sim  Simulator instance
+ * @param[in] cfg   Configuration, NULL for a drift-free device on inv_ixm42xxx_get_time_us()
+ */
+void iim42652_sim_init(struct iim42652_sim *sim, const struct iim42652_sim_config *cfg);
+
+/**
+ * @brief Fill a serif so the driver talks to the model
+ *
+ * read_reg/write_reg/configure are set to the simulator hooks, context to
+ * sim and max_read/max_write to 32 KiB like the reference examples. The caller may
+ * lower them afterwards to mimic a given bus.
+ */
+void iim42652_sim_bind_serif(struct iim42652_sim *sim, struct inv_ixm42xxx_serif *serif, IXM42XXX_SERIAL_IF_TYPE_t serif_type);
+
+/**
+ * @brief inv_ixm42xxx_serif hooks, serif->context must point to a struct iim42652_sim
+ */
+int iim42652_sim_read_reg(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len);
+int iim42652_sim_write_reg(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief inv_ixm42xxx_serif configure hook, called by the driver for I3C (dynamic address assignment)
+ */
+int iim42652_sim_configure(struct inv_ixm42xxx_serif *serif);
+
+/**
+ * @brief Change the oscillator error at run time
+ */
+void iim42652_sim_set_drift_ppm(struct iim42652_sim *sim, int32_t drift_ppm);
+
+/**
+ * @brief Bring the model up to the current host time without a bus access
+ */
+void iim42652_sim_update(struct iim42652_sim *sim);
+
+/**
+ * @brief Raise an FSYNC edge now; the next ODR packet is tagged when FSYNC_CONFIG selects a tag
+ */
+void iim42652_sim_trigger_fsync(struct iim42652_sim *sim);
+
+/**
+ * @brief Level of INT1 as configured by INT_SOURCE0 (active high, latched mode)
+ * @return 1 when an enabled INT_STATUS source is pending, 0 otherwise
+ */
+int iim42652_sim_int1_asserted(struct iim42652_sim *sim);
+
+/**
+ * @brief Device timestamp counter (TMST resolution units, 20 bits) at the current host time
+ */
+uint32_t iim42652_sim_get_tmst(struct iim42652_sim *sim);
+
+/**
+ * @brief Recover the sample index from the accel X value produced by the default generator
+ * @param[in] accel_x_16  16-bit accel X as reported by the driver
+ * @return sample index modulo 0x4000
+ */
+uint32_t iim42652_sim_ramp_index(int16_t accel_x_16);
+
+/**
+ * @brief Reset bus and FIFO statistics
+ */
+void iim42652_sim_reset_stats(struct iim42652_sim *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Ixm42xxxDriver_HL.h"
+#include "InvError.h"
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxExtFunc.h"
+#include "Ixm42xxxConfig.h"
+#include "iim42652_sim.h"
+#include "sim_platform.h"
+#include "sim_checks.h"
+
+/* One acquisition run: fresh device, fixed ODR, periodic FIFO drains */
+struct sim_scenario {
+    const char *name;
+    IXM42XXX_ACCEL_CONFIG0_ODR_t accel_odr;
+    IXM42XXX_GYRO_CONFIG0_ODR_t gyro_odr;
+    uint32_t period_ns;                     // 期望的采样周期
+    uint8_t high_res;
+    INV_IXM42XXX_FIFO_DRAIN_MODE_t drain_mode;
+    uint32_t poll_us;                       // 两次读 FIFO 之间的间隔
+    uint32_t duration_ms;
+    int32_t drift_ppm;
+    uint8_t fifo_pool;                      // 读入调用方注册的缓冲区，再按 batch 解码
+    uint8_t count_bytes;                    // FIFO_COUNT 以字节计，跨次读取拼接半包
+    uint32_t fault_every;                   // 每 N 次 FIFO 读中断一次，0 不注入
+};
+
+static const struct sim_scenario scenarios[] = {
+    { .name = "1k-seq", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_1_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_1_KHZ, .period_ns = 1000000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_SEQUENTIAL, .poll_us = 10000, .duration_ms = 500 },
+    { .name = "1k-burst", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_1_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_1_KHZ, .period_ns = 1000000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 10000, .duration_ms = 500 },
+    { .name = "4k-burst", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_4_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_4_KHZ, .period_ns = 250000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500 },
+    { .name = "8k-burst", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_8_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_8_KHZ, .period_ns = 125000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500 },
+    { .name = "8k-hires", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_8_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_8_KHZ, .period_ns = 125000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500, .high_res = 1 },
+    { .name = "8k-drift+500", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_8_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_8_KHZ, .period_ns = 125000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 1000, .drift_ppm = 500 },
+    { .name = "8k-drift-500", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_8_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_8_KHZ, .period_ns = 125000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_SEQUENTIAL, .poll_us = 1000, .duration_ms = 1000, .drift_ppm = -500 },
+    { .name = "4k-pool", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_4_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_4_KHZ, .period_ns = 250000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500, .fifo_pool = 1 },
+    { .name = "4k-bytes-seq", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_4_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_4_KHZ, .period_ns = 250000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_SEQUENTIAL, .poll_us = 5000, .duration_ms = 500, .count_bytes = 1 },
+    { .name = "8k-bytes", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_8_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_8_KHZ, .period_ns = 125000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500, .high_res = 1, .count_bytes = 1 },
+    { .name = "4k-fault-rec", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_4_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_4_KHZ, .period_ns = 250000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500, .fault_every = 7 },
+    { .name = "4k-fault-byte", .accel_odr = IXM42XXX_ACCEL_CONFIG0_ODR_4_KHZ, .gyro_odr = IXM42XXX_GYRO_CONFIG0_ODR_4_KHZ, .period_ns = 250000,
+      .drain_mode = INV_IXM42XXX_FIFO_DRAIN_BURST, .poll_us = 5000, .duration_ms = 500, .count_bytes = 1, .fault_every = 7 },
+};
+
+struct sim_check {
+    uint32_t events;
+    uint32_t gaps;          // 样本序号不连续
+    uint32_t missing;       // 缺失的样本数
+    uint32_t ts_errors;     // FIFO 时间戳间隔与 ODR 不符
+    uint32_t expected_ticks;
+    uint32_t last_index;
+    uint16_t last_ts;
+    uint8_t started;
+};
+
+#define SIM_POOL_BUFFERS     2
+#define SIM_POOL_BUFFER_SIZE 512
+
+static struct inv_ixm42xxx sensor_driver;
+static struct iim42652_sim sim;
+static struct sim_check check;
+
+static uint8_t pool_mem[SIM_POOL_BUFFERS][SIM_POOL_BUFFER_SIZE] __attribute__((aligned(64)));
+static inv_ixm42xxx_fifo_buffer_t pool[SIM_POOL_BUFFERS];
+
+static void handle_fifo_data(inv_ixm42xxx_sensor_event_t *event)
+{
+    uint32_t index;
+    uint16_t dt;
+
+    // 启动阶段驱动会丢弃加速度数据，只检查有效包
+    if (!(event->sensor_mask & (1 << INV_IXM42XXX_SENSOR_ACCEL)))
+        return;
+
+    index = iim42652_sim_ramp_index(event->accel[0]);
+    check.events++;
+    if (check.started) {
+        if (index != ((check.last_index + 1) & 0x3FFF)) {
+            check.gaps++;
+            check.missing += (index - check.last_index - 1) & 0x3FFF;
+        }
+        dt = (uint16_t)(event->timestamp_fsync - check.last_ts);
+        if ((uint32_t)dt + 1 < check.expected_ticks || dt > check.expected_ticks + 1)
+            check.ts_errors++;
+    }
+    check.started = 1;
+    check.last_index = index;
+    check.last_ts = event->timestamp_fsync;
+}
+
+/* 从调用方缓冲区取一次 burst，解码后逐包送入 handle_fifo_data */
+static int drain_pool(void)
+{
+    static int32_t accel[3][IXM42XXX_FIFO_MAX_PACKETS], gyro[3][IXM42XXX_FIFO_MAX_PACKETS];
+    static int16_t temperature[IXM42XXX_FIFO_MAX_PACKETS];
+    static uint16_t timestamp_fsync[IXM42XXX_FIFO_MAX_PACKETS], sensor_mask[IXM42XXX_FIFO_MAX_PACKETS];
+    inv_ixm42xxx_fifo_batch_t batch = {
+        { accel[0], accel[1], accel[2] }, { gyro[0], gyro[1], gyro[2] },
+        temperature, timestamp_fsync, sensor_mask, IXM42XXX_FIFO_MAX_PACKETS, 0, 0
+    };
+    inv_ixm42xxx_fifo_buffer_t *buffer;
+    inv_ixm42xxx_sensor_event_t event;
+    int rc, i, axis;
+
+    rc = inv_ixm42xxx_get_fifo_buffer(&sensor_driver, &buffer);
+    if (rc <= 0)
+        return rc;
+
+    rc = inv_ixm42xxx_decode_fifo_batch(&sensor_driver, buffer->fifo, buffer->packet_count, &batch);
+    inv_ixm42xxx_add_fifo_buffer(&sensor_driver, buffer);
+    if (rc < 0)
+        return rc;
+
+    memset(&event, 0, sizeof(event));
+    for (i = 0; i < batch.count; i++) {
+        event.sensor_mask = batch.sensor_mask[i];
+        event.timestamp_fsync = batch.timestamp_fsync[i];
+        for (axis = 0; axis < 3; axis++) {
+            event.accel[axis] = (int16_t)batch.accel[axis][i];
+            event.gyro[axis] = (int16_t)batch.gyro[axis][i];
+        }
+        handle_fifo_data(&event);
+    }
+    return batch.count;
+}
+
+static int run_scenario(const struct sim_scenario *sc)
+{
+    struct iim42652_sim_config cfg;
+    struct inv_ixm42xxx_serif serif;
+    inv_ixm42xxx_config_t sensor_cfg;
+    uint32_t drains = 0, packets = 0, tmst_res_us, resync_bytes, wm_reg, wm_expected;
+    uint64_t start_ns, elapsed_ns;
+    int rc, i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.get_time_ns = sim_platform_get_time_ns;
+    cfg.drift_ppm = sc->drift_ppm;
+    cfg.fifo_read_fault_every = sc->fault_every;
+    iim42652_sim_init(&sim, &cfg);
+    iim42652_sim_bind_serif(&sim, &serif, IXM42XXX_UI_SPI4);
+    serif.max_read = 256;
+    serif.max_write = 256;
+
+    memset(&check, 0, sizeof(check));
+    rc = inv_ixm42xxx_init(&sensor_driver, &serif, handle_fifo_data);
+    if (rc != INV_ERROR_SUCCESS) {
+        printf("%-14s init failed (%d)\n", sc->name, rc);
+        return rc;
+    }
+
+    if (sc->fifo_pool) {
+        for (i = 0; i < SIM_POOL_BUFFERS; i++) {
+            pool[i].data = pool_mem[i];
+            pool[i].size = SIM_POOL_BUFFER_SIZE;
+            rc |= inv_ixm42xxx_add_fifo_buffer(&sensor_driver, &pool[i]);
+        }
+    }
+    rc |= inv_ixm42xxx_set_fifo_drain_mode(&sensor_driver, sc->drain_mode);
+    if (sc->count_bytes)
+        rc |= inv_ixm42xxx_set_fifo_count_mode(&sensor_driver, IXM42XXX_INTF_CONFIG0_FIFO_COUNT_REC_BYTE);
+    rc |= inv_ixm42xxx_configure_fifo_wm(&sensor_driver, (uint16_t)((uint64_t)sc->poll_us * 1000 / sc->period_ns));
+    if (sc->high_res)
+        rc |= inv_ixm42xxx_enable_high_resolution_fifo(&sensor_driver);
+    // 量程、ODR 与电源模式一次提交
+    rc |= inv_ixm42xxx_config_begin(&sensor_driver, &sensor_cfg);
+    inv_ixm42xxx_config_set_accel_fsr(&sensor_cfg, IXM42XXX_ACCEL_CONFIG0_FS_SEL_16g);
+    inv_ixm42xxx_config_set_gyro_fsr(&sensor_cfg, IXM42XXX_GYRO_CONFIG0_FS_SEL_2000dps);
+    inv_ixm42xxx_config_set_accel_frequency(&sensor_cfg, sc->accel_odr);
+    inv_ixm42xxx_config_set_gyro_frequency(&sensor_cfg, sc->gyro_odr);
+    inv_ixm42xxx_config_set_accel_mode(&sensor_cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN);
+    inv_ixm42xxx_config_set_gyro_mode(&sensor_cfg, IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN);
+    if (rc == INV_ERROR_SUCCESS)
+        rc |= inv_ixm42xxx_config_commit(&sensor_driver, &sensor_cfg);
+    if (rc != INV_ERROR_SUCCESS) {
+        printf("%-14s configuration failed (%d)\n", sc->name, rc);
+        return rc;
+    }
+
+    // 水位线以包为单位配置，字节计数模式下寄存器里是字节数
+    wm_reg = (uint32_t)(sim.regs[0][MPUREG_FIFO_CONFIG2] | ((sim.regs[0][MPUREG_FIFO_CONFIG3] & 0x0F) << 8));
+    wm_expected = sensor_driver.fifo_wm;
+    if (sc->count_bytes)
+        wm_expected *= sc->high_res ? FIFO_20BYTES_PACKET_SIZE : FIFO_16BYTES_PACKET_SIZE;
+    if (wm_reg != wm_expected) {
+        printf("%-14s FIFO watermark register %u, expected %u\n", sc->name, wm_reg, wm_expected);
+        return INV_ERROR;
+    }
+
+    tmst_res_us = inv_ixm42xxx_get_fifo_timestamp_resolution_us_q24(&sensor_driver) >> 24;
+    check.expected_ticks = sc->period_ns / 1000 / tmst_res_us;
+
+    iim42652_sim_update(&sim);
+    iim42652_sim_reset_stats(&sim);
+    start_ns = sim_platform_get_time_ns(NULL);
+    while (sim_platform_get_time_ns(NULL) - start_ns < (uint64_t)sc->duration_ms * 1000000) {
+        inv_ixm42xxx_sleep_us(sc->poll_us);
+        rc = sc->fifo_pool ? drain_pool() : inv_ixm42xxx_get_data_from_fifo(&sensor_driver);
+        // 注入的总线错误：驱动应在下一次读取时恢复
+        if (rc == INV_ERROR_TRANSPORT && sc->fault_every)
+            rc = 0;
+        if (rc < 0) {
+            printf("%-14s FIFO drain failed (%d)\n", sc->name, rc);
+            return rc;
+        }
+        packets += (uint32_t)rc;
+        drains++;
+    }
+    elapsed_ns = sim_platform_get_time_ns(NULL) - start_ns;
+    inv_ixm42xxx_get_fifo_loss(&sensor_driver, NULL, &resync_bytes);
+
+    printf("%-14s %8u %8u %6u %6u %9.1f %9.2f %9.1f %8u %6u %7u %7u\n",
+           sc->name, packets, check.events, check.gaps, check.ts_errors,
+           (double)sim.stats.packets_produced * 1e9 / (double)elapsed_ns,
+           (double)sim.stats.read_count / drains,
+           (double)sim.stats.bytes_read / drains,
+           sim.stats.packets_dropped, sim.stats.read_faults, check.missing, resync_bytes);
+
+    // 每次中断最多造成一处序号跳变
+    if (check.gaps > sim.stats.read_faults || check.ts_errors > sim.stats.read_faults)
+        return INV_ERROR;
+    return sim.stats.packets_dropped ? INV_ERROR : INV_ERROR_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned i;
+    int failed = 0;
+
+    (void)argc;
+    (void)argv;
+
+    printf("IIM42652 host simulator\n");
+    printf("%-14s %8s %8s %6s %6s %9s %9s %9s %8s %6s %7s %7s\n",
+           "scenario", "packets", "events", "gaps", "ts_err", "odr_hz", "reads/dr", "bytes/dr", "dropped",
+           "faults", "missing", "resync");
+
+    for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (run_scenario(&scenarios[i]) != INV_ERROR_SUCCESS)
+            failed++;
+    }
+
+    if (sim_check_timestamp_paths() != INV_ERROR_SUCCESS)
+        failed++;
+    i++;
+    if (sim_check_drift_tracker() != INV_ERROR_SUCCESS)
+        failed++;
+    i++;
+    if (sim_check_bank_batch() != INV_ERROR_SUCCESS)
+        failed++;
+    i++;
+    if (sim_check_reg_shadow() != INV_ERROR_SUCCESS)
+        failed++;
+    i++;
+
+    printf("%s: %d of %u scenarios failed\n", failed ? "FAIL" : "PASS", failed, i);
+    return failed ? 1 : 0;
+}
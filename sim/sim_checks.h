@@ -0,0 +1,45 @@
+#ifndef _SIM_CHECKS_H_
+#define _SIM_CHECKS_H_
+
+#include "InvError.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Checks run by the simulator after the acquisition scenarios
+ *
+ * Each check brings up its own simulated device, prints one result line
+ * and returns INV_ERROR_SUCCESS when it passed.
+ */
+
+/**
+ * @brief Same FIFO bursts through inv_helper_extend_timestamp_from_fifo() packet by packet
+ *        and through inv_helper_extend_timestamps_from_fifo_batch(), compare the timestamps
+ */
+int sim_check_timestamp_paths(void);
+
+/**
+ * @brief Interrupt driven FIFO reads with latency and a drift step, both timestamp paths
+ *        checked for lock and against the time each sample was produced
+ */
+int sim_check_drift_tracker(void);
+
+/**
+ * @brief WOM and APEX configuration through bank batches, bank switches and reads
+ *        counted in transport_stats, register values checked in the model
+ */
+int sim_check_bank_batch(void);
+
+/**
+ * @brief Register shadow: repeated reconfiguration without reads of shadowed registers,
+ *        volatile registers always read from the device, write-back flush, soft reset
+ */
+int sim_check_reg_shadow(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+#include "sim_platform.h"
+#include "Ixm42xxxExtFunc.h"
+
+static uint64_t sim_time_ns;
+
+uint64_t sim_platform_get_time_ns(void *ctx)
+{
+    (void)ctx;
+    return sim_time_ns;
+}
+
+void sim_platform_advance_ns(uint64_t ns)
+{
+    sim_time_ns += ns;
+}
+
+void inv_ixm42xxx_sleep_us(uint32_t us)
+{
+    sim_time_ns += (uint64_t)us * 1000;
+}
+
+uint64_t inv_ixm42xxx_get_time_us(void)
+{
+    return sim_time_ns / 1000;
+}
+
+void inv_helper_disable_irq(void)
+{
+    // 单线程仿真，无需屏蔽中断
+}
+
+void inv_helper_enable_irq(void)
+{
+}
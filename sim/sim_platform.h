@@ -0,0 +1,33 @@
+#ifndef _SIM_PLATFORM_H_
+#define _SIM_PLATFORM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Virtual clock replacing src/platform.c on the host
+ *
+ * inv_ixm42xxx_sleep_us() advances the clock instead of blocking, so a
+ * simulated second at 8 kHz runs in a few milliseconds and every run is
+ * reproducible. Time only moves on sleep or sim_platform_advance_ns().
+ */
+
+/**
+ * @brief Current virtual time, usable as iim42652_sim_config::get_time_ns
+ * @param[in] ctx Unused
+ */
+uint64_t sim_platform_get_time_ns(void *ctx);
+
+/**
+ * @brief Move the virtual clock forward
+ */
+void sim_platform_advance_ns(uint64_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Ixm42xxxDriver_HL.h"
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxExtFunc.h"
+#include "Ixm42xxxConfig.h"
+#include "helperClockCalib.h"
+#include "iim42652_sim.h"
+#include "sim_platform.h"
+#include "sim_checks.h"
+
+#define TS_PERIOD_US        1000    // 1 kHz
+#define TS_WM               10
+#define TS_DRIFT_PPM        300
+#define TS_POLL_STEP_US     5       // INT1 轮询步长，即中断时间戳的量化误差
+#define TS_READ_DELAY_US    40      // 中断到读 FIFO 之间的延迟上限，每个 burst 不同
+
+// 各阶段起始 burst：无中断读取 / 跟踪 / 切换时间戳分辨率后无中断读取
+#define TS_PHASE_LOCK       10
+#define TS_PHASE_RESOL      100
+#define TS_BURSTS           110
+
+// 水位线之前的包由批量接口按修正后的直线重新插值，两条路径之差不超过一次修正量
+#define TS_MAX_CORRECTION_US 20
+
+// 漂移跟踪：每 100 个样本一次中断，运行中频偏阶跃 +50 ppm
+#define TRK_WM              100
+#define TRK_BURSTS          600
+#define TRK_STEP_BURST      300
+#define TRK_STEP_PPM        50
+#define TRK_IRQ_LATENCY_US  60      // 中断时间戳晚于水位线包产生的上限
+#define TRK_READ_DELAY_US   3000    // 中断到读 FIFO 之间的延迟上限
+#define TRK_SETTLE_BURSTS   10      // 锁定后开始统计误差的 burst
+#define TRK_MAX_MEAN_US     40
+#define TRK_MAX_ERROR_US    100
+
+static struct inv_ixm42xxx ts_driver;
+static struct iim42652_sim ts_sim;
+static clk_calib_t clk_packet, clk_batch;
+
+static int32_t ts_accel[3][IXM42XXX_FIFO_MAX_PACKETS], ts_gyro[3][IXM42XXX_FIFO_MAX_PACKETS];
+static int16_t ts_temperature[IXM42XXX_FIFO_MAX_PACKETS];
+static uint16_t ts_fsync[IXM42XXX_FIFO_MAX_PACKETS], ts_mask[IXM42XXX_FIFO_MAX_PACKETS];
+static uint64_t ts_packet[IXM42XXX_FIFO_MAX_PACKETS], ts_batch[IXM42XXX_FIFO_MAX_PACKETS];
+
+// 每个样本真实产生的主机时刻，按锯齿波序号索引
+static uint64_t trk_true_ns[0x4000];
+static uint32_t trk_rand = 1;
+
+static void ts_ignore_event(inv_ixm42xxx_sensor_event_t *event)
+{
+    (void)event;
+}
+
+/* 默认锯齿波数据，同时记下样本产生时刻：主机时间减去设备时钟已走过的部分按频偏折回 */
+static void trk_generate(void *ctx, uint32_t index, int32_t accel[3], int32_t gyro[3], int16_t *temperature)
+{
+    struct iim42652_sim *sim = (struct iim42652_sim *)ctx;
+    uint64_t late_ns = (sim->dev_ns - sim->next_sample_ns) * 1000000 / (uint64_t)(1000000 + sim->cfg.drift_ppm);
+    int32_t ramp = (int32_t)(index & 0x3FFF) - 0x2000;
+
+    trk_true_ns[index & 0x3FFF] = sim->host_ns - late_ns;
+    accel[0] = ramp * 16;
+    accel[1] = -ramp * 16;
+    accel[2] = 2048 * 16;
+    gyro[0] = gyro[1] = gyro[2] = 0;
+    *temperature = 662;
+}
+
+static uint32_t trk_random(uint32_t range)
+{
+    trk_rand = trk_rand * 1103515245 + 12345;
+    return (trk_rand >> 8) % range;
+}
+
+/* 1 kHz 加速度计 + 陀螺仪，FIFO 水位线中断接 INT1 */
+static int ts_open(const char *name, uint16_t wm, iim42652_sim_generate_t generate)
+{
+    struct iim42652_sim_config cfg;
+    struct inv_ixm42xxx_serif serif;
+    inv_ixm42xxx_config_t sensor_cfg;
+    int rc;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.get_time_ns = sim_platform_get_time_ns;
+    cfg.drift_ppm = TS_DRIFT_PPM;
+    cfg.generate = generate;
+    cfg.generate_ctx = &ts_sim;
+    iim42652_sim_init(&ts_sim, &cfg);
+    iim42652_sim_bind_serif(&ts_sim, &serif, IXM42XXX_UI_SPI4);
+
+    rc = inv_ixm42xxx_init(&ts_driver, &serif, ts_ignore_event);
+    rc |= inv_ixm42xxx_set_fifo_drain_mode(&ts_driver, INV_IXM42XXX_FIFO_DRAIN_BURST);
+    rc |= inv_ixm42xxx_configure_fifo_wm(&ts_driver, wm);
+    rc |= inv_ixm42xxx_config_begin(&ts_driver, &sensor_cfg);
+    inv_ixm42xxx_config_set_accel_frequency(&sensor_cfg, IXM42XXX_ACCEL_CONFIG0_ODR_1_KHZ);
+    inv_ixm42xxx_config_set_gyro_frequency(&sensor_cfg, IXM42XXX_GYRO_CONFIG0_ODR_1_KHZ);
+    inv_ixm42xxx_config_set_accel_mode(&sensor_cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN);
+    inv_ixm42xxx_config_set_gyro_mode(&sensor_cfg, IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN);
+    if (rc == INV_ERROR_SUCCESS)
+        rc |= inv_ixm42xxx_config_commit(&ts_driver, &sensor_cfg);
+    if (rc != INV_ERROR_SUCCESS) {
+        printf("%-14s configuration failed (%d)\n", name, rc);
+        return rc;
+    }
+
+    iim42652_sim_update(&ts_sim);
+    return INV_ERROR_SUCCESS;
+}
+
+/* 以 TS_POLL_STEP_US 为步长推进虚拟时间直到 INT1 拉高，返回边沿时刻，超时返回 0 */
+static uint64_t ts_wait_int1(uint32_t timeout_us)
+{
+    uint32_t waited;
+
+    for (waited = 0; waited < timeout_us; waited += TS_POLL_STEP_US) {
+        if (iim42652_sim_int1_asserted(&ts_sim))
+            return inv_ixm42xxx_get_time_us();
+        inv_ixm42xxx_sleep_us(TS_POLL_STEP_US);
+    }
+    return 0;
+}
+
+/* 等待一次水位线中断（with_irq 为 0 时模拟超时读取）后读出一个 burst */
+static int ts_read_burst(unsigned burst, int with_irq, uint64_t *irq_us, inv_ixm42xxx_fifo_batch_t *batch)
+{
+    *irq_us = 0;
+    if (with_irq) {
+        *irq_us = ts_wait_int1(2 * TS_WM * TS_PERIOD_US);
+        if (*irq_us == 0)
+            return INV_ERROR_TIMEOUT;
+        inv_ixm42xxx_sleep_us((burst * 7919) % TS_READ_DELAY_US);
+    } else {
+        inv_ixm42xxx_sleep_us(TS_WM * TS_PERIOD_US);
+    }
+    return inv_ixm42xxx_get_data_from_fifo_batch(&ts_driver, batch);
+}
+
+int sim_check_timestamp_paths(void)
+{
+    const char *name = "ts-batch";
+    inv_ixm42xxx_fifo_batch_t batch = {
+        { ts_accel[0], ts_accel[1], ts_accel[2] }, { ts_gyro[0], ts_gyro[1], ts_gyro[2] },
+        ts_temperature, ts_fsync, ts_mask, IXM42XXX_FIFO_MAX_PACKETS, 0, 0
+    };
+    uint32_t mismatches = 0, max_from_wm = 0, max_before_wm = 0, diff;
+    uint64_t irq_us;
+    unsigned burst;
+    int rc, i, with_irq, locked;
+
+    if (ts_open(name, TS_WM, NULL) != INV_ERROR_SUCCESS)
+        return INV_ERROR;
+    clock_calibration_init(&ts_driver, &clk_packet);
+    clock_calibration_init(&ts_driver, &clk_batch);
+
+    for (burst = 0; burst < TS_BURSTS; burst++) {
+        // 分辨率变化使跟踪器连同 FIFO 时间线一起复位，之后第一个包仍按上一个包的时间戳计算增量
+        if (burst == TS_PHASE_RESOL)
+            inv_ixm42xxx_configure_timestamp_resolution(&ts_driver, IXM42XXX_TMST_CONFIG_RESOL_1us);
+        with_irq = burst >= TS_PHASE_LOCK && burst < TS_PHASE_RESOL;
+
+        rc = ts_read_burst(burst, with_irq, &irq_us, &batch);
+        if (rc < 0) {
+            printf("%-14s FIFO drain failed (%d) at burst %u\n", name, rc, burst);
+            return rc;
+        }
+
+        locked = clock_calibration_is_locked(&clk_packet, NULL);
+        for (i = 0; i < batch.count; i++)
+            inv_helper_extend_timestamp_from_fifo(&ts_driver, &clk_packet, batch.timestamp_fsync[i], irq_us,
+                                                  batch.sensor_mask[i], &ts_packet[i]);
+        inv_helper_extend_timestamps_from_fifo_batch(&ts_driver, &clk_batch, &batch, irq_us, ts_batch);
+
+        for (i = 0; i < batch.count; i++) {
+            diff = (uint32_t)(ts_packet[i] > ts_batch[i] ? ts_packet[i] - ts_batch[i] : ts_batch[i] - ts_packet[i]);
+            if (!with_irq) {
+                // 没有中断修正时两条路径的算术完全相同
+                if (diff)
+                    mismatches++;
+            } else if (i >= TS_WM - 1) {
+                if (diff > max_from_wm)
+                    max_from_wm = diff;
+            } else if (locked && diff > max_before_wm) {
+                max_before_wm = diff;
+            }
+        }
+    }
+
+    printf("%-14s %u bursts, %u mismatches without interrupt, max diff %u us from the watermark packet, %u us before\n",
+           name, burst, mismatches, max_from_wm, max_before_wm);
+
+    if (mismatches || max_from_wm > 1 || max_before_wm > TS_MAX_CORRECTION_US)
+        return INV_ERROR;
+    return INV_ERROR_SUCCESS;
+}
+
+/* 一条路径在一个 burst 上相对真实产生时刻的误差 */
+static void trk_account(const inv_ixm42xxx_fifo_batch_t *batch, const uint64_t *timestamps,
+                        uint64_t *sum_us, uint32_t *max_us, uint32_t *samples)
+{
+    uint64_t true_ns, ts_ns;
+    uint32_t err_us;
+    int i;
+
+    for (i = 0; i < batch->count; i++) {
+        true_ns = trk_true_ns[iim42652_sim_ramp_index((int16_t)batch->accel[0][i])];
+        ts_ns = timestamps[i] * 1000;
+        err_us = (uint32_t)((ts_ns > true_ns ? ts_ns - true_ns : true_ns - ts_ns) / 1000);
+        *sum_us += err_us;
+        if (err_us > *max_us)
+            *max_us = err_us;
+    }
+    *samples += (uint32_t)batch->count;
+}
+
+int sim_check_drift_tracker(void)
+{
+    const char *name = "drift-track";
+    inv_ixm42xxx_fifo_batch_t batch = {
+        { ts_accel[0], ts_accel[1], ts_accel[2] }, { ts_gyro[0], ts_gyro[1], ts_gyro[2] },
+        ts_temperature, ts_fsync, ts_mask, IXM42XXX_FIFO_MAX_PACKETS, 0, 0
+    };
+    uint64_t sum_packet = 0, sum_batch = 0;
+    uint32_t max_packet = 0, max_batch = 0, samples_packet = 0, samples_batch = 0;
+    uint64_t irq_us, mean_packet, mean_batch;
+    uint32_t bus_before, decode_bus = 0;
+    unsigned burst;
+    int rc, i, locked;
+
+    if (ts_open(name, TRK_WM, trk_generate) != INV_ERROR_SUCCESS)
+        return INV_ERROR;
+    clock_calibration_init(&ts_driver, &clk_packet);
+    clock_calibration_init(&ts_driver, &clk_batch);
+    // 按采集模块的解码线程使用：不读寄存器，批量路径的水位线由读取方给出
+    inv_ixm42xxx_set_fifo_decode_detached(&ts_driver, 1);
+    clk_batch.drain_wm = TRK_WM;
+    trk_rand = 1;
+
+    for (burst = 0; burst < TRK_BURSTS; burst++) {
+        if (burst == TRK_STEP_BURST)
+            iim42652_sim_set_drift_ppm(&ts_sim, TS_DRIFT_PPM + TRK_STEP_PPM);
+
+        irq_us = ts_wait_int1(2 * TRK_WM * TS_PERIOD_US);
+        if (irq_us == 0) {
+            printf("%-14s no interrupt at burst %u\n", name, burst);
+            return INV_ERROR_TIMEOUT;
+        }
+        // 内核在中断延迟之后才取时间戳，读取线程再晚一些才开始读
+        irq_us += trk_random(TRK_IRQ_LATENCY_US);
+        inv_ixm42xxx_sleep_us((uint32_t)(irq_us - inv_ixm42xxx_get_time_us()) + trk_random(TRK_READ_DELAY_US));
+        rc = inv_ixm42xxx_get_data_from_fifo_batch(&ts_driver, &batch);
+        if (rc < 0) {
+            printf("%-14s FIFO drain failed (%d) at burst %u\n", name, rc, burst);
+            return rc;
+        }
+
+        // 解码一侧不得访问寄存器，否则会与读取线程同时进入传输层；先作废影子，读寄存器就必然上总线
+        inv_ixm42xxx_invalidate_reg_cache(&ts_driver);
+        bus_before = ts_driver.transport.stats.read_count + ts_driver.transport.stats.write_count;
+        for (i = 0; i < batch.count; i++)
+            inv_helper_extend_timestamp_from_fifo(&ts_driver, &clk_packet, batch.timestamp_fsync[i], irq_us,
+                                                  batch.sensor_mask[i], &ts_packet[i]);
+        inv_helper_extend_timestamps_from_fifo_batch(&ts_driver, &clk_batch, &batch, irq_us, ts_batch);
+        decode_bus += ts_driver.transport.stats.read_count + ts_driver.transport.stats.write_count - bus_before;
+
+        if (burst >= TRK_SETTLE_BURSTS) {
+            trk_account(&batch, ts_packet, &sum_packet, &max_packet, &samples_packet);
+            trk_account(&batch, ts_batch, &sum_batch, &max_batch, &samples_batch);
+        }
+    }
+
+    inv_ixm42xxx_set_fifo_decode_detached(&ts_driver, 0);
+    locked = clock_calibration_is_locked(&clk_packet, NULL) && clock_calibration_is_locked(&clk_batch, NULL);
+    mean_packet = samples_packet ? sum_packet / samples_packet : 0;
+    mean_batch = samples_batch ? sum_batch / samples_batch : 0;
+    printf("%-14s %u bursts, %s, error vs production: packet path %llu us mean / %u us max, batch path %llu us mean / %u us max, "
+           "%u bus accesses while decoding\n",
+           name, burst, locked ? "locked" : "NOT locked", (unsigned long long)mean_packet, max_packet,
+           (unsigned long long)mean_batch, max_batch, decode_bus);
+
+    if (!locked || decode_bus || mean_packet > TRK_MAX_MEAN_US || mean_batch > TRK_MAX_MEAN_US
+        || max_packet > TRK_MAX_ERROR_US || max_batch > TRK_MAX_ERROR_US)
+        return INV_ERROR;
+    return INV_ERROR_SUCCESS;
+}
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Ixm42xxxDriver_HL.h"
+#include "Ixm42xxxDriver_HL_apex.h"
+#include "Ixm42xxxConfig.h"
+#include "Ixm42xxxTransport.h"
+#include "Ixm42xxxDefs.h"
+#include "iim42652_sim.h"
+#include "sim_checks.h"
+
+#define TR_WOM_THRESHOLD    98      // 与复位值不同的 WOM 阈值
+#define TR_RECONFIG_ROUNDS  20
+#define TR_VOLATILE_READS   10
+
+static struct inv_ixm42xxx tr_driver;
+static struct iim42652_sim tr_sim;
+
+// 每个寄存器被物理读取的次数，按设备当时所在的 bank 记
+static uint32_t tr_reads[IIM42652_SIM_BANK_COUNT][IIM42652_SIM_BANK_SIZE];
+
+/* 一段操作前后传输层计数的差 */
+struct tr_delta {
+    uint32_t reads;
+    uint32_t writes;        // 不含 REG_BANK_SEL
+    uint32_t switches;
+};
+
+static void tr_ignore_event(inv_ixm42xxx_sensor_event_t *event)
+{
+    (void)event;
+}
+
+/* serif 读：记下读到的寄存器再交给模型 */
+static int tr_read_reg(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len)
+{
+    uint8_t bank = tr_sim.regs[0][MPUREG_REG_BANK_SEL];
+    uint32_t i;
+
+    if (bank < IIM42652_SIM_BANK_COUNT) {
+        for (i = 0; i < len && reg + i < IIM42652_SIM_BANK_SIZE; i++)
+            tr_reads[bank][reg + i]++;
+    }
+    return iim42652_sim_read_reg(serif, reg, buf, len);
+}
+
+/* 只初始化驱动，传感器保持关闭 */
+static int tr_open(const char *name)
+{
+    struct inv_ixm42xxx_serif serif;
+    int rc;
+
+    iim42652_sim_init(&tr_sim, NULL);
+    iim42652_sim_bind_serif(&tr_sim, &serif, IXM42XXX_UI_SPI4);
+    serif.read_reg = tr_read_reg;
+    memset(tr_reads, 0, sizeof(tr_reads));
+
+    rc = inv_ixm42xxx_init(&tr_driver, &serif, tr_ignore_event);
+    if (rc != INV_ERROR_SUCCESS)
+        printf("%-14s init failed (%d)\n", name, rc);
+    return rc;
+}
+
+/* 结束一段操作：读一次 INT_STATUS（不在影子里）让设备切回 bank 0，再算计数差，这次读不计入 */
+static int tr_measure(const struct transport_stats *before, struct tr_delta *d)
+{
+    const struct transport_stats *now = &tr_driver.transport.stats;
+    uint8_t int_status;
+    int rc;
+
+    rc = inv_ixm42xxx_read_reg(&tr_driver, MPUREG_INT_STATUS, 1, &int_status);
+    d->reads = now->read_count - before->read_count - 1;
+    d->switches = now->bank_switch_count - before->bank_switch_count;
+    d->writes = now->write_count - before->write_count - d->switches;
+    return rc;
+}
+
+static uint8_t tr_reg(uint8_t bank, uint8_t reg)
+{
+    return tr_sim.regs[bank][reg];
+}
+
+static int tr_wom_in_device(int enabled)
+{
+    int wom = (tr_reg(0, MPUREG_SMD_CONFIG) & BIT_SMD_CONFIG_SMD_MODE_MASK) == IXM42XXX_SMD_CONFIG_SMD_MODE_WOM;
+    int fifo_ths = (tr_reg(0, MPUREG_INT_SOURCE0) & BIT_INT_SOURCE0_FIFO_THS_INT1_EN) != 0;
+    int drdy_ibi = (tr_reg(4, MPUREG_INT_SOURCE8_B4) & BIT_INT_SOURCE8_UI_DRDY_IBI_EN) != 0;
+
+    return enabled ? (wom && !fifo_ths && !drdy_ibi) : (!wom && fifo_ths && drdy_ibi);
+}
+
+int sim_check_bank_batch(void)
+{
+    const char *name = "bank-batch";
+    struct transport_stats before;
+    struct tr_delta wom_on, wom_off, apex;
+    inv_ixm42xxx_apex_parameters_t apex_in, apex_out;
+    int rc, errors = 0;
+
+    if (tr_open(name) != INV_ERROR_SUCCESS)
+        return INV_ERROR;
+
+    // 第一轮读入中断源寄存器，之后的配置都由影子提供读值
+    rc = inv_ixm42xxx_enable_wom(&tr_driver);
+    rc |= inv_ixm42xxx_disable_wom(&tr_driver);
+
+    // 阈值在 bank 4，SMD_CONFIG/INT_SOURCE0 在 bank 0，IBI 源又在 bank 4：
+    // 逐个写入要切 4 次 bank，合成一批后只切到 bank 4 再切回
+    before = tr_driver.transport.stats;
+    rc |= inv_ixm42xxx_begin_bank_batch(&tr_driver);
+    rc |= inv_ixm42xxx_configure_smd_wom(&tr_driver, TR_WOM_THRESHOLD, TR_WOM_THRESHOLD, TR_WOM_THRESHOLD,
+                                         IXM42XXX_SMD_CONFIG_WOM_INT_MODE_ORED, IXM42XXX_SMD_CONFIG_WOM_MODE_CMP_PREV);
+    rc |= inv_ixm42xxx_enable_wom(&tr_driver);
+    rc |= inv_ixm42xxx_end_bank_batch(&tr_driver);
+    rc |= tr_measure(&before, &wom_on);
+    if (!tr_wom_in_device(1) || tr_reg(4, MPUREG_ACCEL_WOM_X_THR_B4) != TR_WOM_THRESHOLD ||
+        tr_reg(4, MPUREG_ACCEL_WOM_Z_THR_B4) != TR_WOM_THRESHOLD)
+        errors++;
+    if (wom_on.reads || wom_on.switches > 2)
+        errors++;
+
+    before = tr_driver.transport.stats;
+    rc |= inv_ixm42xxx_disable_wom(&tr_driver);
+    rc |= tr_measure(&before, &wom_off);
+    if (!tr_wom_in_device(0) || wom_off.reads || wom_off.switches > 2)
+        errors++;
+
+    // APEX_CONFIG9/10 不再分两次写：APEX_CONFIG0、CONFIG1-6、CONFIG9-10 三次写入
+    inv_ixm42xxx_init_apex_parameters_struct(&tr_driver, &apex_in);
+    apex_in.ff_debounce_duration = IXM42XXX_APEX_CONFIG10_FF_DEBOUNCE_DURATION_1000_MS;
+    apex_in.highg_peak_th = IXM42XXX_APEX_CONFIG6_HIGHG_PEAK_TH_1500MG;
+    before = tr_driver.transport.stats;
+    rc |= inv_ixm42xxx_configure_apex_parameters(&tr_driver, &apex_in);
+    rc |= tr_measure(&before, &apex);
+    if (apex.writes != 3 || apex.switches > 2)
+        errors++;
+
+    // 丢掉影子后从设备读回
+    inv_ixm42xxx_invalidate_reg_cache(&tr_driver);
+    rc |= inv_ixm42xxx_get_apex_parameters(&tr_driver, &apex_out);
+    if (apex_out.ff_debounce_duration != apex_in.ff_debounce_duration ||
+        apex_out.ff_max_duration_cm != apex_in.ff_max_duration_cm ||
+        apex_out.highg_peak_th != apex_in.highg_peak_th ||
+        apex_out.sensitivity_mode != apex_in.sensitivity_mode ||
+        apex_out.power_save_time != apex_in.power_save_time)
+        errors++;
+
+    printf("%-14s WOM on %u reads / %u bank switches, WOM off %u / %u, APEX parameters %u writes / %u bank switches, %d errors\n",
+           name, wom_on.reads, wom_on.switches, wom_off.reads, wom_off.switches, apex.writes, apex.switches, errors);
+
+    if (rc != INV_ERROR_SUCCESS || errors)
+        return INV_ERROR;
+    return INV_ERROR_SUCCESS;
+}
+
+/* 交替两组传感器、FIFO 与中断配置 */
+static int tr_reconfigure(unsigned round)
+{
+    inv_ixm42xxx_interrupt_parameter_t int1;
+    inv_ixm42xxx_config_t cfg;
+    int odd = round & 1;
+    int rc;
+
+    rc = inv_ixm42xxx_config_begin(&tr_driver, &cfg);
+    inv_ixm42xxx_config_set_accel_frequency(&cfg, odd ? IXM42XXX_ACCEL_CONFIG0_ODR_2_KHZ : IXM42XXX_ACCEL_CONFIG0_ODR_1_KHZ);
+    inv_ixm42xxx_config_set_gyro_frequency(&cfg, odd ? IXM42XXX_GYRO_CONFIG0_ODR_2_KHZ : IXM42XXX_GYRO_CONFIG0_ODR_1_KHZ);
+    inv_ixm42xxx_config_set_accel_fsr(&cfg, odd ? IXM42XXX_ACCEL_CONFIG0_FS_SEL_8g : IXM42XXX_ACCEL_CONFIG0_FS_SEL_16g);
+    inv_ixm42xxx_config_set_accel_mode(&cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN);
+    inv_ixm42xxx_config_set_gyro_mode(&cfg, IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN);
+    if (rc == INV_ERROR_SUCCESS)
+        rc |= inv_ixm42xxx_config_commit(&tr_driver, &cfg);
+    rc |= inv_ixm42xxx_configure_fifo_wm(&tr_driver, odd ? 20 : 10);
+    rc |= inv_ixm42xxx_get_config_int1(&tr_driver, &int1);
+    int1.INV_IXM42XXX_UI_DRDY = odd ? INV_IXM42XXX_ENABLE : INV_IXM42XXX_DISABLE;
+    rc |= inv_ixm42xxx_set_config_int1(&tr_driver, &int1);
+    return rc;
+}
+
+static unsigned tr_count_bits(const uint8_t *map, unsigned size)
+{
+    unsigned i, n = 0;
+
+    for (i = 0; i < size * 8; i++)
+        n += (map[i / 8] >> (i % 8)) & 1;
+    return n;
+}
+
+/* tr_reconfigure() 读改写的配置寄存器，影子填充后不应再读 */
+static const uint8_t tr_config_regs[][2] = {
+    { 0, MPUREG_PWR_MGMT_0 }, { 0, MPUREG_GYRO_CONFIG0 }, { 0, MPUREG_ACCEL_CONFIG0 },
+    { 0, MPUREG_GYRO_CONFIG1 }, { 0, MPUREG_GYRO_ACCEL_CONFIG0 }, { 0, MPUREG_ACCEL_CONFIG1 },
+    { 0, MPUREG_FIFO_CONFIG2 }, { 0, MPUREG_FIFO_CONFIG3 }, { 0, MPUREG_INT_SOURCE0 },
+    { 0, MPUREG_INT_SOURCE1 }, { 4, MPUREG_INT_SOURCE6_B4 },
+};
+
+int sim_check_reg_shadow(void)
+{
+    const char *name = "reg-shadow";
+    const struct transport_stats *stats = &tr_driver.transport.stats;
+    const struct register_cache *cache = &tr_driver.transport.register_cache;
+    struct transport_stats before;
+    uint32_t config_reads = 0, bus_reads, volatile_reads, wb_writes, flush_writes;
+    uint8_t data[2];
+    unsigned i, round, dirty;
+    int rc, errors = 0;
+
+    if (tr_open(name) != INV_ERROR_SUCCESS)
+        return INV_ERROR;
+
+    // 反复切换配置：第一轮之后读改写全部由影子提供读值
+    rc = tr_reconfigure(0);
+    memset(tr_reads, 0, sizeof(tr_reads));
+    before = *stats;
+    for (round = 1; round <= TR_RECONFIG_ROUNDS; round++)
+        rc |= tr_reconfigure(round);
+    bus_reads = stats->read_count - before.read_count;
+    for (i = 0; i < sizeof(tr_config_regs) / sizeof(tr_config_regs[0]); i++)
+        config_reads += tr_reads[tr_config_regs[i][0]][tr_config_regs[i][1]];
+    // 最后一轮是偶数轮：1 kHz、水位线 10
+    if (config_reads || (tr_reg(0, MPUREG_ACCEL_CONFIG0) & BIT_ACCEL_CONFIG0_ODR_MASK) != IXM42XXX_ACCEL_CONFIG0_ODR_1_KHZ ||
+        tr_reg(0, MPUREG_FIFO_CONFIG2) != 10)
+        errors++;
+
+    // 易变寄存器每次都读设备
+    memset(tr_reads, 0, sizeof(tr_reads));
+    before = *stats;
+    for (i = 0; i < TR_VOLATILE_READS; i++) {
+        rc |= inv_ixm42xxx_read_reg(&tr_driver, MPUREG_INT_STATUS, 1, data);
+        rc |= inv_ixm42xxx_read_reg(&tr_driver, MPUREG_FIFO_COUNTH, 2, data);
+    }
+    volatile_reads = stats->read_count - before.read_count;
+    if (volatile_reads != 2 * TR_VOLATILE_READS || tr_reads[0][MPUREG_INT_STATUS] != TR_VOLATILE_READS ||
+        tr_reads[0][MPUREG_FIFO_COUNTH] != TR_VOLATILE_READS || tr_reads[0][MPUREG_FIFO_COUNTL] != TR_VOLATILE_READS)
+        errors++;
+
+    // 回写模式：INT_SOURCE3、INT_SOURCE4 分两次写只置脏位，读回来自影子，刷新时合成一次写
+    rc |= inv_ixm42xxx_set_reg_cache_mode(&tr_driver, IXM42XXX_REG_CACHE_WRITE_BACK);
+    before = *stats;
+    data[0] = BIT_INT_SOURCE3_UI_DRDY_INT2_EN;
+    rc |= inv_ixm42xxx_write_reg(&tr_driver, MPUREG_INT_SOURCE3, 1, &data[0]);
+    data[1] = BIT_INT_SOURCE4_WOM_X_INT2_EN;
+    rc |= inv_ixm42xxx_write_reg(&tr_driver, MPUREG_INT_SOURCE4, 1, &data[1]);
+    dirty = tr_count_bits(cache->dirty, sizeof(cache->dirty));
+    data[0] = data[1] = 0;
+    rc |= inv_ixm42xxx_read_reg(&tr_driver, MPUREG_INT_SOURCE3, 2, data);
+    wb_writes = stats->write_count - before.write_count;
+    if (dirty != 2 || wb_writes || stats->read_count != before.read_count ||
+        data[0] != BIT_INT_SOURCE3_UI_DRDY_INT2_EN || data[1] != BIT_INT_SOURCE4_WOM_X_INT2_EN ||
+        tr_reg(0, MPUREG_INT_SOURCE3) == data[0])
+        errors++;
+    before = *stats;
+    rc |= inv_ixm42xxx_set_reg_cache_mode(&tr_driver, IXM42XXX_REG_CACHE_WRITE_THROUGH);
+    flush_writes = stats->write_count - before.write_count;
+    if (flush_writes != 1 || tr_count_bits(cache->dirty, sizeof(cache->dirty)) ||
+        tr_reg(0, MPUREG_INT_SOURCE3) != data[0] || tr_reg(0, MPUREG_INT_SOURCE4) != data[1])
+        errors++;
+
+    // 写入未变的值不上总线
+    before = *stats;
+    rc |= inv_ixm42xxx_write_reg(&tr_driver, MPUREG_INT_SOURCE3, 2, data);
+    if (stats->write_count != before.write_count || stats->write_skipped != before.write_skipped + 1)
+        errors++;
+
+    // 软复位：影子立即作废并停用，之后的读取拿到设备的复位值而不是旧影子
+    data[0] = IXM42XXX_DEVICE_CONFIG_RESET_EN;
+    rc |= inv_ixm42xxx_write_reg(&tr_driver, MPUREG_DEVICE_CONFIG, 1, &data[0]);
+    if (cache->enabled || tr_count_bits(cache->valid, sizeof(cache->valid)))
+        errors++;
+    before = *stats;
+    rc |= inv_ixm42xxx_read_reg(&tr_driver, MPUREG_INT_SOURCE3, 2, data);
+    if (stats->read_count != before.read_count + 1 ||
+        data[0] != tr_reg(0, MPUREG_INT_SOURCE3) || data[1] != tr_reg(0, MPUREG_INT_SOURCE4))
+        errors++;
+
+    // 完整的复位流程重新启用影子，读回的配置与设备一致
+    rc |= inv_ixm42xxx_device_reset(&tr_driver);
+    rc |= inv_ixm42xxx_read_reg(&tr_driver, MPUREG_INT_SOURCE0, 1, data);
+    if (!cache->enabled || data[0] != tr_reg(0, MPUREG_INT_SOURCE0))
+        errors++;
+
+    printf("%-14s %u reconfigurations with %u bus reads, %u of %u volatile reads on the bus, write-back %u dirty / %u flush write, %d errors\n",
+           name, TR_RECONFIG_ROUNDS, bus_reads, volatile_reads, 2 * TR_VOLATILE_READS, dirty, flush_writes, errors);
+
+    if (rc != INV_ERROR_SUCCESS || errors)
+        return INV_ERROR;
+    return INV_ERROR_SUCCESS;
+}
@@ -0,0 +1,392 @@
+#define _GNU_SOURCE
+#include "acquisition.h"
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include "InvError.h"
+
+// 驱动回调没有上下文参数，用线程局部变量找到当前线程所属的采集实例
+static __thread struct acq *acq_current;
+
+static void acq_handle_event(inv_ixm42xxx_sensor_event_t *event)
+{
+    struct acq *acq = acq_current;
+    struct acq_sample sample;
+
+    sample.irq_timestamp_us = acq->irq_timestamp_us;
+    inv_helper_extend_timestamp_from_fifo(acq->cfg.driver, &acq->clk_cal, event->timestamp_fsync,
+                                          acq->irq_timestamp_us, event->sensor_mask, &sample.timestamp_us);
+    sample.event = *event;
+    // 环满时丢弃并计数，绝不阻塞 FIFO 读取
+    spsc_ring_push(&acq->ring, &sample);
+}
+
+// 解码线程还给驱动的缓冲区在读线程里重新登记（驱动的空闲链表不加锁）
+static void acq_pipe_reclaim(struct acq *acq)
+{
+    struct acq_pipe_item item;
+
+    while (spsc_ring_pop(&acq->pipe_empty, &item)) {
+        // 同一轮次里排在出错 burst 后面被丢弃的 burst 不再复位
+        if (item.status < 0 && item.epoch == acq->pipe_epoch) {
+            // 解码线程不访问总线，由读线程复位 FIFO 回到包边界，之后读到的 burst 进入新轮次
+            acq->pipe_stats.decode_errors++;
+            inv_ixm42xxx_reset_fifo(acq->cfg.driver);
+            acq->pipe_epoch++;
+        }
+        inv_ixm42xxx_add_fifo_buffer(acq->cfg.driver, item.buffer);
+    }
+}
+
+static void acq_pipe_read(struct acq *acq, uint64_t irq_timestamp_us)
+{
+    struct acq_pipe_item item;
+    uint64_t start_us, end_us;
+    uint32_t read_us;
+    int rc;
+
+    acq_pipe_reclaim(acq);
+    if (!acq->cfg.driver->fifo_free_buffers) {
+        // 所有缓冲区都在解码：等一个回来，FIFO 在设备里继续积累
+        acq->pipe_stats.stalls++;
+        while (!acq->cfg.driver->fifo_free_buffers) {
+            sem_wait(&acq->pipe_empty_sem);
+            acq_pipe_reclaim(acq);
+        }
+    }
+
+    // 中断由读取前的水位线触发，控制器随后可能调整水位线
+    item.fifo_wm = acq->cfg.driver->fifo_wm;
+    start_us = inv_ixm42xxx_get_time_us();
+    rc = inv_ixm42xxx_get_fifo_buffer(acq->cfg.driver, &item.buffer);
+    end_us = inv_ixm42xxx_get_time_us();
+    if (rc < 0) {
+        acq->stats.errors++;
+        return;
+    }
+
+    read_us = (uint32_t)(end_us - start_us);
+    acq->pipe_stats.read_us_total += read_us;
+    if (read_us > acq->pipe_stats.read_us_max)
+        acq->pipe_stats.read_us_max = read_us;
+    acq->stats.drains++;
+    acq->stats.packets += (uint32_t)rc;
+    inv_ixm42xxx_fifo_wm_ctrl_report_drain(acq->cfg.driver, &acq->wm_ctrl, read_us, (uint16_t)rc);
+
+    if (rc == 0)
+        return;
+
+    // 缓冲区总数等于环容量，push 不会失败
+    item.irq_timestamp_us = irq_timestamp_us;
+    item.epoch = acq->pipe_epoch;
+    item.status = 0;
+    spsc_ring_push(&acq->pipe_full, &item);
+    acq->pipe_stats.bursts++;
+    sem_post(&acq->pipe_full_sem);
+}
+
+static int acq_pipe_decode(struct acq *acq, const struct acq_pipe_item *item)
+{
+    int32_t accel[3][IXM42XXX_FIFO_MAX_PACKETS], gyro[3][IXM42XXX_FIFO_MAX_PACKETS];
+    int16_t temperature[IXM42XXX_FIFO_MAX_PACKETS];
+    uint16_t timestamp_fsync[IXM42XXX_FIFO_MAX_PACKETS], sensor_mask[IXM42XXX_FIFO_MAX_PACKETS];
+    inv_ixm42xxx_fifo_batch_t batch = {
+        { accel[0], accel[1], accel[2] }, { gyro[0], gyro[1], gyro[2] },
+        temperature, timestamp_fsync, sensor_mask, IXM42XXX_FIFO_MAX_PACKETS, 0, 0
+    };
+    uint64_t timestamps[IXM42XXX_FIFO_MAX_PACKETS];
+    struct acq_sample sample;
+    int rc, i, k;
+
+    rc = inv_ixm42xxx_decode_fifo_batch(acq->cfg.driver, item->buffer->fifo, item->buffer->packet_count, &batch);
+
+    // 解码线程不读寄存器：时间戳配置沿用 acq_start() 时读到的，水位线取读取时的
+    acq->clk_cal.drain_wm = item->fifo_wm;
+    inv_helper_extend_timestamps_from_fifo_batch(acq->cfg.driver, &acq->clk_cal, &batch,
+                                                 item->irq_timestamp_us, timestamps);
+
+    // 出错前已解码的包照常交付，与 inv_ixm42xxx_get_data_from_fifo() 一致
+    sample.irq_timestamp_us = item->irq_timestamp_us;
+    for (i = 0; i < batch.count; i++) {
+        inv_ixm42xxx_sensor_event_t *event = &sample.event;
+
+        sample.timestamp_us = timestamps[i];
+        event->sensor_mask = sensor_mask[i];
+        event->timestamp_fsync = timestamp_fsync[i];
+        event->temperature = temperature[i];
+        for (k = 0; k < 3; k++) {
+            if (batch.high_res) {
+                event->accel_high_res[k] = (int8_t)(accel[k][i] & 0xF);
+                event->gyro_high_res[k] = (int8_t)(gyro[k][i] & 0xF);
+                event->accel[k] = (int16_t)((accel[k][i] - event->accel_high_res[k]) / 16);
+                event->gyro[k] = (int16_t)((gyro[k][i] - event->gyro_high_res[k]) / 16);
+            } else {
+                event->accel_high_res[k] = 0;
+                event->gyro_high_res[k] = 0;
+                event->accel[k] = (int16_t)accel[k][i];
+                event->gyro[k] = (int16_t)gyro[k][i];
+            }
+        }
+        spsc_ring_push(&acq->ring, &sample);
+    }
+
+    // FIFO 会被复位，时间线从下一个 burst 重新开始
+    if (rc < 0)
+        clock_calibration_restart(acq->cfg.driver, &acq->clk_cal);
+
+    return (rc < 0) ? rc : 0;
+}
+
+static void *acq_decode_thread(void *arg)
+{
+    struct acq *acq = (struct acq *)arg;
+    struct acq_pipe_item item;
+    uint64_t start_us;
+    uint32_t decode_us;
+    uint32_t skip_epoch = 0;
+
+    // 读线程退出前会 post 一次，把剩下的 burst 解码完再退出
+    for (;;) {
+        if (!spsc_ring_pop(&acq->pipe_full, &item)) {
+            if (!__atomic_load_n(&acq->running, __ATOMIC_ACQUIRE))
+                break;
+            sem_wait(&acq->pipe_full_sem);
+            continue;
+        }
+
+        if (item.epoch == skip_epoch) {
+            // 出错 burst 之后、FIFO 复位之前读到的数据同样不可信，直接还给读线程
+            item.status = INV_ERROR;
+            acq->pipe_stats.discarded_bursts++;
+        } else {
+            start_us = inv_ixm42xxx_get_time_us();
+            item.status = acq_pipe_decode(acq, &item);
+            decode_us = (uint32_t)(inv_ixm42xxx_get_time_us() - start_us);
+            acq->pipe_stats.decode_us_total += decode_us;
+            if (decode_us > acq->pipe_stats.decode_us_max)
+                acq->pipe_stats.decode_us_max = decode_us;
+            if (item.status < 0)
+                skip_epoch = item.epoch;
+        }
+
+        spsc_ring_push(&acq->pipe_empty, &item);
+        sem_post(&acq->pipe_empty_sem);
+    }
+
+    return NULL;
+}
+
+static void acq_drain(struct acq *acq, uint64_t irq_timestamp_us)
+{
+    uint64_t start_us, end_us;
+    int rc;
+
+    if (acq->cfg.pipelined) {
+        acq_pipe_read(acq, irq_timestamp_us);
+        return;
+    }
+
+    acq->irq_timestamp_us = irq_timestamp_us;
+    start_us = inv_ixm42xxx_get_time_us();
+    rc = inv_ixm42xxx_get_data_from_fifo(acq->cfg.driver);
+    end_us = inv_ixm42xxx_get_time_us();
+    if (rc < 0) {
+        acq->stats.errors++;
+        clock_calibration_restart(acq->cfg.driver, &acq->clk_cal);
+        return;
+    }
+
+    acq->stats.drains++;
+    acq->stats.packets += (uint32_t)rc;
+    inv_ixm42xxx_fifo_wm_ctrl_report_drain(acq->cfg.driver, &acq->wm_ctrl, (uint32_t)(end_us - start_us), (uint16_t)rc);
+}
+
+static void *acq_thread(void *arg)
+{
+    struct acq *acq = (struct acq *)arg;
+    uint64_t last_drain_us;
+
+    acq_current = acq;
+
+    // 内核只上报边沿：启动前已超过水位线的数据不会再触发 INT1，先读空一次
+    acq_drain(acq, 0);
+    last_drain_us = inv_ixm42xxx_get_time_us();
+
+    while (__atomic_load_n(&acq->running, __ATOMIC_ACQUIRE)) {
+        uint64_t irq_timestamp_us = 0;
+        int rc = platform_gpio_irq_wait(acq->cfg.int1, ACQ_STOP_POLL_MS, &irq_timestamp_us);
+
+        if (rc < 0) {
+            acq->stats.errors++;
+            inv_ixm42xxx_sleep_us(ACQ_STOP_POLL_MS * 1000);
+            continue;
+        }
+
+        if (rc == 0) {
+            // 超时片只用于检查停止标志，累计超过 irq_timeout_ms 才认为边沿丢失
+            if (inv_ixm42xxx_get_time_us() - last_drain_us < (uint64_t)acq->cfg.irq_timeout_ms * 1000)
+                continue;
+            acq->stats.timeout_drains++;
+        }
+
+        acq_drain(acq, irq_timestamp_us);
+        last_drain_us = inv_ixm42xxx_get_time_us();
+    }
+
+    if (acq->cfg.pipelined)
+        sem_post(&acq->pipe_full_sem);
+
+    return NULL;
+}
+
+int acq_create_thread(pthread_t *thread, void *(*fn)(void *), void *arg, int priority, int cpu)
+{
+    pthread_attr_t attr;
+    struct sched_param param;
+    cpu_set_t cpus;
+    int rc;
+
+    pthread_attr_init(&attr);
+
+    if (priority > 0) {
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+
+    if (cpu >= 0) {
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    }
+
+    rc = pthread_create(thread, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+
+    return rc;
+}
+
+static int acq_pipe_init(struct acq *acq)
+{
+    struct inv_ixm42xxx *driver = acq->cfg.driver;
+    int rc, i;
+
+    memset(&acq->pipe_stats, 0, sizeof(acq->pipe_stats));
+    // 从 1 开始，解码线程的 skip_epoch 初值 0 不会命中
+    acq->pipe_epoch = 1;
+    rc = spsc_ring_init(&acq->pipe_full, acq->pipe_full_slots, sizeof(struct acq_pipe_item), ACQ_PIPE_DEPTH);
+    rc |= spsc_ring_init(&acq->pipe_empty, acq->pipe_empty_slots, sizeof(struct acq_pipe_item), ACQ_PIPE_DEPTH);
+    if (rc != INV_ERROR_SUCCESS) return rc;
+
+    if (sem_init(&acq->pipe_full_sem, 0, 0) != 0) return INV_ERROR_OS;
+    if (sem_init(&acq->pipe_empty_sem, 0, 0) != 0) {
+        sem_destroy(&acq->pipe_full_sem);
+        return INV_ERROR_OS;
+    }
+
+    // 缓冲区池归采集模块独占，解码不访问总线
+    driver->fifo_free_buffers = NULL;
+    for (i = 0; i < ACQ_PIPE_DEPTH; i++) {
+        acq->pipe_buffers[i].data = acq->pipe_mem[i];
+        acq->pipe_buffers[i].size = ACQ_PIPE_BUFFER_SIZE;
+        inv_ixm42xxx_add_fifo_buffer(driver, &acq->pipe_buffers[i]);
+    }
+    inv_ixm42xxx_set_fifo_decode_detached(driver, 1);
+
+    return INV_ERROR_SUCCESS;
+}
+
+static void acq_pipe_release(struct acq *acq)
+{
+    // 缓冲区属于 acq，停止后驱动回到内嵌的 FIFO 镜像
+    acq->cfg.driver->fifo_free_buffers = NULL;
+    inv_ixm42xxx_set_fifo_decode_detached(acq->cfg.driver, 0);
+    sem_destroy(&acq->pipe_full_sem);
+    sem_destroy(&acq->pipe_empty_sem);
+}
+
+int acq_start(struct acq *acq, const struct acq_config *cfg)
+{
+    int rc;
+
+    if (!acq || !cfg || !cfg->driver || !cfg->int1) return INV_ERROR_INVALID_PARAMETER;
+
+    memset(&acq->stats, 0, sizeof(acq->stats));
+    acq->cfg = *cfg;
+    acq->irq_timestamp_us = 0;
+    acq->realtime = 0;
+    // 在流水线模式分离解码之前读取时间戳配置
+    clock_calibration_init(cfg->driver, &acq->clk_cal);
+
+    rc = spsc_ring_init(&acq->ring, acq->slots, sizeof(struct acq_sample), ACQ_RING_SIZE);
+    if (rc != INV_ERROR_SUCCESS) return rc;
+
+    rc = inv_ixm42xxx_fifo_wm_ctrl_init(cfg->driver, &acq->wm_ctrl, cfg->max_latency_us);
+    if (rc != INV_ERROR_SUCCESS) return rc;
+
+    if (cfg->pipelined) {
+        rc = acq_pipe_init(acq);
+        if (rc != INV_ERROR_SUCCESS) return rc;
+    }
+
+    acq->saved_cb = cfg->driver->sensor_event_cb;
+    cfg->driver->sensor_event_cb = acq_handle_event;
+    __atomic_store_n(&acq->running, 1, __ATOMIC_RELEASE);
+
+    // 没有 CAP_SYS_NICE 时 SCHED_FIFO 会被拒绝（EPERM），退回普通调度继续运行
+    if (cfg->priority > 0) {
+        rc = acq_create_thread(&acq->thread, acq_thread, acq, cfg->priority, cfg->cpu);
+        if (rc == 0)
+            acq->realtime = 1;
+        else if (rc != EPERM && rc != EINVAL)
+            goto error;
+    }
+
+    if (!acq->realtime && acq_create_thread(&acq->thread, acq_thread, acq, 0, cfg->cpu) != 0)
+        goto error;
+
+    if (!cfg->pipelined) return INV_ERROR_SUCCESS;
+
+    // 解码线程低一级优先级、不绑核，尽量与读线程跑在不同的核上
+    rc = -1;
+    if (acq->realtime && cfg->priority > 1)
+        rc = acq_create_thread(&acq->decode_thread, acq_decode_thread, acq, cfg->priority - 1, -1);
+    if (rc != 0)
+        rc = acq_create_thread(&acq->decode_thread, acq_decode_thread, acq, 0, -1);
+    if (rc == 0) return INV_ERROR_SUCCESS;
+
+    __atomic_store_n(&acq->running, 0, __ATOMIC_RELEASE);
+    pthread_join(acq->thread, NULL);
+
+error:
+    __atomic_store_n(&acq->running, 0, __ATOMIC_RELEASE);
+    cfg->driver->sensor_event_cb = acq->saved_cb;
+    if (cfg->pipelined) acq_pipe_release(acq);
+    return INV_ERROR;
+}
+
+void acq_stop(struct acq *acq)
+{
+    if (!acq || !__atomic_load_n(&acq->running, __ATOMIC_ACQUIRE)) return;
+
+    __atomic_store_n(&acq->running, 0, __ATOMIC_RELEASE);
+    pthread_join(acq->thread, NULL);
+    if (acq->cfg.pipelined) {
+        pthread_join(acq->decode_thread, NULL);
+        acq_pipe_reclaim(acq);
+        acq_pipe_release(acq);
+    }
+    acq->cfg.driver->sensor_event_cb = acq->saved_cb;
+}
+
+int acq_read(struct acq *acq, struct acq_sample *sample)
+{
+    return spsc_ring_pop(&acq->ring, sample);
+}
+
+uint32_t acq_get_dropped(const struct acq *acq)
+{
+    return spsc_ring_dropped(&acq->ring);
+}
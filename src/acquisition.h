@@ -0,0 +1,175 @@
+#ifndef _ACQUISITION_H_
+#define _ACQUISITION_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "Ixm42xxxDriver_HL.h"
+#include "Ixm42xxxFifoWm.h"
+#include "helperClockCalib.h"
+#include "platform.h"
+#include "spsc_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Samples buffered between the acquisition thread and the consumer, power of two */
+#define ACQ_RING_SIZE           1024
+
+/** INT1 poll slice, bounds how long acq_stop() waits for the thread */
+#define ACQ_STOP_POLL_MS        100
+
+/** FIFO mirror buffers shared by the read and decode stages in pipelined mode, power of two */
+#define ACQ_PIPE_DEPTH          2
+
+/** Size of one mirror buffer, holds the largest burst the driver reads */
+#define ACQ_PIPE_BUFFER_SIZE    (IXM42XXX_FIFO_BURST_HEADER_SIZE + IXM42XXX_FIFO_MIRRORING_SIZE)
+
+/**
+ * @brief One decoded FIFO packet as delivered to the consumer
+ */
+struct acq_sample {
+    uint64_t irq_timestamp_us;          /**< kernel timestamp of the INT1 edge that triggered the drain, 0 for a timeout drain */
+    uint64_t timestamp_us;              /**< sample time on the INT1 clock, from the drift tracker (acq::clk_cal) */
+    inv_ixm42xxx_sensor_event_t event;
+};
+
+/**
+ * @brief Acquisition thread parameters
+ */
+struct acq_config {
+    struct inv_ixm42xxx *driver;        /**< initialized and configured driver, owned by the thread once started */
+    struct platform_gpio_irq *int1;     /**< open INT1 line */
+    int cpu;                            /**< core the thread is pinned to, -1 to keep the default affinity */
+    int priority;                       /**< SCHED_FIFO priority (1..99), 0 to run as SCHED_OTHER */
+    uint32_t max_latency_us;            /**< latency budget given to the FIFO watermark controller */
+    uint32_t irq_timeout_ms;            /**< drain anyway when no INT1 edge came for this long */
+    int pipelined;                      /**< 1 to decode burst N on a second thread while burst N+1 is read */
+};
+
+/**
+ * @brief Acquisition thread statistics, written by the thread only, read them after acq_stop()
+ */
+struct acq_stats {
+    uint32_t drains;
+    uint32_t timeout_drains;            /**< drains done without an INT1 edge */
+    uint32_t packets;
+    uint32_t errors;                    /**< failed INT1 waits or drains */
+};
+
+/**
+ * @brief Pipelined mode statistics: read stage on the acquisition thread, decode stage on the decode thread
+ *
+ * Each counter is written by one thread only, read them after acq_stop().
+ */
+struct acq_pipe_stats {
+    uint64_t read_us_total;             /**< bus time of the FIFO reads */
+    uint32_t read_us_max;
+    uint64_t decode_us_total;           /**< decode and hand-over to the sample ring */
+    uint32_t decode_us_max;
+    uint32_t bursts;                    /**< bursts passed to the decode stage */
+    uint32_t stalls;                    /**< reads delayed because every buffer was still being decoded */
+    uint32_t decode_errors;             /**< corrupted bursts, FIFO was reset by the read stage */
+    uint32_t discarded_bursts;          /**< bursts read after a corrupted one and before the FIFO reset, not decoded */
+};
+
+/**
+ * @brief Burst handed between the two pipeline stages
+ */
+struct acq_pipe_item {
+    inv_ixm42xxx_fifo_buffer_t *buffer;
+    uint64_t irq_timestamp_us;
+    uint16_t fifo_wm;                   /**< watermark the burst was read with, before the controller moves it */
+    uint32_t epoch;                     /**< acq::pipe_epoch when the burst was read */
+    int status;                         /**< decode result, set by the decode stage */
+};
+
+/**
+ * @brief Acquisition subsystem: one thread draining the FIFO on INT1, samples handed over through an SPSC ring
+ *
+ * Between acq_start() and acq_stop() the thread is the only user of the driver
+ * and of the INT1 line. sensor_event_cb of the driver is redirected to the ring,
+ * so a slow consumer only fills the ring (see spsc_ring_dropped()) and never
+ * delays the drain.
+ *
+ * In pipelined mode the acquisition thread only reads: each burst lands in one of
+ * ACQ_PIPE_DEPTH buffers registered with the driver and is passed to a decode thread,
+ * which fills the sample ring and gives the buffer back. Reading burst N+1 overlaps
+ * decoding burst N. When every buffer is still being decoded the read waits
+ * (acq_pipe_stats::stalls), so backpressure reaches the FIFO and not the samples.
+ * When a burst fails to decode, the bursts already read behind it are given back
+ * undecoded and the read stage resets the FIFO before reading on.
+ *
+ * Sample timestamps come from the clock calibration drift tracker, corrected by the
+ * INT1 timestamp of each drain. In pipelined mode the decode thread extends them
+ * without reading registers, so the configuration must not change between acq_start()
+ * and acq_stop().
+ */
+struct acq {
+    struct acq_config cfg;
+    pthread_t thread;
+    int running;                        /**< cleared by acq_stop(), accessed atomically */
+    int realtime;                       /**< 1 when the thread got SCHED_FIFO */
+    void (*saved_cb)(inv_ixm42xxx_sensor_event_t *event); /**< driver callback restored by acq_stop() */
+    uint64_t irq_timestamp_us;          /**< INT1 timestamp of the drain in progress */
+    clk_calib_t clk_cal;                /**< drift tracker, used by the thread that decodes */
+    inv_ixm42xxx_fifo_wm_ctrl_t wm_ctrl;
+    struct acq_stats stats;
+    struct spsc_ring ring;
+    struct acq_sample slots[ACQ_RING_SIZE];
+
+    /* Pipelined mode only */
+    pthread_t decode_thread;
+    struct acq_pipe_stats pipe_stats;
+    struct spsc_ring pipe_full;         /**< bursts read, waiting for decode */
+    struct spsc_ring pipe_empty;        /**< bursts decoded, buffers going back to the driver */
+    sem_t pipe_full_sem;
+    sem_t pipe_empty_sem;
+    uint32_t pipe_epoch;                /**< read stage only, incremented by each FIFO reset after a decode error */
+    struct acq_pipe_item pipe_full_slots[ACQ_PIPE_DEPTH];
+    struct acq_pipe_item pipe_empty_slots[ACQ_PIPE_DEPTH];
+    inv_ixm42xxx_fifo_buffer_t pipe_buffers[ACQ_PIPE_DEPTH];
+    uint8_t pipe_mem[ACQ_PIPE_DEPTH][ACQ_PIPE_BUFFER_SIZE] SPSC_RING_ALIGNED;
+};
+
+/**
+ * @brief Size the watermark and start the acquisition thread
+ * @return 0 on success, negative value on error
+ *
+ * When SCHED_FIFO or the affinity is refused (no CAP_SYS_NICE), the thread is
+ * started as SCHED_OTHER and acq::realtime stays 0. In pipelined mode the decode
+ * thread runs one priority level below and is not pinned, and the driver FIFO buffer
+ * pool is taken over until acq_stop().
+ */
+int acq_start(struct acq *acq, const struct acq_config *cfg);
+
+/**
+ * @brief Stop and join the thread, the driver is given back to the caller
+ */
+void acq_stop(struct acq *acq);
+
+/**
+ * @brief Create a thread with SCHED_FIFO priority and CPU affinity
+ * @param[in] priority   SCHED_FIFO priority (1..99), 0 for SCHED_OTHER
+ * @param[in] cpu        Core to pin the thread to, -1 to keep the default affinity
+ * @return 0 on success, pthread_create() error code otherwise (EPERM without CAP_SYS_NICE)
+ */
+int acq_create_thread(pthread_t *thread, void *(*fn)(void *), void *arg, int priority, int cpu);
+
+/**
+ * @brief Take the oldest sample (consumer thread only)
+ * @return 1 when a sample was read, 0 when none is pending
+ */
+int acq_read(struct acq *acq, struct acq_sample *sample);
+
+/**
+ * @brief Samples dropped because the consumer did not keep up
+ */
+uint32_t acq_get_dropped(const struct acq *acq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+#define _GNU_SOURCE
+#include "imu_mgr.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "InvError.h"
+
+// 驱动回调没有上下文参数，总线线程在每次读取前记下当前设备
+static __thread struct imu_mgr_device *imu_mgr_current;
+
+// 解码出的包先暂存，读取结束后才知道最后一个包对应的主机时间
+static void imu_mgr_handle_event(inv_ixm42xxx_sensor_event_t *event)
+{
+    struct imu_mgr_device *dev = imu_mgr_current;
+    uint16_t delta;
+
+    if (dev->drain_count >= IXM42XXX_FIFO_MAX_PACKETS) return;
+
+    // FSYNC 标记的包里是 FSYNC 延迟而不是时间戳，按上一包间隔推算
+    if (event->sensor_mask & (1 << INV_IXM42XXX_SENSOR_FSYNC_EVENT)) {
+        delta = dev->tmst_period;
+        dev->tmst_last = (uint16_t)(dev->tmst_last + delta);
+    } else if (!dev->tmst_started) {
+        delta = 0;
+        dev->tmst_last = event->timestamp_fsync;
+        dev->tmst_started = 1;
+    } else {
+        // 相邻包间隔远小于 16 位计数的回绕周期，差值取模即可展开
+        delta = (uint16_t)(event->timestamp_fsync - dev->tmst_last);
+        dev->tmst_last = event->timestamp_fsync;
+        if (delta) dev->tmst_period = delta;
+    }
+    dev->tmst_ticks += delta;
+
+    dev->drain_ticks[dev->drain_count] = dev->tmst_ticks;
+    dev->drain_events[dev->drain_count] = *event;
+    dev->drain_count++;
+}
+
+// ticks * q24 速率，拆开计算避免 64 位溢出
+static uint64_t imu_mgr_scale(uint64_t ticks, uint32_t rate_q24)
+{
+    return (ticks >> 24) * rate_q24 + (((ticks & 0xFFFFFF) * rate_q24) >> 24);
+}
+
+static uint64_t imu_mgr_map(const struct imu_mgr_device *dev, uint64_t ticks)
+{
+    if (ticks >= dev->map_ticks)
+        return dev->map_us + imu_mgr_scale(ticks - dev->map_ticks, dev->map_rate_us_q24);
+    return dev->map_us - imu_mgr_scale(dev->map_ticks - ticks, dev->map_rate_us_q24);
+}
+
+// 按当前映射估计 FSYNC 边沿时间，取整到共同的 FSYNC 网格上作为新的参考点
+static void imu_mgr_fsync_edge(struct imu_mgr *mgr, struct imu_mgr_device *dev, uint64_t ticks)
+{
+    int64_t period_us = mgr->cfg.fsync_period_us;
+    uint64_t estimate_us = imu_mgr_map(dev, ticks);
+    uint64_t base_us = 0, edge_us, rate_q24;
+    int64_t offset_us, k;
+
+    // 第一个看到 FSYNC 的设备确定网格原点，其他总线线程可能同时尝试
+    if (__atomic_compare_exchange_n(&mgr->fsync_base_us, &base_us, estimate_us, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        base_us = estimate_us;
+
+    offset_us = (int64_t)(estimate_us - base_us);
+    k = (offset_us >= 0 ? offset_us + period_us / 2 : offset_us - period_us / 2) / period_us;
+    edge_us = base_us + (uint64_t)(k * period_us);
+
+    if (dev->fsync_edges) {
+        if (ticks <= dev->map_ticks || edge_us <= dev->map_us)
+            return;
+        rate_q24 = ((edge_us - dev->map_us) << 24) / (ticks - dev->map_ticks);
+        // 速率偏离标称值过多说明边沿编号错了（漏判或多判一个周期），连续多次才重新建立参考
+        if ((uint64_t)llabs((int64_t)rate_q24 - (int64_t)dev->tmst_res_us_q24) * 1000000 >
+            (uint64_t)dev->tmst_res_us_q24 * IMU_MGR_FSYNC_MAX_PPM) {
+            if (++dev->fsync_rejected < IMU_MGR_FSYNC_MAX_REJECT)
+                return;
+            dev->fsync_edges = 0;
+            rate_q24 = dev->tmst_res_us_q24;
+        }
+        dev->map_rate_us_q24 = (uint32_t)rate_q24;
+    }
+
+    dev->fsync_rejected = 0;
+    dev->fsync_edges++;
+    dev->map_ticks = ticks;
+    dev->map_us = edge_us;
+}
+
+static void imu_mgr_publish(struct imu_mgr *mgr, struct imu_mgr_device *dev, uint64_t irq_timestamp_us, uint64_t end_us)
+{
+    struct imu_mgr_sample sample;
+    uint16_t i;
+
+    if (!dev->drain_count) return;
+
+    if (!dev->anchored) {
+        dev->map_ticks = dev->drain_ticks[dev->drain_count - 1];
+        dev->map_us = irq_timestamp_us ? irq_timestamp_us : end_us;
+        dev->map_rate_us_q24 = dev->tmst_res_us_q24;
+        dev->anchored = 1;
+    }
+
+    sample.device = (uint8_t)(dev - mgr->devices);
+    sample.irq_timestamp_us = irq_timestamp_us;
+    for (i = 0; i < dev->drain_count; i++) {
+        const inv_ixm42xxx_sensor_event_t *event = &dev->drain_events[i];
+
+        // 带 FSYNC 标记的包：时间戳字段是边沿到该包的延迟
+        if (mgr->cfg.fsync_period_us && (event->sensor_mask & (1 << INV_IXM42XXX_SENSOR_FSYNC_EVENT)))
+            imu_mgr_fsync_edge(mgr, dev, dev->drain_ticks[i] - event->timestamp_fsync);
+
+        sample.timestamp_us = imu_mgr_map(dev, dev->drain_ticks[i]);
+        // 参考点切换可能让时间回退几个微秒，保持单调以免打乱归并
+        if (sample.timestamp_us < dev->last_timestamp_us)
+            sample.timestamp_us = dev->last_timestamp_us;
+        dev->last_timestamp_us = sample.timestamp_us;
+        sample.synced = dev->fsync_edges >= 2;
+        sample.event = *event;
+        // 环满时丢弃并计数，绝不阻塞 FIFO 读取
+        spsc_ring_push(&dev->ring, &sample);
+    }
+    // 先入环再发布：消费者看到 published_us 时，不晚于它的样本都已可取
+    __atomic_store_n(&dev->published_us, sample.timestamp_us, __ATOMIC_RELEASE);
+    dev->drain_count = 0;
+}
+
+static void imu_mgr_drain(struct imu_mgr *mgr, struct imu_mgr_device *dev, uint64_t irq_timestamp_us)
+{
+    uint64_t start_us, end_us;
+    int rc;
+
+    imu_mgr_current = dev;
+    dev->drain_count = 0;
+    start_us = inv_ixm42xxx_get_time_us();
+    rc = inv_ixm42xxx_get_data_from_fifo(dev->cfg.driver);
+    end_us = inv_ixm42xxx_get_time_us();
+    dev->last_drain_us = end_us;
+
+    // 出错前已解码的包照常交付
+    imu_mgr_publish(mgr, dev, irq_timestamp_us, end_us);
+    if (rc < 0) {
+        dev->stats.errors++;
+        return;
+    }
+
+    dev->stats.drains++;
+    dev->stats.packets += (uint32_t)rc;
+    inv_ixm42xxx_fifo_wm_ctrl_report_drain(dev->cfg.driver, &dev->wm_ctrl, (uint32_t)(end_us - start_us), (uint16_t)rc);
+}
+
+static void *imu_mgr_bus_thread(void *arg)
+{
+    struct imu_mgr_bus *bus = (struct imu_mgr_bus *)arg;
+    struct imu_mgr *mgr = bus->mgr;
+    uint32_t i;
+
+    // 内核只上报边沿：启动前已超过水位线的数据不会再触发 INT1，先逐个读空
+    for (i = 0; i < bus->device_count; i++)
+        imu_mgr_drain(mgr, bus->devices[i], 0);
+
+    while (__atomic_load_n(&mgr->running, __ATOMIC_ACQUIRE)) {
+        uint64_t irq_timestamp_us = 0, now_us;
+        uint32_t index = 0;
+        int rc = platform_gpio_irq_wait_any(bus->int1, bus->device_count, ACQ_STOP_POLL_MS, &index, &irq_timestamp_us);
+
+        if (rc < 0) {
+            bus->wait_errors++;
+            inv_ixm42xxx_sleep_us(ACQ_STOP_POLL_MS * 1000);
+            continue;
+        }
+        if (rc > 0)
+            imu_mgr_drain(mgr, bus->devices[index], irq_timestamp_us);
+
+        // 超时片只用于检查停止标志，某个设备累计超过 irq_timeout_ms 没有边沿才兜底读取
+        now_us = inv_ixm42xxx_get_time_us();
+        for (i = 0; i < bus->device_count; i++) {
+            struct imu_mgr_device *dev = bus->devices[i];
+
+            if (now_us - dev->last_drain_us < (uint64_t)mgr->cfg.irq_timeout_ms * 1000)
+                continue;
+            dev->stats.timeout_drains++;
+            imu_mgr_drain(mgr, dev, 0);
+        }
+    }
+
+    return NULL;
+}
+
+static int imu_mgr_start_bus(struct imu_mgr *mgr, struct imu_mgr_bus *bus, int cpu)
+{
+    int rc = -1;
+
+    // 没有 CAP_SYS_NICE 时 SCHED_FIFO 会被拒绝（EPERM），退回普通调度继续运行
+    if (mgr->cfg.priority > 0) {
+        rc = acq_create_thread(&bus->thread, imu_mgr_bus_thread, bus, mgr->cfg.priority, cpu);
+        if (rc == 0)
+            bus->realtime = 1;
+        else if (rc != EPERM && rc != EINVAL)
+            return INV_ERROR;
+    }
+    if (rc != 0 && acq_create_thread(&bus->thread, imu_mgr_bus_thread, bus, 0, cpu) != 0)
+        return INV_ERROR;
+
+    bus->started = 1;
+    return INV_ERROR_SUCCESS;
+}
+
+int imu_mgr_start(struct imu_mgr *mgr, const struct imu_mgr_config *cfg)
+{
+    int bus_of_index[IMU_MGR_MAX_BUSES];
+    uint32_t i;
+    int rc;
+
+    if (!mgr || !cfg || cfg->device_count == 0 || cfg->device_count > IMU_MGR_MAX_DEVICES)
+        return INV_ERROR_INVALID_PARAMETER;
+    for (i = 0; i < cfg->device_count; i++) {
+        if (!cfg->devices[i].driver || !cfg->devices[i].int1 || cfg->devices[i].bus >= IMU_MGR_MAX_BUSES)
+            return INV_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(mgr->buses, 0, sizeof(mgr->buses));
+    mgr->cfg = *cfg;
+    mgr->bus_count = 0;
+    mgr->last_delivered_us = 0;
+    mgr->out_of_order = 0;
+    mgr->fsync_base_us = 0;
+    for (i = 0; i < IMU_MGR_MAX_BUSES; i++)
+        bus_of_index[i] = -1;
+
+    for (i = 0; i < cfg->device_count; i++) {
+        struct imu_mgr_device *dev = &mgr->devices[i];
+        struct imu_mgr_bus *bus;
+
+        memset(&dev->stats, 0, sizeof(dev->stats));
+        dev->cfg = cfg->devices[i];
+        dev->tmst_ticks = 0;
+        dev->tmst_period = 0;
+        dev->tmst_started = 0;
+        dev->anchored = 0;
+        dev->last_timestamp_us = 0;
+        dev->fsync_edges = 0;
+        dev->fsync_rejected = 0;
+        dev->drain_count = 0;
+        dev->published_us = 0;
+        dev->has_pending = 0;
+        dev->last_drain_us = inv_ixm42xxx_get_time_us();
+        dev->tmst_res_us_q24 = inv_ixm42xxx_get_fifo_timestamp_resolution_us_q24(dev->cfg.driver);
+        if (!dev->tmst_res_us_q24) return INV_ERROR;
+
+        rc = spsc_ring_init(&dev->ring, dev->slots, sizeof(struct imu_mgr_sample), IMU_MGR_RING_SIZE);
+        rc |= inv_ixm42xxx_fifo_wm_ctrl_init(dev->cfg.driver, &dev->wm_ctrl, cfg->max_latency_us);
+        if (rc != INV_ERROR_SUCCESS) return rc;
+
+        // 总线编号可以不连续，按首次出现的顺序分配线程
+        if (bus_of_index[dev->cfg.bus] < 0) {
+            bus_of_index[dev->cfg.bus] = (int)mgr->bus_count;
+            mgr->buses[mgr->bus_count].mgr = mgr;
+            mgr->bus_count++;
+        }
+        bus = &mgr->buses[bus_of_index[dev->cfg.bus]];
+        bus->devices[bus->device_count] = dev;
+        bus->int1[bus->device_count] = dev->cfg.int1;
+        bus->device_count++;
+    }
+
+    // 公共 FSYNC 脉冲标记在温度的最低位上，不影响运动数据
+    for (i = 0; i < cfg->device_count && cfg->fsync_period_us; i++) {
+        rc = inv_ixm42xxx_configure_fsync_tag(cfg->devices[i].driver, IXM42XXX_FSYNC_CONFIG_UI_SEL_TEMP);
+        if (rc != INV_ERROR_SUCCESS) {
+            // running 还未置位，imu_mgr_stop() 不会还原，这里撤销已打开标记的设备
+            while (i-- > 0)
+                inv_ixm42xxx_configure_fsync_tag(cfg->devices[i].driver, IXM42XXX_FSYNC_CONFIG_UI_SEL_NO);
+            return rc;
+        }
+    }
+
+    for (i = 0; i < cfg->device_count; i++) {
+        mgr->devices[i].saved_cb = cfg->devices[i].driver->sensor_event_cb;
+        cfg->devices[i].driver->sensor_event_cb = imu_mgr_handle_event;
+    }
+    __atomic_store_n(&mgr->running, 1, __ATOMIC_RELEASE);
+
+    for (i = 0; i < mgr->bus_count; i++) {
+        if (imu_mgr_start_bus(mgr, &mgr->buses[i], (cfg->cpu >= 0) ? cfg->cpu + (int)i : -1) != INV_ERROR_SUCCESS) {
+            imu_mgr_stop(mgr);
+            return INV_ERROR;
+        }
+    }
+
+    return INV_ERROR_SUCCESS;
+}
+
+void imu_mgr_stop(struct imu_mgr *mgr)
+{
+    uint32_t i;
+
+    if (!mgr || !__atomic_load_n(&mgr->running, __ATOMIC_ACQUIRE)) return;
+
+    __atomic_store_n(&mgr->running, 0, __ATOMIC_RELEASE);
+    for (i = 0; i < mgr->bus_count; i++) {
+        if (mgr->buses[i].started)
+            pthread_join(mgr->buses[i].thread, NULL);
+        mgr->buses[i].started = 0;
+    }
+    for (i = 0; i < mgr->cfg.device_count; i++) {
+        mgr->devices[i].cfg.driver->sensor_event_cb = mgr->devices[i].saved_cb;
+        if (mgr->cfg.fsync_period_us)
+            inv_ixm42xxx_configure_fsync_tag(mgr->devices[i].cfg.driver, IXM42XXX_FSYNC_CONFIG_UI_SEL_NO);
+    }
+}
+
+int imu_mgr_read(struct imu_mgr *mgr, struct imu_mgr_sample *sample)
+{
+    uint64_t published_us[IMU_MGR_MAX_DEVICES];
+    struct imu_mgr_device *oldest = NULL;
+    uint64_t now_us;
+    uint32_t i;
+
+    if (!mgr || !sample) return 0;
+
+    for (i = 0; i < mgr->cfg.device_count; i++) {
+        struct imu_mgr_device *dev = &mgr->devices[i];
+
+        if (!dev->has_pending) {
+            // 先读 published_us 再取样本：环为空时，该设备之后的样本一定晚于 published_us
+            published_us[i] = __atomic_load_n(&dev->published_us, __ATOMIC_ACQUIRE);
+            dev->has_pending = spsc_ring_pop(&dev->ring, &dev->pending);
+        }
+        if (dev->has_pending && (!oldest || dev->pending.timestamp_us < oldest->pending.timestamp_us))
+            oldest = dev;
+    }
+    if (!oldest) return 0;
+
+    // 还可能送来更早样本的设备：等它，除非该样本已等待超过 merge_hold_us
+    now_us = inv_ixm42xxx_get_time_us();
+    for (i = 0; i < mgr->cfg.device_count; i++) {
+        if (mgr->devices[i].has_pending || published_us[i] >= oldest->pending.timestamp_us)
+            continue;
+        if (now_us < oldest->pending.timestamp_us + mgr->cfg.merge_hold_us)
+            return 0;
+    }
+
+    *sample = oldest->pending;
+    oldest->has_pending = 0;
+    if (sample->timestamp_us < mgr->last_delivered_us)
+        mgr->out_of_order++;
+    else
+        mgr->last_delivered_us = sample->timestamp_us;
+
+    return 1;
+}
+
+uint32_t imu_mgr_get_dropped(const struct imu_mgr *mgr, uint32_t device)
+{
+    if (!mgr || device >= mgr->cfg.device_count) return 0;
+
+    return spsc_ring_dropped(&mgr->devices[device].ring);
+}
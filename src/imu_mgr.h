@@ -0,0 +1,187 @@
+#ifndef _IMU_MGR_H_
+#define _IMU_MGR_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include "Ixm42xxxDriver_HL.h"
+#include "Ixm42xxxFifoWm.h"
+#include "acquisition.h"
+#include "platform.h"
+#include "spsc_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Devices one manager drives */
+#define IMU_MGR_MAX_DEVICES     PLATFORM_GPIO_IRQ_MAX_WAIT
+
+/** Bus threads one manager runs */
+#define IMU_MGR_MAX_BUSES       4
+
+/** Samples buffered per device between its bus thread and the consumer, power of two */
+#define IMU_MGR_RING_SIZE       1024
+
+/** Largest oscillator error accepted between two FSYNC edges, larger means an edge was misnumbered */
+#define IMU_MGR_FSYNC_MAX_PPM   20000
+
+/** Consecutive rejected FSYNC edges after which a device takes the next edge as a new reference */
+#define IMU_MGR_FSYNC_MAX_REJECT 3
+
+/**
+ * @brief One device handed to the manager
+ */
+struct imu_mgr_device_config {
+    struct inv_ixm42xxx *driver;        /**< initialized and configured driver, owned by the manager once started */
+    struct platform_gpio_irq *int1;     /**< open INT1 line of this device */
+    uint8_t bus;                        /**< bus index (0..IMU_MGR_MAX_BUSES-1), devices on the same controller share it */
+};
+
+/**
+ * @brief Manager parameters
+ */
+struct imu_mgr_config {
+    struct imu_mgr_device_config devices[IMU_MGR_MAX_DEVICES];
+    uint32_t device_count;
+    int cpu;                            /**< core of the first bus thread, the next ones take the following cores; -1 keeps the default affinity */
+    int priority;                       /**< SCHED_FIFO priority of the bus threads (1..99), 0 to run as SCHED_OTHER */
+    uint32_t max_latency_us;            /**< latency budget given to each FIFO watermark controller */
+    uint32_t irq_timeout_ms;            /**< drain a device anyway when no INT1 edge came from it for this long */
+    uint32_t merge_hold_us;             /**< how long the merge waits for a silent device before delivering past it */
+    uint32_t fsync_period_us;           /**< period of an FSYNC pulse wired to every device, 0 when FSYNC is not used */
+};
+
+/**
+ * @brief One decoded FIFO packet, tagged with its device and a merge timestamp
+ */
+struct imu_mgr_sample {
+    uint8_t device;                     /**< position in imu_mgr_config::devices */
+    uint8_t synced;                     /**< timestamp_us follows the FSYNC edges, rate measured over two of them */
+    uint64_t timestamp_us;              /**< FIFO timestamp extended to 64 bits and mapped on the common timeline */
+    uint64_t irq_timestamp_us;          /**< kernel timestamp of the INT1 edge that triggered the drain, 0 for a timeout drain */
+    inv_ixm42xxx_sensor_event_t event;
+};
+
+/**
+ * @brief Per device state
+ *
+ * The 16-bit FIFO timestamp is unwrapped packet by packet into tmst_ticks, then mapped
+ * on the common timeline from a reference point (map_ticks, map_us) at map_rate_us_q24.
+ * At the first non-empty drain the last packet is taken as produced at the INT1 edge
+ * (or at the end of the read for the startup drain), at the nominal timestamp resolution.
+ *
+ * With FSYNC, each tagged packet gives the tick of the edge (packet tick minus the
+ * reported delay). The edge is numbered on the imu_mgr::fsync_base_us grid of period
+ * fsync_period_us, which becomes the new reference, and the rate is measured against
+ * the previous edge. Every device then follows the FSYNC source instead of its own
+ * oscillator. Numbering only needs the first mapping to be within half a period.
+ */
+struct imu_mgr_device {
+    struct imu_mgr_device_config cfg;
+    inv_ixm42xxx_fifo_wm_ctrl_t wm_ctrl;
+    struct acq_stats stats;             /**< written by the bus thread, read them after imu_mgr_stop() */
+    void (*saved_cb)(inv_ixm42xxx_sensor_event_t *event); /**< driver callback restored by imu_mgr_stop() */
+    uint64_t last_drain_us;
+
+    /* Bus thread only */
+    uint32_t tmst_res_us_q24;           /**< FIFO timestamp resolution */
+    uint64_t tmst_ticks;                /**< unwrapped timestamp of the last packet */
+    uint16_t tmst_last;                 /**< raw timestamp of the last packet */
+    uint16_t tmst_period;               /**< last packet interval, used for FSYNC tagged packets */
+    uint8_t tmst_started;
+    uint8_t anchored;                   /**< the reference point is set */
+    uint64_t map_ticks;                 /**< tick of the reference point */
+    uint64_t map_us;                    /**< timeline time of the reference point */
+    uint32_t map_rate_us_q24;           /**< timeline microseconds per tick */
+    uint64_t last_timestamp_us;         /**< keeps timestamps monotonic across reference changes */
+    uint32_t fsync_edges;               /**< FSYNC edges taken as reference */
+    uint32_t fsync_rejected;            /**< FSYNC edges refused in a row, see IMU_MGR_FSYNC_MAX_PPM */
+    uint16_t drain_count;               /**< packets collected by the drain in progress */
+    uint64_t drain_ticks[IXM42XXX_FIFO_MAX_PACKETS];
+    inv_ixm42xxx_sensor_event_t drain_events[IXM42XXX_FIFO_MAX_PACKETS];
+
+    uint64_t published_us;              /**< timestamp of the newest sample pushed, accessed atomically */
+
+    /* Consumer only */
+    struct imu_mgr_sample pending;      /**< oldest sample of this device taken out of the ring */
+    int has_pending;
+
+    struct spsc_ring ring;
+    struct imu_mgr_sample slots[IMU_MGR_RING_SIZE];
+};
+
+/**
+ * @brief One bus thread and the devices it drains
+ */
+struct imu_mgr_bus {
+    struct imu_mgr *mgr;
+    pthread_t thread;
+    int started;
+    int realtime;                       /**< 1 when the thread got SCHED_FIFO */
+    uint32_t wait_errors;               /**< failed INT1 waits */
+    uint32_t device_count;
+    struct imu_mgr_device *devices[IMU_MGR_MAX_DEVICES];
+    struct platform_gpio_irq *int1[IMU_MGR_MAX_DEVICES];
+};
+
+/**
+ * @brief Multi-IMU manager: several drivers drained by one thread per bus, outputs merged by timestamp
+ *
+ * Devices sharing a bus are drained in turn by the same thread, which waits on all
+ * their INT1 lines at once; separate buses run in parallel. A spidev node is one chip
+ * select and SPI_IOC_MESSAGE cannot span several, so drains on the same controller are
+ * serialized rather than batched into one ioctl; the kernel would serialize them anyway.
+ *
+ * Each device has its own SPSC ring. imu_mgr_read() returns samples of all devices in
+ * timestamp order: a sample is delivered once every other device has either a pending
+ * sample or published one at least as recent, or after merge_hold_us when a device stays
+ * silent (imu_mgr::out_of_order counts samples older than one already delivered).
+ *
+ * With imu_mgr_config::fsync_period_us set, imu_mgr_start() enables FSYNC tagging on the
+ * temperature LSB of every device and the timestamps are locked to the shared FSYNC
+ * pulse (see struct imu_mgr_device). IIM42652 has no CLKIN input (RTC_SUPPORTED is 0),
+ * so the devices keep their own oscillators and FSYNC is the only shared reference.
+ *
+ * Between imu_mgr_start() and imu_mgr_stop() the bus threads are the only users of the
+ * drivers and INT1 lines. The pipelined mode of the acquisition module is not offered.
+ */
+struct imu_mgr {
+    struct imu_mgr_config cfg;
+    int running;                        /**< cleared by imu_mgr_stop(), accessed atomically */
+    uint32_t bus_count;
+    struct imu_mgr_bus buses[IMU_MGR_MAX_BUSES];
+    struct imu_mgr_device devices[IMU_MGR_MAX_DEVICES];
+    uint64_t fsync_base_us;             /**< timeline time of the first FSYNC edge seen by any device, accessed atomically */
+    uint64_t last_delivered_us;         /**< consumer only */
+    uint32_t out_of_order;              /**< consumer only */
+};
+
+/**
+ * @brief Size the watermarks and start one thread per bus
+ * @return 0 on success, negative value on error
+ *
+ * Falls back to SCHED_OTHER like acq_start() when SCHED_FIFO is refused.
+ */
+int imu_mgr_start(struct imu_mgr *mgr, const struct imu_mgr_config *cfg);
+
+/**
+ * @brief Stop and join the bus threads, the drivers are given back to the caller
+ */
+void imu_mgr_stop(struct imu_mgr *mgr);
+
+/**
+ * @brief Take the oldest sample across devices (consumer thread only)
+ * @return 1 when a sample was read, 0 when none can be delivered yet
+ */
+int imu_mgr_read(struct imu_mgr *mgr, struct imu_mgr_sample *sample);
+
+/**
+ * @brief Samples of a device dropped because the consumer did not keep up
+ */
+uint32_t imu_mgr_get_dropped(const struct imu_mgr *mgr, uint32_t device);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
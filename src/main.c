@@ -10,15 +10,63 @@
 #endif
 
 #include "Ixm42xxxDriver_HL.h"
+#include "Ixm42xxxConfig.h"
 #include "InvError.h"
 #include "Ixm42xxxDefs.h"
 #include "Message.h"
 #include "ErrorHelper.h"
 #include "platform.h"
+#include "acquisition.h"
+#include <linux/spi/spidev.h>
+#include <linux/gpio.h>
+
+#define SPI_DEVICE_PATH   "/dev/spidev0.1"
+#define SPI_SPEED_HZ      1000000     /* rate used until calibration */
+#define SPI_MAX_SPEED_HZ  PLATFORM_SPI_IIM42652_MAX_HZ    /* lower it if the board is known to be slower */
+
+/* 1 to talk to the sensor through i2c-dev instead of spidev */
+#define SENSOR_BUS_I2C    0
+#define I2C_DEVICE_PATH   "/dev/i2c-1"
+#define I2C_ADDRESS       0x68    /* AP_AD0 low, 0x69 when high */
+#define I2C_MAX_READ      256     /* longest read message the adapter accepts */
+
+/* INT1 wiring, adjust to the board */
+#define INT1_GPIO_CHIP    "/dev/gpiochip0"
+#define INT1_GPIO_LINE    17
+
+/* Oldest sample of a burst must reach the callback within this delay, sizes the FIFO watermark */
+#define MAX_LATENCY_US    200000
+
+/* No edge within this delay means one was missed, drain anyway */
+#define INT1_TIMEOUT_MS   1000
+
+/* Acquisition thread scheduling: SCHED_FIFO priority and core, -1 keeps the default affinity */
+#define ACQ_PRIORITY      80
+#define ACQ_CPU           1
+
+/* 1 to read the next FIFO burst while the previous one is decoded on a second thread */
+#define ACQ_PIPELINED     0
+
+/* Consumer poll period when no sample is pending */
+#define CONSUMER_IDLE_US  10000
+
+#define ACQUISITION_TIME_US 10000000
 
 /* Structure to handle the device driver */
 static struct inv_ixm42xxx sensor_driver;
 
+/* spidev or i2c-dev session, opened once and shared by every register access */
+static struct platform_spi spi_session = { -1, 0, 0, 0, 0 };
+static struct platform_i2c i2c_session = { -1, 0, 0, 0, 0 };
+
+/* INT1 edge events from the gpio character device */
+static struct platform_gpio_irq int1_irq = { .chip_fd = -1, .event_fd = -1 };
+
+/* Acquisition thread, owns sensor_driver and int1_irq while running */
+static struct acq acquisition;
+
+static void close_sessions(void);
+
 /* Callback to handle fifo data */
 static void handle_fifo_data(inv_ixm42xxx_sensor_event_t * event);
 
@@ -29,23 +77,40 @@ int main(int argc, char **argv)
 
     /* Example implementation would go here */
     
-    // Initialize the transport interface structure
-    // This is just a placeholder - in a real implementation you would
-    // need to provide actual function pointers for the transport
+    // Open the bus session once, every serif access below reuses its fd
     struct inv_ixm42xxx_serif serif;
-    serif.read_reg = platform_spi_read;      // Would need to implement SPI/I2C read
-    serif.write_reg = platform_spi_write;     // Would need to implement SPI/I2C write
+#if SENSOR_BUS_I2C
+    int rc = platform_i2c_open(&i2c_session, I2C_DEVICE_PATH, I2C_ADDRESS);
+    if(rc != INV_ERROR_SUCCESS) {
+        printf("Failed to open %s! Error code: %d\n", I2C_DEVICE_PATH, rc);
+        return -1;
+    }
+    serif.read_reg = platform_i2c_read;
+    serif.write_reg = platform_i2c_write;
+    serif.context = &i2c_session;
+    serif.serif_type = IXM42XXX_UI_I2C;
+    serif.max_read = I2C_MAX_READ;    // FIFO reads are split on packet boundaries
+#else
+    int rc = platform_spi_open(&spi_session, SPI_DEVICE_PATH, SPI_MODE_0, SPI_SPEED_HZ, 8);
+    if(rc != INV_ERROR_SUCCESS) {
+        printf("Failed to open %s! Error code: %d\n", SPI_DEVICE_PATH, rc);
+        return -1;
+    }
+    serif.read_reg = platform_spi_read;
+    serif.write_reg = platform_spi_write;
+    serif.context = &spi_session;
+    serif.serif_type = IXM42XXX_UI_SPI4;
     serif.max_read = 256;         // Max bytes for read transaction
+#endif
     serif.max_write = 256;        // Max bytes for write transaction
-    serif.context = (void*)"/dev/spidev0.1";
-    serif.serif_type = IXM42XXX_UI_SPI4;
     
     printf("Attempting to initialize IIM42652 sensor...\n");
     
     // Initialize the sensor
-    int rc = inv_ixm42xxx_init(&sensor_driver, &serif, handle_fifo_data);
+    rc = inv_ixm42xxx_init(&sensor_driver, &serif, handle_fifo_data);
     if(rc != INV_ERROR_SUCCESS) {
         printf("Failed to initialize IIM42652 sensor! Error code: %d\n", rc);
+        close_sessions();
         return -1;
     }
     
@@ -56,6 +121,7 @@ int main(int argc, char **argv)
     rc = inv_ixm42xxx_get_who_am_i(&sensor_driver, &who_am_i);
     if(rc != INV_ERROR_SUCCESS) {
         printf("Failed to read WHOAMI register! Error code: %d\n", rc);
+        close_sessions();
         return -1;
     }
     
@@ -66,57 +132,121 @@ int main(int argc, char **argv)
         printf("Successfully verified IIM42652 sensor (correct WHOAMI)\n");
     } else {
         printf("WHOAMI mismatch! Expected: 0x%02X, Got: 0x%02X\n", ICM_WHOAMI, who_am_i);
+        close_sessions();
         return -1;
     }
+
+#if !SENSOR_BUS_I2C
+    // Ramp SCLK while checking WHO_AM_I and a configuration block, keep the highest stable rate
+    uint32_t spi_hz = SPI_SPEED_HZ;
+    rc = platform_spi_calibrate(&spi_session, SPI_MAX_SPEED_HZ, &spi_hz);
+    if(rc != INV_ERROR_SUCCESS) {
+        printf("SPI clock calibration failed! Error code: %d\n", rc);
+        close_sessions();
+        return -1;
+    }
+    printf("SPI clock locked at %u Hz\n", spi_hz);
+#endif
     
     // Configure the sensor for basic accelerometer and gyroscope readings
     printf("Configuring sensor for basic measurements...\n");
     
-    // Set full scale ranges
-    rc |= inv_ixm42xxx_set_accel_fsr(&sensor_driver, IXM42XXX_ACCEL_CONFIG0_FS_SEL_16g);
-    rc |= inv_ixm42xxx_set_gyro_fsr(&sensor_driver, IXM42XXX_GYRO_CONFIG0_FS_SEL_2000dps);
-    
-    // Set output data rates
-    rc |= inv_ixm42xxx_set_accel_frequency(&sensor_driver, IXM42XXX_ACCEL_CONFIG0_ODR_50_HZ);
-    rc |= inv_ixm42xxx_set_gyro_frequency(&sensor_driver, IXM42XXX_GYRO_CONFIG0_ODR_50_HZ);
+    // Read INT_STATUS, FIFO count and FIFO data in a single bus transaction
+    rc |= inv_ixm42xxx_set_fifo_drain_mode(&sensor_driver, INV_IXM42XXX_FIFO_DRAIN_BURST);
+    // On I2C, release INT1 once per burst rather than after every packet
+    rc |= inv_ixm42xxx_set_semi_write_mode(&sensor_driver, INV_IXM42XXX_SEMI_WRITE_PER_DRAIN);
     
-    // Enable low noise mode
-    rc |= inv_ixm42xxx_enable_accel_low_noise_mode(&sensor_driver);
-    rc |= inv_ixm42xxx_enable_gyro_low_noise_mode(&sensor_driver);
+    // Stage full scale ranges, output data rates and low noise mode, then write them in one pass
+    inv_ixm42xxx_config_t sensor_cfg;
+    rc |= inv_ixm42xxx_config_begin(&sensor_driver, &sensor_cfg);
+    inv_ixm42xxx_config_set_accel_fsr(&sensor_cfg, IXM42XXX_ACCEL_CONFIG0_FS_SEL_16g);
+    inv_ixm42xxx_config_set_gyro_fsr(&sensor_cfg, IXM42XXX_GYRO_CONFIG0_FS_SEL_2000dps);
+    inv_ixm42xxx_config_set_accel_frequency(&sensor_cfg, IXM42XXX_ACCEL_CONFIG0_ODR_50_HZ);
+    inv_ixm42xxx_config_set_gyro_frequency(&sensor_cfg, IXM42XXX_GYRO_CONFIG0_ODR_50_HZ);
+    inv_ixm42xxx_config_set_accel_mode(&sensor_cfg, IXM42XXX_PWR_MGMT_0_ACCEL_MODE_LN);
+    inv_ixm42xxx_config_set_gyro_mode(&sensor_cfg, IXM42XXX_PWR_MGMT_0_GYRO_MODE_LN);
+    if(rc == INV_ERROR_SUCCESS)
+        rc |= inv_ixm42xxx_config_commit(&sensor_driver, &sensor_cfg);
     
     if(rc != INV_ERROR_SUCCESS) {
         printf("Failed to configure sensor! Error code: %d\n", rc);
+        close_sessions();
         return -1;
     }
     
     printf("Sensor configured successfully!\n");
-    printf("Starting data acquisition loop (will run for 10 seconds)...\n");
     
-    // Main data acquisition loop
-    for(int i = 0; i < 10; i++) {
-        // In a real implementation, we would wait for interrupt or poll the FIFO
-        // Here we just simulate the process
-        
-        printf("Reading sensor data... (iteration %d)\n", i+1);
-        
-        // In a real implementation, this would trigger reading data from the sensor
-        // rc = inv_ixm42xxx_get_data_from_fifo(&sensor_driver);
+    rc = platform_gpio_irq_open(&int1_irq, INT1_GPIO_CHIP, INT1_GPIO_LINE, GPIOEVENT_REQUEST_RISING_EDGE);
+    if(rc != INV_ERROR_SUCCESS) {
+        printf("Failed to request INT1 line %d on %s! Error code: %d\n", INT1_GPIO_LINE, INT1_GPIO_CHIP, rc);
+        close_sessions();
+        return -1;
+    }
+    
+    // From here the acquisition thread drains the FIFO on each INT1 (FIFO_THS) edge,
+    // with a watermark sized for the enabled ODR and MAX_LATENCY_US
+    struct acq_config acq_cfg;
+    acq_cfg.driver = &sensor_driver;
+    acq_cfg.int1 = &int1_irq;
+    acq_cfg.cpu = ACQ_CPU;
+    acq_cfg.priority = ACQ_PRIORITY;
+    acq_cfg.max_latency_us = MAX_LATENCY_US;
+    acq_cfg.irq_timeout_ms = INT1_TIMEOUT_MS;
+    acq_cfg.pipelined = ACQ_PIPELINED;
+    rc = acq_start(&acquisition, &acq_cfg);
+    if(rc != INV_ERROR_SUCCESS) {
+        printf("Failed to start acquisition thread! Error code: %d\n", rc);
+        close_sessions();
+        return -1;
+    }
+    
+    printf("Acquisition thread started (%s), FIFO watermark: %u packets\n",
+           acquisition.realtime ? "SCHED_FIFO" : "SCHED_OTHER, no CAP_SYS_NICE", acquisition.wm_ctrl.wm);
+    printf("Consuming samples for 10 seconds...\n");
+    
+    // Consumer loop: printing is slow, but it only delays this thread, never the FIFO drain
+    uint64_t start_us = inv_ixm42xxx_get_time_us();
+    while(inv_ixm42xxx_get_time_us() - start_us < ACQUISITION_TIME_US) {
+        struct acq_sample sample;
         
-        // Sleep briefly (in real implementation, replace with appropriate delay)
-        #ifdef _WIN32
-            Sleep(1000);  // On Windows (1 second)
-        #else
-            usleep(1000000);  // On Linux/Unix (1 second)
-        #endif
+        if(!acq_read(&acquisition, &sample)) {
+            inv_ixm42xxx_sleep_us(CONSUMER_IDLE_US);
+            continue;
+        }
         
-        // For demonstration purposes, we'll just print a sample output
-        printf("Sample data: Accel[X,Y,Z]: 0, 0, 0 | Gyro[X,Y,Z]: 0, 0, 0 | Temp: 0\n");
+        printf("INT1 @ %llu us, sample @ %llu us: ", (unsigned long long)sample.irq_timestamp_us,
+               (unsigned long long)sample.timestamp_us);
+        handle_fifo_data(&sample.event);
     }
     
+    acq_stop(&acquisition);
+    printf("Drains: %u (%u on timeout), packets: %u, errors: %u, dropped by consumer: %u\n",
+           acquisition.stats.drains, acquisition.stats.timeout_drains, acquisition.stats.packets,
+           acquisition.stats.errors, acq_get_dropped(&acquisition));
+    float offset_sigma_us = 0;
+    printf("Drift tracker: %s, offset sigma %.1f us, %u interrupts accepted, %u refused\n",
+           clock_calibration_is_locked(&acquisition.clk_cal, &offset_sigma_us) ? "locked" : "not locked",
+           offset_sigma_us, acquisition.clk_cal.trk.observations, acquisition.clk_cal.trk.outliers);
+    if(acq_cfg.pipelined && acquisition.stats.drains && acquisition.pipe_stats.bursts) {
+        printf("Pipeline: read %llu us avg / %u us max, decode %llu us avg / %u us max, stalls: %u, decode errors: %u, discarded: %u\n",
+               (unsigned long long)(acquisition.pipe_stats.read_us_total / acquisition.stats.drains), acquisition.pipe_stats.read_us_max,
+               (unsigned long long)(acquisition.pipe_stats.decode_us_total / acquisition.pipe_stats.bursts), acquisition.pipe_stats.decode_us_max,
+               acquisition.pipe_stats.stalls, acquisition.pipe_stats.decode_errors, acquisition.pipe_stats.discarded_bursts);
+    }
+    
+    close_sessions();
     printf("\nTest completed successfully!\n");
     return 0;
 }
 
+/* Release the INT1 line and the bus node, safe on sessions that were never opened */
+static void close_sessions(void)
+{
+    platform_gpio_irq_close(&int1_irq);
+    platform_spi_close(&spi_session);
+    platform_i2c_close(&i2c_session);
+}
+
 /* Callback function to handle FIFO data */
 static void handle_fifo_data(inv_ixm42xxx_sensor_event_t * event)
 {
@@ -1,10 +1,17 @@
+#define _GNU_SOURCE
 #include "platform.h"
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include <time.h>
-#include <sys/time.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <linux/spi/spidev.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <errno.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -23,9 +30,45 @@ void inv_ixm42xxx_sleep_us(unsigned int us)
 
 uint64_t inv_ixm42xxx_get_time_us(void)
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+    return platform_time_ns() / 1000;
+}
+
+static uint64_t platform_clock_ns(int clock)
+{
+    struct timespec ts;
+
+    clock_gettime((clockid_t)clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t platform_time_ns(void)
+{
+    return platform_clock_ns(PLATFORM_TIME_CLOCK);
+}
+
+// 在两次读取本地时钟之间读取另一时钟，取夹得最紧的一次作为两时钟的偏移；被抢占时夹窗会变大，最多重试 3 次
+uint64_t platform_time_convert_ns(int clock, uint64_t timestamp_ns)
+{
+    uint64_t before, other, after, window, best_window = UINT64_MAX;
+    int64_t offset = 0;
+    int i;
+
+    if (clock == PLATFORM_TIME_CLOCK) return timestamp_ns;
+
+    for (i = 0; i < 3; i++) {
+        before = platform_time_ns();
+        other = platform_clock_ns(clock);
+        after = platform_time_ns();
+
+        window = after - before;
+        if (window < best_window) {
+            best_window = window;
+            offset = (int64_t)(before + window / 2 - other);
+        }
+        if (best_window < 1000) break;
+    }
+
+    return (uint64_t)((int64_t)timestamp_ns + offset);
 }
 
 void inv_helper_disable_irq(void)
@@ -41,53 +84,424 @@ void inv_helper_enable_irq(void)
 }
 
 
-// SPI 底层读函数（匹配 inv_ixm42xxx_serif 的函数签名）
-int platform_spi_read(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len) {
-    if (!serif || !buf || len == 0) return INV_ERROR_INVALID_PARAMETER;
+// 打开 spidev 节点并一次性配置 mode / bits-per-word / speed，之后所有寄存器访问复用该 fd
+int platform_spi_open(struct platform_spi *spi, const char *path, uint8_t mode, uint32_t speed_hz, uint8_t bits_per_word)
+{
+    if (!spi || !path || speed_hz == 0 || bits_per_word == 0) return INV_ERROR_INVALID_PARAMETER;
 
-    int fd = open((char*)serif->context, O_RDWR);
-    if (fd < 0) return INV_ERROR_IO;
+    memset(spi, 0, sizeof(*spi));
+    spi->fd = open(path, O_RDWR);
+    if (spi->fd < 0) return INV_ERROR_IO;
 
-    // IIM42652 SPI 读规则：寄存器地址需置位最高位（0x80）
-    uint8_t tx_buf[1] = {reg | 0x80};
-    struct spi_ioc_transfer tr = {
-        .tx_buf = (unsigned long)tx_buf,
-        .rx_buf = (unsigned long)buf,
-        .len = len + 1, // 地址1字节 + 数据len字节
-        .speed_hz = 1000000, // SPI 速率（根据传感器手册调整，如 1MHz）
-        .bits_per_word = 8,
-        .cs_change = 0,
-    };
-
-    int rc = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
-    close(fd);
+    if (platform_spi_configure(spi, mode, speed_hz, bits_per_word) != INV_ERROR_SUCCESS) {
+        platform_spi_close(spi);
+        return INV_ERROR_IO;
+    }
+
+    return INV_ERROR_SUCCESS;
+}
+
+// 内核会把每个 transfer 的 speed_hz 限制在 max_speed_hz 以内，因此改速率必须同时写 SPI_IOC_WR_MAX_SPEED_HZ
+int platform_spi_configure(struct platform_spi *spi, uint8_t mode, uint32_t speed_hz, uint8_t bits_per_word)
+{
+    if (!spi || spi->fd < 0 || speed_hz == 0 || bits_per_word == 0) return INV_ERROR_INVALID_PARAMETER;
+
+    if (ioctl(spi->fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(spi->fd, SPI_IOC_WR_BITS_PER_WORD, &bits_per_word) < 0 ||
+        ioctl(spi->fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) {
+        // 尽量恢复原设置（首次打开时原设置为 0，跳过）
+        if (spi->speed_hz) {
+            ioctl(spi->fd, SPI_IOC_WR_MODE, &spi->mode);
+            ioctl(spi->fd, SPI_IOC_WR_BITS_PER_WORD, &spi->bits_per_word);
+            ioctl(spi->fd, SPI_IOC_WR_MAX_SPEED_HZ, &spi->speed_hz);
+        }
+        return INV_ERROR_IO;
+    }
+
+    spi->mode = mode;
+    spi->speed_hz = speed_hz;
+    spi->bits_per_word = bits_per_word;
+
+    return INV_ERROR_SUCCESS;
+}
+
+void platform_spi_close(struct platform_spi *spi)
+{
+    if (!spi) return;
+
+    if (spi->fd >= 0) close(spi->fd);
+    spi->fd = -1;
+}
+
+uint32_t platform_spi_get_syscall_count(const struct platform_spi *spi)
+{
+    return spi ? spi->syscall_count : 0;
+}
+
+void platform_spi_reset_stats(struct platform_spi *spi)
+{
+    if (spi) spi->syscall_count = 0;
+}
+
+// 地址阶段与数据阶段拆成同一 message 中的两个 transfer，CS 保持有效，
+// 数据直接收进调用者 buf，无需中间拷贝
+static int platform_spi_transfer(struct platform_spi *spi, uint8_t addr, uint8_t *rx, const uint8_t *tx, uint32_t len)
+{
+    struct spi_ioc_transfer tr[2];
+
+    memset(tr, 0, sizeof(tr));
+    tr[0].tx_buf = (unsigned long)&addr;
+    tr[0].len = 1;
+    tr[0].speed_hz = spi->speed_hz;
+    tr[0].bits_per_word = spi->bits_per_word;
+
+    tr[1].tx_buf = (unsigned long)tx;
+    tr[1].rx_buf = (unsigned long)rx;
+    tr[1].len = len;
+    tr[1].speed_hz = spi->speed_hz;
+    tr[1].bits_per_word = spi->bits_per_word;
+
+    spi->syscall_count++;
+    int rc = ioctl(spi->fd, SPI_IOC_MESSAGE(2), tr);
 
     return (rc < 0) ? INV_ERROR_IO : INV_ERROR_SUCCESS;
 }
 
+// 校准时逐级尝试的 SCLK；控制器按自身分频取不超过该值的最近频率
+static const uint32_t platform_spi_ramp_hz[] = {
+    1000000, 2000000, 4000000, 5000000, 8000000, 10000000, 12000000, 16000000, 20000000, 24000000
+};
+
+#define PLATFORM_SPI_CAL_BLOCK_REG  MPUREG_INTF_CONFIG0
+#define PLATFORM_SPI_CAL_BLOCK_LEN  (MPUREG_FIFO_CONFIG3 - MPUREG_INTF_CONFIG0 + 1)
+
+// 当前速率下连续校验 WHO_AM_I 与配置寄存器块，任何一次读失败或内容不一致即判定该速率不稳定
+static bool platform_spi_rate_is_stable(struct platform_spi *spi, const uint8_t *ref)
+{
+    uint8_t who_am_i;
+    uint8_t block[PLATFORM_SPI_CAL_BLOCK_LEN];
+    int i;
+
+    for (i = 0; i < PLATFORM_SPI_CAL_REPEAT; i++) {
+        if (platform_spi_transfer(spi, MPUREG_WHO_AM_I | 0x80, &who_am_i, NULL, 1) != INV_ERROR_SUCCESS ||
+            who_am_i != ICM_WHOAMI)
+            return false;
+        if (platform_spi_transfer(spi, PLATFORM_SPI_CAL_BLOCK_REG | 0x80, block, NULL, sizeof(block)) != INV_ERROR_SUCCESS ||
+            memcmp(block, ref, sizeof(block)) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+int platform_spi_calibrate(struct platform_spi *spi, uint32_t max_speed_hz, uint32_t *locked_hz)
+{
+    uint8_t ref[PLATFORM_SPI_CAL_BLOCK_LEN];
+    uint32_t best_hz = 0, prev_hz = 0;
+    size_t i;
+    int rc;
+
+    if (!spi || spi->fd < 0 || max_speed_hz < PLATFORM_SPI_CAL_BASE_HZ) return INV_ERROR_INVALID_PARAMETER;
+
+    // 参考值在最低速率下读取
+    rc = platform_spi_configure(spi, spi->mode, PLATFORM_SPI_CAL_BASE_HZ, spi->bits_per_word);
+    if (rc != INV_ERROR_SUCCESS) return rc;
+    rc = platform_spi_transfer(spi, PLATFORM_SPI_CAL_BLOCK_REG | 0x80, ref, NULL, sizeof(ref));
+    if (rc != INV_ERROR_SUCCESS) return rc;
+    if (!platform_spi_rate_is_stable(spi, ref)) return INV_ERROR_IO;
+    best_hz = PLATFORM_SPI_CAL_BASE_HZ;
+
+    for (i = 0; i < sizeof(platform_spi_ramp_hz) / sizeof(platform_spi_ramp_hz[0]); i++) {
+        uint32_t hz = platform_spi_ramp_hz[i];
+
+        if (hz <= PLATFORM_SPI_CAL_BASE_HZ) continue;
+        if (hz > max_speed_hz) break;
+        if (platform_spi_configure(spi, spi->mode, hz, spi->bits_per_word) != INV_ERROR_SUCCESS ||
+            !platform_spi_rate_is_stable(spi, ref))
+            break;
+        prev_hz = best_hz;
+        best_hz = hz;
+    }
+
+    // 最高通过级只通过了有限次校验，无论是否遇到失败级都退回一级留出余量；只有基准速率通过时保持基准速率
+    if (prev_hz)
+        best_hz = prev_hz;
+
+    rc = platform_spi_configure(spi, spi->mode, best_hz, spi->bits_per_word);
+    if (rc != INV_ERROR_SUCCESS) return rc;
+    if (locked_hz) *locked_hz = best_hz;
+
+    return INV_ERROR_SUCCESS;
+}
+
+// SPI 底层读函数（匹配 inv_ixm42xxx_serif 的函数签名），serif->context 指向 struct platform_spi
+int platform_spi_read(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len) {
+    if (!serif || !serif->context || !buf || len == 0) return INV_ERROR_INVALID_PARAMETER;
+
+    struct platform_spi *spi = (struct platform_spi *)serif->context;
+    if (spi->fd < 0) return INV_ERROR_IO;
+
+    // IIM42652 SPI 读规则：寄存器地址需置位最高位（0x80）
+    return platform_spi_transfer(spi, reg | 0x80, buf, NULL, len);
+}
+
 // SPI 底层写函数
 int platform_spi_write(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len) {
-    if (!serif || !buf || len == 0) return INV_ERROR_INVALID_PARAMETER;
+    if (!serif || !serif->context || !buf || len == 0) return INV_ERROR_INVALID_PARAMETER;
 
-    int fd = open((char*)serif->context, O_RDWR);
-    if (fd < 0) return INV_ERROR_IO;
+    struct platform_spi *spi = (struct platform_spi *)serif->context;
+    if (spi->fd < 0) return INV_ERROR_IO;
 
-    // 拼接「寄存器地址 + 数据」
-    uint8_t tx_buf[len + 1];
-    tx_buf[0] = reg & 0x7F; // 写地址：最高位清0
-    memcpy(&tx_buf[1], buf, len);
+    // 写地址：最高位清0
+    return platform_spi_transfer(spi, reg & 0x7F, NULL, buf, len);
+}
 
-    struct spi_ioc_transfer tr = {
-        .tx_buf = (unsigned long)tx_buf,
-        .rx_buf = (unsigned long)NULL,
-        .len = len + 1,
-        .speed_hz = 1000000,
-        .bits_per_word = 8,
-        .cs_change = 0,
-    };
+// 打开 i2c-dev 节点；要求适配器支持 I2C_RDWR（I2C_FUNC_I2C），读寄存器才能用重复起始合成一次传输
+int platform_i2c_open(struct platform_i2c *i2c, const char *path, uint16_t addr)
+{
+    unsigned long funcs = 0;
 
-    int rc = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
-    close(fd);
+    if (!i2c || !path || addr > 0x7F) return INV_ERROR_INVALID_PARAMETER;
 
-    return (rc < 0) ? INV_ERROR_IO : INV_ERROR_SUCCESS;
+    memset(i2c, 0, sizeof(*i2c));
+    i2c->fd = open(path, O_RDWR);
+    if (i2c->fd < 0) return INV_ERROR_IO;
+    i2c->addr = addr;
+
+    if (ioctl(i2c->fd, I2C_FUNCS, &funcs) < 0 || !(funcs & I2C_FUNC_I2C) ||
+        platform_i2c_set_retries(i2c, PLATFORM_I2C_DEFAULT_TIMEOUT_MS, PLATFORM_I2C_DEFAULT_RETRIES) != INV_ERROR_SUCCESS) {
+        platform_i2c_close(i2c);
+        return INV_ERROR_IO;
+    }
+
+    return INV_ERROR_SUCCESS;
+}
+
+// 重试由本层完成，适配器自身的仲裁重试（I2C_RETRIES）关掉，避免两层叠加
+int platform_i2c_set_retries(struct platform_i2c *i2c, uint32_t timeout_ms, uint8_t retries)
+{
+    if (!i2c || i2c->fd < 0) return INV_ERROR_INVALID_PARAMETER;
+
+    if (ioctl(i2c->fd, I2C_TIMEOUT, (unsigned long)((timeout_ms + 9) / 10)) < 0 ||
+        ioctl(i2c->fd, I2C_RETRIES, 0UL) < 0)
+        return INV_ERROR_IO;
+    i2c->retries = retries;
+
+    return INV_ERROR_SUCCESS;
+}
+
+void platform_i2c_close(struct platform_i2c *i2c)
+{
+    if (!i2c) return;
+
+    if (i2c->fd >= 0) close(i2c->fd);
+    i2c->fd = -1;
+}
+
+uint32_t platform_i2c_get_syscall_count(const struct platform_i2c *i2c)
+{
+    return i2c ? i2c->syscall_count : 0;
+}
+
+void platform_i2c_reset_stats(struct platform_i2c *i2c)
+{
+    if (i2c) {
+        i2c->syscall_count = 0;
+        i2c->retry_count = 0;
+    }
+}
+
+// 仲裁失败、地址 NACK：总线上没有数据传输，立即重试；
+// 超时（时钟拉伸过长）可能已读出部分数据，只有读操作无副作用时才重试。不做睡眠等待
+static int platform_i2c_transfer(struct platform_i2c *i2c, struct i2c_msg *msgs, uint32_t nmsgs, bool retry_timeout)
+{
+    struct i2c_rdwr_ioctl_data xfer;
+    uint32_t attempt;
+
+    xfer.msgs = msgs;
+    xfer.nmsgs = nmsgs;
+
+    for (attempt = 0; ; attempt++) {
+        i2c->syscall_count++;
+        if (ioctl(i2c->fd, I2C_RDWR, &xfer) >= 0)
+            return INV_ERROR_SUCCESS;
+        if (attempt >= i2c->retries)
+            break;
+        if (errno == ETIMEDOUT && !retry_timeout)
+            break;
+        if (errno != EAGAIN && errno != ENXIO && errno != EREMOTEIO && errno != ETIMEDOUT)
+            break;
+        i2c->retry_count++;
+    }
+
+    return (errno == ETIMEDOUT) ? INV_ERROR_TIMEOUT : INV_ERROR_IO;
+}
+
+// 读清或出队的寄存器：INT_STATUS、FIFO_COUNT 锁存、FIFO_DATA、INT_STATUS2/3（按 bank 0 保守判断）
+static bool platform_i2c_read_has_side_effect(uint8_t reg, uint32_t len)
+{
+    uint32_t last = (uint32_t)reg + len - 1;
+
+    return (reg <= MPUREG_FIFO_DATA && last >= MPUREG_INT_STATUS) ||
+           (reg <= MPUREG_INT_STATUS3 && last >= MPUREG_INT_STATUS2);
+}
+
+// 写寄存器地址 + 重复起始 + 读数据，一次 ioctl，数据直接收进调用者 buf
+int platform_i2c_read(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len)
+{
+    struct i2c_msg msgs[2];
+
+    if (!serif || !serif->context || !buf || len == 0 || len > 0xFFFF) return INV_ERROR_INVALID_PARAMETER;
+
+    struct platform_i2c *i2c = (struct platform_i2c *)serif->context;
+    if (i2c->fd < 0) return INV_ERROR_IO;
+
+    msgs[0].addr = i2c->addr;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = i2c->addr;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = (uint16_t)len;
+    msgs[1].buf = buf;
+
+    return platform_i2c_transfer(i2c, msgs, 2, !platform_i2c_read_has_side_effect(reg, len));
+}
+
+// I2C 写没有“地址阶段 + 数据阶段”的拼接（I2C_M_NOSTART 多数适配器不支持），地址与数据需放在同一 message
+int platform_i2c_write(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len)
+{
+    struct i2c_msg msg;
+    uint8_t tx[1 + PLATFORM_I2C_MAX_WRITE];
+
+    if (!serif || !serif->context || !buf || len == 0) return INV_ERROR_INVALID_PARAMETER;
+    if (len > PLATFORM_I2C_MAX_WRITE) return INV_ERROR_SIZE;
+
+    struct platform_i2c *i2c = (struct platform_i2c *)serif->context;
+    if (i2c->fd < 0) return INV_ERROR_IO;
+
+    tx[0] = reg;
+    memcpy(&tx[1], buf, len);
+    msg.addr = i2c->addr;
+    msg.flags = 0;
+    msg.len = (uint16_t)(len + 1);
+    msg.buf = tx;
+
+    return platform_i2c_transfer(i2c, &msg, 1, true);
+}
+
+// 以 v1 line event 方式申请 INT1 所在 GPIO：内核在中断上下文打时间戳并排队，读出时不会丢边沿
+int platform_gpio_irq_open(struct platform_gpio_irq *irq, const char *chip_path, uint32_t line, uint32_t edge_flags)
+{
+    struct gpioevent_request req;
+
+    if (!irq || !chip_path || edge_flags == 0) return INV_ERROR_INVALID_PARAMETER;
+
+    memset(irq, 0, sizeof(*irq));
+    irq->event_fd = -1;
+    irq->line = line;
+    irq->chip_fd = open(chip_path, O_RDONLY);
+    if (irq->chip_fd < 0) return INV_ERROR_IO;
+
+    memset(&req, 0, sizeof(req));
+    req.lineoffset = line;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = edge_flags;
+    strncpy(req.consumer_label, "iim42652-int1", sizeof(req.consumer_label) - 1);
+
+    if (ioctl(irq->chip_fd, GPIO_GET_LINEEVENT_IOCTL, &req) < 0) {
+        platform_gpio_irq_close(irq);
+        return INV_ERROR_IO;
+    }
+    irq->event_fd = req.fd;
+
+    return INV_ERROR_SUCCESS;
+}
+
+void platform_gpio_irq_close(struct platform_gpio_irq *irq)
+{
+    if (!irq) return;
+
+    if (irq->event_fd >= 0) close(irq->event_fd);
+    if (irq->chip_fd >= 0) close(irq->chip_fd);
+    irq->event_fd = -1;
+    irq->chip_fd = -1;
+}
+
+// v1 line event 的时间戳在 5.7 之前是 CLOCK_REALTIME，之后是 CLOCK_MONOTONIC；REALTIME 的值远大于开机时长，按量级区分
+#define PLATFORM_GPIO_REALTIME_MIN_NS  1000000000000000000ULL
+
+static uint64_t platform_gpio_event_time_ns(struct platform_gpio_irq *irq, uint64_t event_ns)
+{
+    int clock = event_ns >= PLATFORM_GPIO_REALTIME_MIN_NS ? CLOCK_REALTIME : CLOCK_MONOTONIC;
+
+    irq->event_count++;
+    irq->last_timestamp_ns = platform_time_convert_ns(clock, event_ns);
+
+    return irq->last_timestamp_ns;
+}
+
+int platform_gpio_irq_wait(struct platform_gpio_irq *irq, int timeout_ms, uint64_t *timestamp_us)
+{
+    struct pollfd pfd;
+    struct gpioevent_data event;
+    int rc;
+
+    if (!irq || irq->event_fd < 0) return INV_ERROR_INVALID_PARAMETER;
+
+    pfd.fd = irq->event_fd;
+    pfd.events = POLLIN | POLLPRI;
+    pfd.revents = 0;
+
+    do {
+        rc = poll(&pfd, 1, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) return INV_ERROR_IO;
+    if (rc == 0) return 0;
+
+    // 每次 read 取出一个事件，积压的边沿留给下一次调用
+    if (read(irq->event_fd, &event, sizeof(event)) != (ssize_t)sizeof(event)) return INV_ERROR_IO;
+
+    platform_gpio_event_time_ns(irq, event.timestamp);
+    if (timestamp_us) *timestamp_us = irq->last_timestamp_ns / 1000;
+
+    return 1;
+}
+
+// 同一总线线程上的多个 INT1 一起 poll；只处理第一个就绪的 line，其余留在内核队列里下次立即返回
+int platform_gpio_irq_wait_any(struct platform_gpio_irq *const *irqs, uint32_t count, int timeout_ms,
+                               uint32_t *index, uint64_t *timestamp_us)
+{
+    struct pollfd pfd[PLATFORM_GPIO_IRQ_MAX_WAIT];
+    struct gpioevent_data event;
+    uint32_t i;
+    int rc;
+
+    if (!irqs || !index || count == 0 || count > PLATFORM_GPIO_IRQ_MAX_WAIT) return INV_ERROR_INVALID_PARAMETER;
+
+    for (i = 0; i < count; i++) {
+        if (!irqs[i] || irqs[i]->event_fd < 0) return INV_ERROR_INVALID_PARAMETER;
+        pfd[i].fd = irqs[i]->event_fd;
+        pfd[i].events = POLLIN | POLLPRI;
+        pfd[i].revents = 0;
+    }
+
+    do {
+        rc = poll(pfd, count, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) return INV_ERROR_IO;
+    if (rc == 0) return 0;
+
+    for (i = 0; i < count; i++) {
+        if (pfd[i].revents)
+            break;
+    }
+    if (i == count) return 0;
+    if (read(pfd[i].fd, &event, sizeof(event)) != (ssize_t)sizeof(event)) return INV_ERROR_IO;
+
+    platform_gpio_event_time_ns(irqs[i], event.timestamp);
+    *index = i;
+    if (timestamp_us) *timestamp_us = irqs[i]->last_timestamp_ns / 1000;
+
+    return 1;
 }
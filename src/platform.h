@@ -16,12 +16,39 @@ extern "C" {
  */
 void inv_ixm42xxx_sleep_us(unsigned int us);
 
+/** Clock of every platform timestamp (a clockid_t), CLOCK_MONOTONIC_RAW unless overridden at build time */
+#ifndef PLATFORM_TIME_CLOCK
+#define PLATFORM_TIME_CLOCK     CLOCK_MONOTONIC_RAW
+#endif
+
 /**
  * @brief Get the current time in microseconds
- * @return Current time in microseconds
+ * @return platform_time_ns() in microseconds
  */
 uint64_t inv_ixm42xxx_get_time_us(void);
 
+/**
+ * @brief Current time in nanoseconds on PLATFORM_TIME_CLOCK
+ *
+ * CLOCK_MONOTONIC_RAW is neither stepped nor slewed by NTP, so intervals measured against
+ * the sensor oscillator only see the crystal errors. clock_gettime() is served by the vDSO,
+ * without a system call, on kernels that offer this clock there (x86 and arm64 since 5.3,
+ * arm since 5.5).
+ */
+uint64_t platform_time_ns(void);
+
+/**
+ * @brief Bring a timestamp taken on another clock to the PLATFORM_TIME_CLOCK base
+ * @param[in] clock         clockid_t of timestamp_ns (CLOCK_MONOTONIC, CLOCK_REALTIME, ...)
+ * @param[in] timestamp_ns  Timestamp to convert
+ * @return timestamp_ns on PLATFORM_TIME_CLOCK
+ *
+ * The offset between both clocks is sampled now, between two reads of PLATFORM_TIME_CLOCK.
+ * Clocks that only differ by NTP slewing (500 ppm at most) give less than 1 us of error on
+ * timestamps up to 2 ms old; a step of CLOCK_REALTIME since the timestamp is not undone.
+ */
+uint64_t platform_time_convert_ns(int clock, uint64_t timestamp_ns);
+
 /**
  * @brief Disable interrupts (platform-specific)
  */
@@ -32,8 +59,221 @@ void inv_helper_disable_irq(void);
  */
 void inv_helper_enable_irq(void);
 
+/** Highest SCLK rated for IIM42652 SPI */
+#define PLATFORM_SPI_IIM42652_MAX_HZ  24000000
+
+/** Lowest rate tried by platform_spi_calibrate(), also the reference rate */
+#define PLATFORM_SPI_CAL_BASE_HZ      1000000
+
+/** Back-to-back checks a rate must pass in platform_spi_calibrate() */
+#define PLATFORM_SPI_CAL_REPEAT       32
+
+/**
+ * @brief spidev session shared by every inv_ixm42xxx_serif access
+ *
+ * The device node is opened and configured once by platform_spi_open() and
+ * kept open until platform_spi_close(). Pass a pointer to this structure as
+ * inv_ixm42xxx_serif::context.
+ */
+struct platform_spi {
+    int fd;                 /**< spidev file descriptor, -1 when closed */
+    uint8_t mode;           /**< SPI_MODE_0 .. SPI_MODE_3 */
+    uint8_t bits_per_word;  /**< word size, 8 for IIM42652 */
+    uint32_t speed_hz;      /**< SCLK frequency in Hz */
+    uint32_t syscall_count; /**< transfer ioctl() issued since last platform_spi_reset_stats() */
+};
+
+/**
+ * @brief Open a spidev node and apply mode, word size and clock once
+ * @param[out] spi            Session to initialize
+ * @param[in] path            spidev node, e.g. "/dev/spidev0.1"
+ * @param[in] mode            SPI mode (SPI_MODE_0 or SPI_MODE_3 for IIM42652)
+ * @param[in] speed_hz        SCLK frequency in Hz
+ * @param[in] bits_per_word   Word size, usually 8
+ * @return 0 on success, negative value on error
+ */
+int platform_spi_open(struct platform_spi *spi, const char *path, uint8_t mode, uint32_t speed_hz, uint8_t bits_per_word);
+
+/**
+ * @brief Change mode, word size and clock of an open session
+ *
+ * Applied to the device with SPI_IOC_WR_* so the controller limit follows the
+ * per-transfer rate; the session keeps its previous settings on failure.
+ * @param[in] spi             Open session
+ * @param[in] mode            SPI mode (SPI_MODE_0 or SPI_MODE_3 for IIM42652)
+ * @param[in] speed_hz        SCLK frequency in Hz
+ * @param[in] bits_per_word   Word size, usually 8
+ * @return 0 on success, negative value on error
+ */
+int platform_spi_configure(struct platform_spi *spi, uint8_t mode, uint32_t speed_hz, uint8_t bits_per_word);
+
+/**
+ * @brief Find the highest SPI clock the board carries reliably and keep it
+ *
+ * Ramps the clock from PLATFORM_SPI_CAL_BASE_HZ up to max_speed_hz. At each step
+ * WHO_AM_I and the bank 0 configuration block (INTF_CONFIG0..FIFO_CONFIG3, no read
+ * side effects) are read PLATFORM_SPI_CAL_REPEAT times and checked against the
+ * values read at the base rate. The ramp stops at the first failing step or at
+ * max_speed_hz, and the session is always locked one step below the highest passing
+ * one as safety margin, failure seen or not. Only the base rate is kept as is.
+ * Bank 0 must be selected and the sensor must not be reconfigured meanwhile.
+ * @param[in] spi            Open session
+ * @param[in] max_speed_hz   Upper bound, e.g. PLATFORM_SPI_IIM42652_MAX_HZ
+ * @param[out] locked_hz     Rate in use on return, may be NULL
+ * @return 0 on success, INV_ERROR_IO if the base rate itself fails, negative value on error
+ */
+int platform_spi_calibrate(struct platform_spi *spi, uint32_t max_speed_hz, uint32_t *locked_hz);
+
+/**
+ * @brief Close the spidev node held by the session
+ */
+void platform_spi_close(struct platform_spi *spi);
+
+/**
+ * @brief Number of transfer syscalls issued since last reset
+ */
+uint32_t platform_spi_get_syscall_count(const struct platform_spi *spi);
+
+/**
+ * @brief Reset session statistics, typically before each FIFO drain
+ */
+void platform_spi_reset_stats(struct platform_spi *spi);
+
+/**
+ * @brief inv_ixm42xxx_serif read/write hooks, serif->context must point to an open struct platform_spi
+ */
 int platform_spi_read(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len); 
 int platform_spi_write(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len); 
+
+/** Largest register write accepted by platform_i2c_write(), register address excluded */
+#define PLATFORM_I2C_MAX_WRITE  256
+
+/** Defaults applied by platform_i2c_open(), see platform_i2c_set_retries() */
+#define PLATFORM_I2C_DEFAULT_TIMEOUT_MS  20
+#define PLATFORM_I2C_DEFAULT_RETRIES     3
+
+/**
+ * @brief i2c-dev session shared by every inv_ixm42xxx_serif access
+ *
+ * Every access is a single I2C_RDWR ioctl: a read is the register address write and
+ * the data read combined with a repeated start, so INT_STATUS, FIFO_COUNT and FIFO_DATA
+ * can be read in one burst like on spidev. Pass a pointer to this structure as
+ * inv_ixm42xxx_serif::context, and set inv_ixm42xxx_serif::max_read to the longest
+ * message the adapter accepts: the driver splits FIFO reads accordingly.
+ *
+ * A transfer failing on arbitration loss or address NACK moved no data and is retried
+ * at once. A timeout (SCL held low too long by clock stretching) is retried only for
+ * registers without read side effects: INT_STATUS and FIFO_DATA reads are left to the
+ * driver, which knows how to recover the FIFO.
+ */
+struct platform_i2c {
+    int fd;                 /**< i2c-dev file descriptor, -1 when closed */
+    uint16_t addr;          /**< 7-bit slave address, 0x68 or 0x69 depending on AP_AD0 */
+    uint8_t retries;        /**< extra attempts after a failed transfer */
+    uint32_t syscall_count; /**< transfer ioctl() issued since last platform_i2c_reset_stats() */
+    uint32_t retry_count;   /**< of which retries */
+};
+
+/**
+ * @brief Open an i2c-dev node and check it supports combined transfers
+ * @param[out] i2c    Session to initialize
+ * @param[in] path    i2c-dev node, e.g. "/dev/i2c-1"
+ * @param[in] addr    7-bit slave address
+ * @return 0 on success, negative value on error
+ */
+int platform_i2c_open(struct platform_i2c *i2c, const char *path, uint16_t addr);
+
+/**
+ * @brief Set the adapter timeout and the number of retries of a failed transfer
+ * @param[in] i2c          Open session
+ * @param[in] timeout_ms   Adapter timeout (I2C_TIMEOUT), rounded up to 10 ms
+ * @param[in] retries      Extra attempts, 0 to report the first failure
+ * @return 0 on success, negative value on error
+ */
+int platform_i2c_set_retries(struct platform_i2c *i2c, uint32_t timeout_ms, uint8_t retries);
+
+/**
+ * @brief Close the i2c-dev node held by the session
+ */
+void platform_i2c_close(struct platform_i2c *i2c);
+
+/**
+ * @brief Number of transfer syscalls issued since last reset
+ */
+uint32_t platform_i2c_get_syscall_count(const struct platform_i2c *i2c);
+
+/**
+ * @brief Reset session statistics
+ */
+void platform_i2c_reset_stats(struct platform_i2c *i2c);
+
+/**
+ * @brief inv_ixm42xxx_serif read/write hooks, serif->context must point to an open struct platform_i2c
+ */
+int platform_i2c_read(struct inv_ixm42xxx_serif *serif, uint8_t reg, uint8_t *buf, uint32_t len);
+int platform_i2c_write(struct inv_ixm42xxx_serif *serif, uint8_t reg, const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Edge events of one GPIO line requested through the gpio character device
+ *
+ * The line is requested as an input with GPIO_GET_LINEEVENT_IOCTL (v1 ABI, available
+ * on every kernel since 4.8). Every edge is queued by the kernel together with the
+ * timestamp taken in the interrupt handler, so no edge is lost while the FIFO is
+ * being drained.
+ */
+struct platform_gpio_irq {
+    int chip_fd;            /**< /dev/gpiochipN file descriptor, -1 when closed */
+    int event_fd;           /**< line event file descriptor, -1 when closed */
+    uint32_t line;          /**< line offset on the chip */
+    uint32_t event_count;   /**< edges read since platform_gpio_irq_open() */
+    uint64_t last_timestamp_ns; /**< kernel timestamp of the last edge on PLATFORM_TIME_CLOCK */
+};
+
+/**
+ * @brief Request a GPIO line for edge events
+ * @param[out] irq         Session to initialize
+ * @param[in] chip_path    gpio character device, e.g. "/dev/gpiochip0"
+ * @param[in] line         Line offset on the chip
+ * @param[in] edge_flags   GPIOEVENT_REQUEST_RISING_EDGE and/or GPIOEVENT_REQUEST_FALLING_EDGE
+ * @return 0 on success, negative value on error
+ */
+int platform_gpio_irq_open(struct platform_gpio_irq *irq, const char *chip_path, uint32_t line, uint32_t edge_flags);
+
+/**
+ * @brief Release the line and close the chip
+ */
+void platform_gpio_irq_close(struct platform_gpio_irq *irq);
+
+/**
+ * @brief Wait for the next edge
+ * @param[in] irq            Open session
+ * @param[in] timeout_ms     Maximum wait, negative waits forever, 0 only checks for a queued edge
+ * @param[out] timestamp_us  Kernel timestamp of the edge in microseconds, may be NULL.
+ *                           Taken on CLOCK_MONOTONIC (kernels >= 5.7) or CLOCK_REALTIME (before) in the
+ *                           interrupt handler, returned on the inv_ixm42xxx_get_time_us() base, see
+ *                           platform_time_convert_ns(); the nanosecond value is kept in last_timestamp_ns.
+ * @return 1 when an edge was read, 0 on timeout, negative value on error
+ */
+int platform_gpio_irq_wait(struct platform_gpio_irq *irq, int timeout_ms, uint64_t *timestamp_us);
+
+/** Most lines platform_gpio_irq_wait_any() can wait on */
+#define PLATFORM_GPIO_IRQ_MAX_WAIT  8
+
+/**
+ * @brief Wait for the next edge on any of several lines
+ *
+ * One edge is read per call, from the first ready line in array order; edges
+ * pending on other lines are returned by the following calls without waiting.
+ * @param[in] irqs           Open sessions
+ * @param[in] count          Number of sessions, at most PLATFORM_GPIO_IRQ_MAX_WAIT
+ * @param[in] timeout_ms     Maximum wait, negative waits forever, 0 only checks for a queued edge
+ * @param[out] index         Position in irqs of the line the edge was read from
+ * @param[out] timestamp_us  Kernel timestamp of the edge in microseconds, may be NULL, same base as platform_gpio_irq_wait()
+ * @return 1 when an edge was read, 0 on timeout, negative value on error
+ */
+int platform_gpio_irq_wait_any(struct platform_gpio_irq *const *irqs, uint32_t count, int timeout_ms,
+                               uint32_t *index, uint64_t *timestamp_us);
+
 #ifdef __cplusplus
 }
 #endif
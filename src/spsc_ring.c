@@ -0,0 +1,63 @@
+#include "spsc_ring.h"
+#include <string.h>
+#include "InvError.h"
+
+int spsc_ring_init(struct spsc_ring *ring, void *storage, uint32_t elem_size, uint32_t capacity)
+{
+    if (!ring || !storage || elem_size == 0) return INV_ERROR_INVALID_PARAMETER;
+    // 下标按 mask 取模，容量必须是 2 的幂
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return INV_ERROR_INVALID_PARAMETER;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = (uint8_t *)storage;
+    ring->mask = capacity - 1;
+    ring->elem_size = elem_size;
+
+    return INV_ERROR_SUCCESS;
+}
+
+int spsc_ring_push(struct spsc_ring *ring, const void *elem)
+{
+    uint32_t head = ring->head;   // 只有生产者写 head，无需原子读
+
+    if (head - ring->tail_cache > ring->mask) {
+        // 看起来满了才去读消费者的 tail，避免每次都访问对方的 cache line
+        ring->tail_cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (head - ring->tail_cache > ring->mask) {
+            __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+            return INV_ERROR_SIZE;
+        }
+    }
+
+    memcpy(ring->slots + (head & ring->mask) * ring->elem_size, elem, ring->elem_size);
+    // release：元素拷贝完成后才对消费者可见
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return INV_ERROR_SUCCESS;
+}
+
+int spsc_ring_pop(struct spsc_ring *ring, void *elem)
+{
+    uint32_t tail = ring->tail;   // 只有消费者写 tail
+
+    if (tail == ring->head_cache) {
+        ring->head_cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (tail == ring->head_cache) return 0;
+    }
+
+    memcpy(elem, ring->slots + (tail & ring->mask) * ring->elem_size, ring->elem_size);
+    // release：拷贝出元素后才把槽位还给生产者
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return 1;
+}
+
+uint32_t spsc_ring_count(const struct spsc_ring *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+uint32_t spsc_ring_dropped(const struct spsc_ring *ring)
+{
+    return __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+}
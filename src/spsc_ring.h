@@ -0,0 +1,77 @@
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Cache line size of the target, head and tail never share a line */
+#define SPSC_RING_CACHE_LINE    64
+
+#define SPSC_RING_ALIGNED       __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring of fixed-size elements
+ *
+ * One thread calls spsc_ring_push(), one other thread calls spsc_ring_pop().
+ * Indexes are published with release stores and read with acquire loads
+ * (GCC __atomic builtins), so an element is fully copied before the other side
+ * can see it. Each side keeps a private copy of the other index and only reloads
+ * it when the ring looks full or empty, which keeps the shared cache lines from
+ * bouncing between cores on every element.
+ */
+struct spsc_ring {
+    /* Producer side */
+    uint32_t head SPSC_RING_ALIGNED;    /**< next slot to write, written by the producer only */
+    uint32_t tail_cache;                /**< producer copy of tail */
+    uint32_t dropped;                   /**< elements refused because the ring was full */
+
+    /* Consumer side */
+    uint32_t tail SPSC_RING_ALIGNED;    /**< next slot to read, written by the consumer only */
+    uint32_t head_cache;                /**< consumer copy of head */
+
+    /* Read-only after spsc_ring_init() */
+    uint8_t *slots SPSC_RING_ALIGNED;
+    uint32_t mask;                      /**< capacity - 1 */
+    uint32_t elem_size;
+};
+
+/**
+ * @brief Attach storage to an empty ring
+ * @param[out] ring       Ring to initialize
+ * @param[in] storage     capacity * elem_size bytes, owned by the caller
+ * @param[in] elem_size   Size of one element in bytes
+ * @param[in] capacity    Number of slots, must be a power of two
+ * @return 0 on success, negative value on error
+ */
+int spsc_ring_init(struct spsc_ring *ring, void *storage, uint32_t elem_size, uint32_t capacity);
+
+/**
+ * @brief Copy one element into the ring (producer thread only)
+ * @return 0 on success, INV_ERROR_SIZE when the ring is full (the element is dropped and counted)
+ */
+int spsc_ring_push(struct spsc_ring *ring, const void *elem);
+
+/**
+ * @brief Copy the oldest element out of the ring (consumer thread only)
+ * @return 1 when an element was read, 0 when the ring is empty
+ */
+int spsc_ring_pop(struct spsc_ring *ring, void *elem);
+
+/**
+ * @brief Number of elements waiting, exact from the consumer side, a lower bound elsewhere
+ */
+uint32_t spsc_ring_count(const struct spsc_ring *ring);
+
+/**
+ * @brief Elements dropped on full ring since spsc_ring_init()
+ */
+uint32_t spsc_ring_dropped(const struct spsc_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef _FIFO_GOLDEN_H_
+#define _FIFO_GOLDEN_H_
+
+/*
+ * Golden FIFO dumps: 13 packets holding accel, gyro, temperature and timestamp, in 16-byte
+ * and 20-byte (high resolution) format, big- and little-endian. The count is not a multiple
+ * of 4 so that the NEON decoder also runs its scalar tail. Axes go through the signed 16-bit
+ * edges (0x7FFF, 0x8000, 0xFFFF...), high resolution bytes through every nibble pattern.
+ *
+ * Expected values were computed from the datasheet packet layout, independently of the driver.
+ */
+
+#include <stdint.h>
+
+#define FIFO_GOLDEN_PACKETS 13
+
+static const uint8_t fifo_golden_16b_be[] = {
+    0x68, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x00, 0x00, 0x00,
+    0x68, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x7F, 0xFF, 0xFF,
+    0x68, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0x80, 0x80, 0x00,
+    0x68, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0xFF, 0x7F, 0xFF,
+    0x68, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0x01, 0x00, 0x10,
+    0x68, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0xFE, 0x00, 0x20,
+    0x68, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x19, 0xFF, 0xF0,
+    0x68, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0xE7, 0x00, 0x01,
+    0x68, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x40, 0xAB, 0xCD,
+    0x68, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0xC0, 0x43, 0x21,
+    0x68, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x7E, 0x00, 0xFF,
+    0x68, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x81, 0xFF, 0x00,
+    0x68, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x20, 0x10, 0x00,
+};
+
+static const uint8_t fifo_golden_16b_le[] = {
+    0x68, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x00, 0x00, 0x00,
+    0x68, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x7F, 0xFF, 0xFF,
+    0x68, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0x80, 0x00, 0x80,
+    0x68, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0xFF, 0x7F,
+    0x68, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x01, 0x10, 0x00,
+    0x68, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0xFE, 0x20, 0x00,
+    0x68, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x19, 0xF0, 0xFF,
+    0x68, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0xE7, 0x01, 0x00,
+    0x68, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x40, 0xCD, 0xAB,
+    0x68, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0xC0, 0x21, 0x43,
+    0x68, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x7E, 0xFF, 0x00,
+    0x68, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0x81, 0x00, 0xFF,
+    0x68, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x20, 0x00, 0x10,
+};
+
+static const uint8_t fifo_golden_20b_be[] = {
+    0x78, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x00, 0x00, 0x00, 0x00, 0x87, 0x5A,
+    0x78, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x80, 0x01, 0xFF, 0xFF, 0xFF, 0x78, 0xA5,
+    0x78, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFF, 0x80, 0x00, 0x0F, 0x11, 0x01,
+    0x78, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0xFF, 0xFE, 0x7F, 0xFF, 0xF0, 0xEE, 0x80,
+    0x78, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0x00, 0xFF, 0x00, 0x10, 0x87, 0x5A, 0x3C,
+    0x78, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0xFF, 0x00, 0x00, 0x20, 0x78, 0xA5, 0x00,
+    0x78, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x12, 0x34, 0xFF, 0xF0, 0x11, 0x01, 0xFF,
+    0x78, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0xED, 0xCB, 0x00, 0x01, 0xEE, 0x80, 0x0F,
+    0x78, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x7F, 0x80, 0xAB, 0xCD, 0x5A, 0x3C, 0xF0,
+    0x78, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x80, 0x7F, 0x43, 0x21, 0xA5, 0x00, 0x87,
+    0x78, 0xED, 0xCB, 0x7F, 0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x00, 0x00, 0xFF, 0x01, 0xFF, 0x78,
+    0x78, 0x7F, 0x80, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xED, 0xCB, 0x00, 0x01, 0xFF, 0x00, 0x80, 0x0F, 0x11,
+    0x78, 0x80, 0x7F, 0x80, 0x01, 0x12, 0x34, 0x00, 0x01, 0xFF, 0xFE, 0x7F, 0x80, 0x7F, 0xFF, 0x10, 0x00, 0x3C, 0xF0, 0xEE,
+};
+
+static const uint8_t fifo_golden_20b_le[] = {
+    0x78, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x00, 0x80, 0x00, 0x00, 0x00, 0x87, 0x5A,
+    0x78, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0x01, 0x80, 0xFF, 0xFF, 0xFF, 0x78, 0xA5,
+    0x78, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFF, 0xFF, 0x00, 0x80, 0x0F, 0x11, 0x01,
+    0x78, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFE, 0xFF, 0xFF, 0x7F, 0xF0, 0xEE, 0x80,
+    0x78, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0xFF, 0x00, 0x10, 0x00, 0x87, 0x5A, 0x3C,
+    0x78, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x00, 0xFF, 0x20, 0x00, 0x78, 0xA5, 0x00,
+    0x78, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x34, 0x12, 0xF0, 0xFF, 0x11, 0x01, 0xFF,
+    0x78, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0xCB, 0xED, 0x01, 0x00, 0xEE, 0x80, 0x0F,
+    0x78, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x80, 0x7F, 0xCD, 0xAB, 0x5A, 0x3C, 0xF0,
+    0x78, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x7F, 0x80, 0x21, 0x43, 0xA5, 0x00, 0x87,
+    0x78, 0xCB, 0xED, 0xFF, 0x7F, 0xFF, 0x00, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x00, 0x00, 0xFF, 0x00, 0x01, 0xFF, 0x78,
+    0x78, 0x80, 0x7F, 0x00, 0x80, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xCB, 0xED, 0x01, 0x00, 0x00, 0xFF, 0x80, 0x0F, 0x11,
+    0x78, 0x7F, 0x80, 0x01, 0x80, 0x34, 0x12, 0x01, 0x00, 0xFE, 0xFF, 0x80, 0x7F, 0xFF, 0x7F, 0x00, 0x10, 0x3C, 0xF0, 0xEE,
+};
+
+static const int32_t fifo_golden_16b_accel_x[] = {
+    0, 1, 32767, -32768, -32767, -1, -2, 255, -256, 4660, -4661, 32640, -32641,
+};
+
+static const int32_t fifo_golden_16b_accel_y[] = {
+    -1, -2, 255, -256, 4660, -4661, 32640, -32641, 0, 1, 32767, -32768, -32767,
+};
+
+static const int32_t fifo_golden_16b_accel_z[] = {
+    -4661, 32640, -32641, 0, 1, 32767, -32768, -32767, -1, -2, 255, -256, 4660,
+};
+
+static const int32_t fifo_golden_16b_gyro_x[] = {
+    32767, -32768, -32767, -1, -2, 255, -256, 4660, -4661, 32640, -32641, 0, 1,
+};
+
+static const int32_t fifo_golden_16b_gyro_y[] = {
+    255, -256, 4660, -4661, 32640, -32641, 0, 1, 32767, -32768, -32767, -1, -2,
+};
+
+static const int32_t fifo_golden_16b_gyro_z[] = {
+    -32641, 0, 1, 32767, -32768, -32767, -1, -2, 255, -256, 4660, -4661, 32640,
+};
+
+static const int16_t fifo_golden_16b_temperature[] = {
+    0, 127, -128, -1, 1, -2, 25, -25, 64, -64, 126, -127, 32,
+};
+
+static const uint16_t fifo_golden_16b_timestamp[] = {
+    0x0000, 0xFFFF, 0x8000, 0x7FFF, 0x0010, 0x0020, 0xFFF0, 0x0001, 0xABCD, 0x4321, 0x00FF, 0xFF00, 0x1000,
+};
+
+static const int32_t fifo_golden_20b_accel_x[] = {
+    0, 31, 524272, -524273, -524264, -9, -31, 4094, -4091, 74570, -74576, 522248, -522253,
+};
+
+static const int32_t fifo_golden_20b_accel_y[] = {
+    -8, -25, 4081, -4082, 74565, -74566, 522240, -522248, 3, 16, 524287, -524288, -524257,
+};
+
+static const int32_t fifo_golden_20b_accel_z[] = {
+    -74571, 522250, -522256, 8, 19, 524272, -524273, -524272, -1, -24, 4087, -4095, 74574,
+};
+
+static const int32_t fifo_golden_20b_gyro_x[] = {
+    524272, -524273, -524257, -16, -25, 4088, -4095, 74574, -74566, 522245, -522255, 0, 28,
+};
+
+static const int32_t fifo_golden_20b_gyro_y[] = {
+    4087, -4088, 74561, -74562, 522250, -522251, 1, 16, 524284, -524288, -524257, -1, -32,
+};
+
+static const int32_t fifo_golden_20b_gyro_z[] = {
+    -522246, 5, 17, 524272, -524276, -524272, -1, -17, 4080, -4089, 74568, -74575, 522254,
+};
+
+static const int16_t fifo_golden_20b_temperature[] = {
+    -32768, -32767, -1, -2, 255, -256, 4660, -4661, 32640, -32641, 0, 1, 32767,
+};
+
+static const uint16_t fifo_golden_20b_timestamp[] = {
+    0x0000, 0xFFFF, 0x8000, 0x7FFF, 0x0010, 0x0020, 0xFFF0, 0x0001, 0xABCD, 0x4321, 0x00FF, 0xFF00, 0x1000,
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Ixm42xxxDefs.h"
+#include "Ixm42xxxFifoDecode.h"
+#include "fifo_golden.h"
+
+// 输出数组多留一个元素，检查解码没有写过 packet_count
+#define OUT_SIZE        (FIFO_GOLDEN_PACKETS + 1)
+#define SENTINEL_BYTE   0x5A
+
+struct golden_set {
+    const char *name;
+    const uint8_t *fifo;
+    uint8_t packet_size;
+    uint8_t endian;
+    const int32_t *accel[3], *gyro[3];
+    const int16_t *temperature;
+    const uint16_t *timestamp;
+};
+
+static const struct golden_set sets[] = {
+    { "16b-be", fifo_golden_16b_be, FIFO_16BYTES_PACKET_SIZE, IXM42XXX_INTF_CONFIG0_DATA_BIG_ENDIAN,
+      { fifo_golden_16b_accel_x, fifo_golden_16b_accel_y, fifo_golden_16b_accel_z },
+      { fifo_golden_16b_gyro_x, fifo_golden_16b_gyro_y, fifo_golden_16b_gyro_z },
+      fifo_golden_16b_temperature, fifo_golden_16b_timestamp },
+    { "16b-le", fifo_golden_16b_le, FIFO_16BYTES_PACKET_SIZE, IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN,
+      { fifo_golden_16b_accel_x, fifo_golden_16b_accel_y, fifo_golden_16b_accel_z },
+      { fifo_golden_16b_gyro_x, fifo_golden_16b_gyro_y, fifo_golden_16b_gyro_z },
+      fifo_golden_16b_temperature, fifo_golden_16b_timestamp },
+    { "20b-be", fifo_golden_20b_be, FIFO_20BYTES_PACKET_SIZE, IXM42XXX_INTF_CONFIG0_DATA_BIG_ENDIAN,
+      { fifo_golden_20b_accel_x, fifo_golden_20b_accel_y, fifo_golden_20b_accel_z },
+      { fifo_golden_20b_gyro_x, fifo_golden_20b_gyro_y, fifo_golden_20b_gyro_z },
+      fifo_golden_20b_temperature, fifo_golden_20b_timestamp },
+    { "20b-le", fifo_golden_20b_le, FIFO_20BYTES_PACKET_SIZE, IXM42XXX_INTF_CONFIG0_DATA_LITTLE_ENDIAN,
+      { fifo_golden_20b_accel_x, fifo_golden_20b_accel_y, fifo_golden_20b_accel_z },
+      { fifo_golden_20b_gyro_x, fifo_golden_20b_gyro_y, fifo_golden_20b_gyro_z },
+      fifo_golden_20b_temperature, fifo_golden_20b_timestamp },
+};
+
+struct decoded {
+    int32_t accel[3][OUT_SIZE], gyro[3][OUT_SIZE];
+    int16_t temperature[OUT_SIZE];
+    uint16_t timestamp[OUT_SIZE];
+    inv_ixm42xxx_fifo_batch_t batch;
+};
+
+static void decoded_init(struct decoded *d)
+{
+    int k;
+
+    memset(d, SENTINEL_BYTE, sizeof(*d));
+    for (k = 0; k < 3; k++) {
+        d->batch.accel[k] = d->accel[k];
+        d->batch.gyro[k] = d->gyro[k];
+    }
+    d->batch.temperature = d->temperature;
+    d->batch.timestamp_fsync = d->timestamp;
+    d->batch.sensor_mask = NULL;
+    d->batch.capacity = OUT_SIZE;
+    d->batch.count = 0;
+    d->batch.high_res = 0;
+}
+
+/* 两次解码逐字节相同，两边未写入的元素都保持哨兵值 */
+static int decoded_equal(const struct decoded *a, const struct decoded *b)
+{
+    int k;
+
+    for (k = 0; k < 3; k++) {
+        if (memcmp(a->accel[k], b->accel[k], sizeof(a->accel[k])) ||
+            memcmp(a->gyro[k], b->gyro[k], sizeof(a->gyro[k])))
+            return 0;
+    }
+    return !memcmp(a->temperature, b->temperature, sizeof(a->temperature)) &&
+           !memcmp(a->timestamp, b->timestamp, sizeof(a->timestamp));
+}
+
+static int decoded_untouched_from(const struct decoded *d, uint16_t count)
+{
+    const uint8_t *p;
+    size_t i;
+    int k;
+
+    for (k = 0; k < 3; k++) {
+        p = (const uint8_t *)&d->accel[k][count];
+        for (i = 0; i < (OUT_SIZE - count) * sizeof(int32_t); i++)
+            if (p[i] != SENTINEL_BYTE) return 0;
+        p = (const uint8_t *)&d->gyro[k][count];
+        for (i = 0; i < (OUT_SIZE - count) * sizeof(int32_t); i++)
+            if (p[i] != SENTINEL_BYTE) return 0;
+    }
+    p = (const uint8_t *)&d->temperature[count];
+    for (i = 0; i < (OUT_SIZE - count) * sizeof(int16_t); i++)
+        if (p[i] != SENTINEL_BYTE) return 0;
+    p = (const uint8_t *)&d->timestamp[count];
+    for (i = 0; i < (OUT_SIZE - count) * sizeof(uint16_t); i++)
+        if (p[i] != SENTINEL_BYTE) return 0;
+    return 1;
+}
+
+/* 参考实现与按数据手册独立计算的期望值比较 */
+static int decoded_matches_golden(const struct decoded *d, const struct golden_set *set, uint16_t count)
+{
+    int k;
+
+    for (k = 0; k < 3; k++) {
+        if (memcmp(d->accel[k], set->accel[k], count * sizeof(int32_t)) ||
+            memcmp(d->gyro[k], set->gyro[k], count * sizeof(int32_t)))
+            return 0;
+    }
+    return !memcmp(d->temperature, set->temperature, count * sizeof(int16_t)) &&
+           !memcmp(d->timestamp, set->timestamp, count * sizeof(uint16_t));
+}
+
+static int run_set(const struct golden_set *set)
+{
+    static struct decoded ref, fast;
+    uint16_t count;
+    int failures = 0;
+
+    // 每个包数都跑一遍，覆盖 4 包一组的向量路径与标量尾部的所有组合
+    for (count = 0; count <= FIFO_GOLDEN_PACKETS; count++) {
+        decoded_init(&ref);
+        decoded_init(&fast);
+        inv_ixm42xxx_decode_fifo_samples_ref(set->fifo, count, set->packet_size, set->endian, &ref.batch);
+        inv_ixm42xxx_decode_fifo_samples(set->fifo, count, set->packet_size, set->endian, &fast.batch);
+
+        if (!decoded_matches_golden(&ref, set, count)) {
+            printf("%-8s %2u packets: reference decoder differs from the golden values\n", set->name, count);
+            failures++;
+        }
+        if (!decoded_equal(&ref, &fast)) {
+            printf("%-8s %2u packets: decoder differs from the reference decoder\n", set->name, count);
+            failures++;
+        }
+        if (!decoded_untouched_from(&fast, count) || !decoded_untouched_from(&ref, count)) {
+            printf("%-8s %2u packets: output written past the last packet\n", set->name, count);
+            failures++;
+        }
+    }
+
+    printf("%-8s %u packet counts, %d failures\n", set->name, FIFO_GOLDEN_PACKETS + 1, failures);
+    return failures;
+}
+
+int main(void)
+{
+    unsigned i;
+    int failed = 0;
+
+    printf("FIFO decoder: %s\n", INV_IXM42XXX_FIFO_DECODE_NEON ? "NEON" : "scalar reference only");
+    for (i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+        if (run_set(&sets[i]))
+            failed++;
+    }
+
+    printf("%s: %d of %u golden dumps failed\n", failed ? "FAIL" : "PASS", failed, i);
+    return failed ? 1 : 0;
+}
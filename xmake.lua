@@ -37,6 +37,7 @@ target("IIM42652")
     set_plat("linux")       -- RV1126 运行 Linux 系统
     set_arch("arm")         -- ARM32 架构
     set_toolchains("rv1126_lubancat")-- 关联上面定义的 poky 工具链
+    add_syslinks("pthread", "m")  -- 采集线程（acquisition.c）、helperClockCalib.c 的 sqrt
 
 -- target("spi_detector")
 --     set_kind("binary")
@@ -72,3 +73,53 @@ after_build(function (target)
         cprint("${red}Error: Executable file %s not found!", exe_name)
     end
 end)
+
+-- ==============================================
+-- 主机端寄存器级仿真：驱动 + 软件 IIM42652 模型，无需开发板
+-- xmake build IIM42652_sim && xmake run IIM42652_sim
+-- ==============================================
+target("IIM42652_sim")
+    set_kind("binary")
+    set_default(false)
+    add_files("sim/*.c", "public.mcu.iim42652/Ixm42xxx/*.c")
+    add_includedirs("public.mcu.iim42652/Ixm42xxx", "sim")
+    add_defines("ICM42652")
+    add_syslinks("m")
+target_end()
+
+-- ==============================================
+-- FIFO 读取路径基准测试：总线 / 解析 / 回调分段耗时，输出 CSV 或 JSON
+-- xmake build bench && xmake run bench -f json -o bench.json
+-- ==============================================
+target("bench")
+    set_kind("binary")
+    set_default(false)
+    set_optimize("fastest")
+    add_files("bench/*.c", "sim/iim42652_sim.c", "sim/sim_platform.c", "public.mcu.iim42652/Ixm42xxx/*.c")
+    add_includedirs("public.mcu.iim42652/Ixm42xxx", "sim")
+    add_defines("ICM42652")
+    add_syslinks("m")
+target_end()
+
+-- ==============================================
+-- FIFO 解码器黄金数据测试：NEON 与参考解码器逐字节比较
+-- 主机版只覆盖参考解码器，NEON 版用 RV1126 工具链构建后在开发板或 qemu-arm 上运行
+-- ==============================================
+target("fifo_decode_test")
+    set_kind("binary")
+    set_default(false)
+    add_files("test/fifo_decode/*.c", "public.mcu.iim42652/Ixm42xxx/Ixm42xxxFifoDecode.c")
+    add_includedirs("public.mcu.iim42652/Ixm42xxx", "test/fifo_decode")
+    add_defines("ICM42652")
+target_end()
+
+target("fifo_decode_test_rv1126")
+    set_kind("binary")
+    set_default(false)
+    add_files("test/fifo_decode/*.c", "public.mcu.iim42652/Ixm42xxx/Ixm42xxxFifoDecode.c")
+    add_includedirs("public.mcu.iim42652/Ixm42xxx", "test/fifo_decode")
+    add_defines("ICM42652")
+    set_plat("linux")
+    set_arch("arm")
+    set_toolchains("rv1126_lubancat")
+target_end()